@@ -0,0 +1,242 @@
+/*!
+ * @file   ProducerSimulator.cpp
+ *
+ * @brief  This class simulates a variTRON producer. It creates a shared memory segment and its semaphore like the
+ *         producer does and writes the buffer with a fixed rate using the protocol of the buffer type.
+ *
+ */
+
+#include "ProducerSimulator.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/fcntl.h>
+
+#include <ck_sequence.h>
+
+namespace
+{
+    // the layouts of the management buffers, see SharedMemorySegment.cpp
+    enum class ActiveBuffer
+    {
+        buffer1,
+        buffer2
+    };
+
+    struct ManagementBuffer
+    {
+        ActiveBuffer activeReadBuffer;
+        ActiveBuffer activeWriteBuffer;
+        ck_sequence_t seqlock;
+    };
+
+    struct SequenceLockManagementBuffer
+    {
+        ck_sequence_t seqlock;
+    };
+
+    size_t getSizeOfManagementBuffer(SharedMemorySegment::BufferType bufferType)
+    {
+        switch (bufferType)
+        {
+        case SharedMemorySegment::BufferType::singleBufferSequenceLock:
+            return sizeof(SequenceLockManagementBuffer);
+        case SharedMemorySegment::BufferType::doubleBuffer:
+            return sizeof(ManagementBuffer);
+        default:
+            return 0;
+        }
+    }
+}
+
+ProducerSimulator::ProducerSimulator(const Configuration &configuration)
+    : m_configuration(configuration),
+      m_size(0),
+      m_sizeOfManagementBuffer(getSizeOfManagementBuffer(configuration.bufferType)),
+      m_buffer(nullptr),
+      m_running(false),
+      m_writes(0)
+{
+    const bool isDoubleBuffer = m_configuration.bufferType == SharedMemorySegment::BufferType::doubleBuffer;
+    m_size = m_sizeOfManagementBuffer + m_configuration.sizeOfSingleBuffer * (isDoubleBuffer ? 2 : 1);
+
+    int shmFileDescriptor = shm_open(m_configuration.name.c_str(), O_CREAT | O_RDWR, 0666);
+    if (shmFileDescriptor < 0)
+    {
+        throw std::runtime_error("Could not create the shared memory segment: " + std::string(strerror(errno)));
+    }
+    if (ftruncate(shmFileDescriptor, m_size) != 0)
+    {
+        const int error = errno;
+        close(shmFileDescriptor);
+        shm_unlink(m_configuration.name.c_str());
+        throw std::runtime_error("Could not resize the shared memory segment: " + std::string(strerror(error)));
+    }
+
+    void *pData = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFileDescriptor, 0);
+    close(shmFileDescriptor);
+    if (pData == MAP_FAILED)
+    {
+        const int error = errno;
+        shm_unlink(m_configuration.name.c_str());
+        throw std::runtime_error("Could not map the shared memory segment: " + std::string(strerror(error)));
+    }
+    m_buffer = static_cast<char *>(pData);
+    memset(m_buffer, 0, m_size);
+
+    if (isDoubleBuffer)
+    {
+        auto *pManagementBuffer = reinterpret_cast<ManagementBuffer *>(m_buffer);
+        pManagementBuffer->activeReadBuffer = ActiveBuffer::buffer1;
+        pManagementBuffer->activeWriteBuffer = ActiveBuffer::buffer2;
+    }
+
+    // the semaphore is created unlocked and removed with the simulator
+    m_semaphore = std::make_unique<SystemVSemaphore>(m_configuration.semaphoreKey, SystemVSemaphoreBaseClass::CreationType::newLock);
+    if (!m_semaphore->isValid())
+    {
+        m_semaphore.reset();
+        munmap(m_buffer, m_size);
+        shm_unlink(m_configuration.name.c_str());
+        throw std::runtime_error("Could not create the semaphore " + m_configuration.semaphoreKey + ", it may be left over by a crashed run (see ipcs -s)");
+    }
+}
+
+ProducerSimulator::~ProducerSimulator()
+{
+    stop();
+    m_semaphore.reset();
+    munmap(m_buffer, m_size);
+    shm_unlink(m_configuration.name.c_str());
+}
+
+void ProducerSimulator::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+    m_thread = std::thread(&ProducerSimulator::run, this);
+}
+
+void ProducerSimulator::stop()
+{
+    m_running = false;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+const ProducerSimulator::Configuration &ProducerSimulator::getConfiguration() const
+{
+    return m_configuration;
+}
+
+size_t ProducerSimulator::getSize() const
+{
+    return m_size;
+}
+
+uint64_t ProducerSimulator::getWrites() const
+{
+    return m_writes.load(std::memory_order_relaxed);
+}
+
+bool ProducerSimulator::isConsistent(const char *pData, size_t length)
+{
+    uint64_t first;
+    if (length < sizeof(first))
+    {
+        return true;
+    }
+    memcpy(&first, pData, sizeof(first));
+
+    for (size_t offset = sizeof(first); offset + sizeof(first) <= length; offset += sizeof(first))
+    {
+        uint64_t word;
+        memcpy(&word, pData + offset, sizeof(word));
+        if (word != first)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ProducerSimulator::run()
+{
+    using Clock = std::chrono::steady_clock;
+
+    // absolute deadlines, so the time of a write doesn't lower the rate
+    const bool isPaced = m_configuration.writeRateHz > 0;
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(isPaced ? 1.0 / m_configuration.writeRateHz : 0.0));
+    auto deadline = Clock::now();
+
+    for (uint64_t word = 1; m_running.load(std::memory_order_relaxed); word++)
+    {
+        writeBuffer(word);
+        m_writes.fetch_add(1, std::memory_order_relaxed);
+
+        if (isPaced)
+        {
+            deadline += period;
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+}
+
+void ProducerSimulator::writeBuffer(uint64_t word)
+{
+    switch (m_configuration.bufferType)
+    {
+    case SharedMemorySegment::BufferType::singleBufferSemaphore:
+        // readers and writers of the addon lock the same semaphore
+        m_semaphore->lock();
+        fill(0, word);
+        m_semaphore->unlock();
+        break;
+    case SharedMemorySegment::BufferType::singleBufferSequenceLock:
+    {
+        // the semaphore excludes the writers of the addon, the sequence number lets the readers detect a torn copy
+        auto *pManagementBuffer = reinterpret_cast<SequenceLockManagementBuffer *>(m_buffer);
+        m_semaphore->lock();
+        ck_sequence_write_begin(&pManagementBuffer->seqlock);
+        fill(m_sizeOfManagementBuffer, word);
+        ck_sequence_write_end(&pManagementBuffer->seqlock);
+        m_semaphore->unlock();
+        break;
+    }
+    case SharedMemorySegment::BufferType::doubleBuffer:
+    {
+        // the inactive half is written without the sequence lock, only the switch of the halves is inside of it
+        auto *pManagementBuffer = reinterpret_cast<ManagementBuffer *>(m_buffer);
+        const ActiveBuffer writeBuffer = pManagementBuffer->activeWriteBuffer;
+        m_semaphore->lock();
+        fill(m_sizeOfManagementBuffer + (writeBuffer == ActiveBuffer::buffer2 ? m_configuration.sizeOfSingleBuffer : 0), word);
+        ck_sequence_write_begin(&pManagementBuffer->seqlock);
+        pManagementBuffer->activeWriteBuffer = pManagementBuffer->activeReadBuffer;
+        pManagementBuffer->activeReadBuffer = writeBuffer;
+        ck_sequence_write_end(&pManagementBuffer->seqlock);
+        m_semaphore->unlock();
+        break;
+    }
+    }
+}
+
+void ProducerSimulator::fill(size_t offset, uint64_t word)
+{
+    char *pBuffer = m_buffer + offset;
+    size_t i = 0;
+    for (; i + sizeof(word) <= m_configuration.sizeOfSingleBuffer; i += sizeof(word))
+    {
+        memcpy(pBuffer + i, &word, sizeof(word));
+    }
+    memcpy(pBuffer + i, &word, m_configuration.sizeOfSingleBuffer - i);
+}
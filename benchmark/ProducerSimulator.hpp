@@ -0,0 +1,93 @@
+/*!
+ * @file   ProducerSimulator.hpp
+ *
+ * @brief  This class simulates a variTRON producer. It creates a shared memory segment and its semaphore like the
+ *         producer does and writes the buffer with a fixed rate using the protocol of the buffer type.
+ *
+ */
+
+#pragma once
+
+#include "SharedMemorySegment.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+class ProducerSimulator
+{
+public:
+    struct Configuration
+    {
+        // the name of the POSIX shared memory, e.g. /benchmark
+        std::string name;
+        // the key string of the System V semaphore
+        std::string semaphoreKey;
+        SharedMemorySegment::BufferType bufferType;
+        size_t sizeOfSingleBuffer;
+        // the number of writes per second, 0 writes without a pause
+        double writeRateHz;
+    };
+
+    /**
+     * Create the shared memory segment and the semaphore
+     *
+     * @param configuration the configuration of the producer
+     * @throws std::runtime_error if the segment or the semaphore can't be created
+     */
+    explicit ProducerSimulator(const Configuration &configuration);
+    ProducerSimulator(const ProducerSimulator &other) = delete;
+
+    /**
+     * Stop the producer and remove the segment and the semaphore
+     */
+    ~ProducerSimulator();
+
+    ProducerSimulator &operator=(const ProducerSimulator &other) = delete;
+
+    void start();
+    void stop();
+
+    const Configuration &getConfiguration() const;
+
+    /**
+     * Get the size of the segment including the management buffer and both halves of a double buffer
+     *
+     * @return the size of the segment
+     */
+    size_t getSize() const;
+
+    /**
+     * Get the number of writes of the buffer since the start
+     *
+     * @return the number of writes
+     */
+    uint64_t getWrites() const;
+
+    /**
+     * Check if a copy of the current buffer is consistent. Every write fills the buffer with the same 64 bit word,
+     * so a copy that contains different words has been torn by a write.
+     *
+     * @param pData the copy of the current buffer or a part of it that starts at the beginning of the buffer
+     * @param length the length of the copy
+     * @return true if all words of the copy are the same
+     */
+    static bool isConsistent(const char *pData, size_t length);
+
+private:
+    void run();
+    void writeBuffer(uint64_t word);
+    void fill(size_t offset, uint64_t word);
+
+    Configuration m_configuration;
+    size_t m_size;
+    size_t m_sizeOfManagementBuffer;
+    char *m_buffer;
+    std::unique_ptr<SystemVSemaphore> m_semaphore;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_writes;
+};
@@ -0,0 +1,314 @@
+/*!
+ * @file   benchmark.cpp
+ *
+ * @brief  Benchmark of the native read and write paths against a simulated producer. It measures the latency
+ *         percentiles and the throughput of consistent reads, writes and bit writes for every buffer type and counts
+ *         the retries of the sequence lock under contention.
+ *
+ *         usage: benchmark [--buffer-type all|singleBufferSemaphore|singleBufferSequenceLock|doubleBuffer]
+ *                          [--size bytes] [--rate Hz] [--duration s] [--readers n] [--serve s]
+ *
+ *         --serve only runs the producer for the given time and prints the parameters to attach to it, e.g. for
+ *         example/benchmark-shared-memory.js.
+ */
+
+#include "ProducerSimulator.hpp"
+#include "SharedMemorySegment.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+#include <unistd.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::vector<SharedMemorySegment::BufferType> bufferTypes;
+        size_t size = 4096;
+        double rateHz = 1000;
+        double durationS = 2;
+        unsigned int readers = 1;
+        double serveS = 0;
+    };
+
+    // the latencies of one operation in ns and the number of operations that failed
+    struct Measurement
+    {
+        std::vector<uint64_t> latenciesNs;
+        uint64_t failures = 0;
+        uint64_t tornReads = 0;
+        double durationS = 0;
+    };
+
+    const char *getBufferTypeName(SharedMemorySegment::BufferType bufferType)
+    {
+        switch (bufferType)
+        {
+        case SharedMemorySegment::BufferType::singleBufferSemaphore:
+            return "singleBufferSemaphore";
+        case SharedMemorySegment::BufferType::singleBufferSequenceLock:
+            return "singleBufferSequenceLock";
+        default:
+            return "doubleBuffer";
+        }
+    }
+
+    std::vector<SharedMemorySegment::BufferType> parseBufferTypes(const std::string &name)
+    {
+        const std::vector<SharedMemorySegment::BufferType> all = {SharedMemorySegment::BufferType::singleBufferSemaphore,
+                                                                  SharedMemorySegment::BufferType::singleBufferSequenceLock,
+                                                                  SharedMemorySegment::BufferType::doubleBuffer};
+        if (name == "all")
+        {
+            return all;
+        }
+        for (auto bufferType : all)
+        {
+            if (name == getBufferTypeName(bufferType))
+            {
+                return {bufferType};
+            }
+        }
+        throw std::invalid_argument("unknown buffer type " + name);
+    }
+
+    Options parseOptions(int argc, char *argv[])
+    {
+        static const struct option longOptions[] = {
+            {"buffer-type", required_argument, nullptr, 't'},
+            {"size", required_argument, nullptr, 's'},
+            {"rate", required_argument, nullptr, 'r'},
+            {"duration", required_argument, nullptr, 'd'},
+            {"readers", required_argument, nullptr, 'n'},
+            {"serve", required_argument, nullptr, 'S'},
+            {nullptr, 0, nullptr, 0},
+        };
+
+        Options options;
+        options.bufferTypes = parseBufferTypes("all");
+
+        int option;
+        while ((option = getopt_long(argc, argv, "t:s:r:d:n:S:", longOptions, nullptr)) != -1)
+        {
+            switch (option)
+            {
+            case 't':
+                options.bufferTypes = parseBufferTypes(optarg);
+                break;
+            case 's':
+                options.size = std::stoul(optarg);
+                break;
+            case 'r':
+                options.rateHz = std::stod(optarg);
+                break;
+            case 'd':
+                options.durationS = std::stod(optarg);
+                break;
+            case 'n':
+                options.readers = std::max(1UL, std::stoul(optarg));
+                break;
+            case 'S':
+                options.serveS = std::stod(optarg);
+                break;
+            default:
+                throw std::invalid_argument("unknown option");
+            }
+        }
+
+        if (options.size < sizeof(uint64_t))
+        {
+            throw std::invalid_argument("the size must be at least 8 bytes");
+        }
+        return options;
+    }
+
+    ProducerSimulator::Configuration createConfiguration(const Options &options, SharedMemorySegment::BufferType bufferType)
+    {
+        // the names follow the ones of the producers, the process id keeps parallel runs apart
+        const std::string key = "benchmark" + std::to_string(getpid()) + getBufferTypeName(bufferType);
+        const bool isDoubleBuffer = bufferType == SharedMemorySegment::BufferType::doubleBuffer;
+        return {"/" + key, key + "Semaphore" + (isDoubleBuffer ? "WriteLock" : "BufferLock"), bufferType, options.size, options.rateHz};
+    }
+
+    /**
+     * Call an operation until the duration has passed and measure the latency of every call
+     */
+    template <typename Operation>
+    void measure(double durationS, Measurement &measurement, Operation operation)
+    {
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(durationS));
+
+        auto now = start;
+        while (now < end)
+        {
+            const auto before = now;
+            if (!operation())
+            {
+                measurement.failures++;
+            }
+            now = Clock::now();
+            measurement.latenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - before).count());
+        }
+        measurement.durationS = std::chrono::duration<double>(now - start).count();
+    }
+
+    Measurement measureReads(SharedMemorySegment &segment, const Options &options)
+    {
+        std::vector<Measurement> measurements(options.readers);
+        std::vector<std::thread> readers;
+        for (auto &measurement : measurements)
+        {
+            readers.emplace_back([&segment, &options, &measurement]()
+                                 {
+                                     // like readBuffer or readRange of the addon
+                                     std::vector<char> destination(options.size);
+                                     measure(options.durationS, measurement, [&]()
+                                             {
+                                                 const bool read = segment.copyConsistent(destination.data(), 0, destination.size(), true);
+                                                 if (read && !ProducerSimulator::isConsistent(destination.data(), destination.size()))
+                                                 {
+                                                     measurement.tornReads++;
+                                                 }
+                                                 return read; }); });
+        }
+
+        Measurement result;
+        for (size_t i = 0; i < readers.size(); i++)
+        {
+            readers[i].join();
+            result.latenciesNs.insert(result.latenciesNs.end(), measurements[i].latenciesNs.begin(), measurements[i].latenciesNs.end());
+            result.failures += measurements[i].failures;
+            result.tornReads += measurements[i].tornReads;
+            result.durationS = std::max(result.durationS, measurements[i].durationS);
+        }
+        return result;
+    }
+
+    uint64_t getPercentile(const std::vector<uint64_t> &sortedLatenciesNs, double percentile)
+    {
+        const size_t index = static_cast<size_t>(percentile / 100 * (sortedLatenciesNs.size() - 1) + 0.5);
+        return sortedLatenciesNs[index];
+    }
+
+    void report(const char *name, Measurement &measurement)
+    {
+        if (measurement.latenciesNs.empty())
+        {
+            printf("  %-10s no operations\n", name);
+            return;
+        }
+        std::sort(measurement.latenciesNs.begin(), measurement.latenciesNs.end());
+        const auto &latencies = measurement.latenciesNs;
+
+        printf("  %-10s %10.0f ops/s  p50 %7.2f  p90 %7.2f  p99 %7.2f  p99.9 %8.2f  max %8.2f µs  failures %llu\n",
+               name, latencies.size() / measurement.durationS,
+               getPercentile(latencies, 50) / 1e3, getPercentile(latencies, 90) / 1e3, getPercentile(latencies, 99) / 1e3,
+               getPercentile(latencies, 99.9) / 1e3, latencies.back() / 1e3, static_cast<unsigned long long>(measurement.failures));
+    }
+
+    void benchmark(const Options &options, SharedMemorySegment::BufferType bufferType)
+    {
+        ProducerSimulator producer(createConfiguration(options, bufferType));
+        const auto &configuration = producer.getConfiguration();
+        SharedMemorySegment segment(configuration.name, producer.getSize(), bufferType, configuration.sizeOfSingleBuffer,
+                                    configuration.semaphoreKey, SystemVSemaphoreBaseClass::CreationType::attachToExistingLock);
+
+        printf("%s, %zu bytes, producer %g Hz, %u reader(s)\n", getBufferTypeName(bufferType), options.size, options.rateHz, options.readers);
+        producer.start();
+
+        Measurement reads = measureReads(segment, options);
+        report("read", reads);
+
+        const SharedMemorySegment::ReadStatistics readStatistics = segment.getReadStatistics();
+        if (bufferType != SharedMemorySegment::BufferType::singleBufferSemaphore)
+        {
+            printf("  %-10s %.4f retries per read, %llu timeouts, %llu torn reads\n", "seqlock",
+                   static_cast<double>(readStatistics.retries) / std::max<uint64_t>(1, readStatistics.reads),
+                   static_cast<unsigned long long>(readStatistics.timeouts), static_cast<unsigned long long>(reads.tornReads));
+        }
+        else
+        {
+            printf("  %-10s %llu torn reads\n", "semaphore", static_cast<unsigned long long>(reads.tornReads));
+        }
+
+        // like write and writeByte of the addon, the values are overwritten by the next write of the producer
+        const uint64_t word = 0;
+        Measurement writes;
+        measure(options.durationS, writes, [&]()
+                { return segment.write(segment.getSizeOfManagementBuffer(), reinterpret_cast<const char *>(&word), sizeof(word)); });
+        report("write", writes);
+
+        Measurement bitWrites;
+        measure(options.durationS, bitWrites, [&]()
+                { return segment.writeBits(segment.getSizeOfManagementBuffer(), 0x01, true); });
+        report("writeBits", bitWrites);
+
+        const SharedMemorySegment::LockStatistics lockStatistics = segment.getLockStatistics();
+        printf("  %-10s %llu locks, %llu contended, %llu timeouts, max wait %llu µs\n", "semaphore",
+               static_cast<unsigned long long>(lockStatistics.locks), static_cast<unsigned long long>(lockStatistics.contendedLocks),
+               static_cast<unsigned long long>(lockStatistics.timeouts), static_cast<unsigned long long>(lockStatistics.maxWaitUs));
+
+        producer.stop();
+        printf("  %-10s %llu writes\n", "producer", static_cast<unsigned long long>(producer.getWrites()));
+    }
+
+    void serve(const Options &options)
+    {
+        std::vector<std::unique_ptr<ProducerSimulator>> producers;
+        for (auto bufferType : options.bufferTypes)
+        {
+            producers.push_back(std::make_unique<ProducerSimulator>(createConfiguration(options, bufferType)));
+            producers.back()->start();
+        }
+
+        // one line of JSON with the arguments of the native SharedMemory constructor of the addon
+        printf("[");
+        for (size_t i = 0; i < producers.size(); i++)
+        {
+            const auto &configuration = producers[i]->getConfiguration();
+            printf("%s{\"name\":\"%s\",\"size\":%zu,\"bufferType\":\"%s\",\"semaphoreKey\":\"%s\",\"sizeOfSingleBuffer\":%zu}",
+                   i > 0 ? "," : "", configuration.name.c_str(), producers[i]->getSize(), getBufferTypeName(configuration.bufferType),
+                   configuration.semaphoreKey.c_str(), configuration.sizeOfSingleBuffer);
+        }
+        printf("]\n");
+        fflush(stdout);
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.serveS));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        const Options options = parseOptions(argc, argv);
+        if (options.serveS > 0)
+        {
+            serve(options);
+            return EXIT_SUCCESS;
+        }
+        for (auto bufferType : options.bufferTypes)
+        {
+            benchmark(options, bufferType);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "benchmark: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
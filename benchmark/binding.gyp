@@ -0,0 +1,31 @@
+{
+    "targets": [
+        {
+            "target_name": "benchmark",
+            "type": "executable",
+            "cflags!": [
+                "-fno-exceptions"
+            ],
+            "cflags_cc!": [
+                "-fno-exceptions"
+            ],
+            "sources": [
+                "ProducerSimulator.cpp",
+                "benchmark.cpp",
+                "../src/c++/LatencyHistogram.cpp",
+                "../src/c++/SharedMemoryMappingPool.cpp",
+                "../src/c++/SharedMemorySegment.cpp",
+                "../src/c++/SystemVKey.cpp",
+                "../src/c++/SystemVSemaphore.cpp",
+                "../src/c++/SystemVSemaphoreBaseClass.cpp"
+            ],
+            "include_dirs": [
+                "../src/c++"
+            ],
+            "libraries": [
+                "-lpthread",
+                "-lrt"
+            ]
+        }
+    ]
+}
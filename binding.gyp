@@ -9,7 +9,20 @@
                 "-fno-exceptions"
             ],
             "sources": [
+                "src/c++/DescriptionRegistry.cpp",
+                "src/c++/LatencyHistogram.cpp",
+                "src/c++/ProcessValueDecoder.cpp",
+                "src/c++/ProcessValueEncoder.cpp",
+                "src/c++/SampleRing.cpp",
                 "src/c++/SharedMemory.cpp",
+                "src/c++/SharedMemoryMappingPool.cpp",
+                "src/c++/SharedMemoryReadWorker.cpp",
+                "src/c++/SharedMemoryRecorder.cpp",
+                "src/c++/SharedMemorySegment.cpp",
+                "src/c++/SharedMemoryWatcher.cpp",
+                "src/c++/SharedMemoryWriteWorker.cpp",
+                "src/c++/SnapshotDiff.cpp",
+                "src/c++/StringInterner.cpp",
                 "src/c++/SystemVKey.cpp",
                 "src/c++/SystemVSemaphore.cpp",
                 "src/c++/SystemVSemaphoreBaseClass.cpp"
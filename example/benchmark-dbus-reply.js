@@ -0,0 +1,75 @@
+import { mkdirSync, readdirSync, readFileSync, writeFileSync } from 'fs';
+import path from 'path';
+import { performance } from 'perf_hooks';
+import { browse } from '../src/browseProcessValues.js';
+import { dbusGateway } from '../src/dbusGateway.js';
+import { compactProcessDescription, parse } from '../src/dbusReply.js';
+
+// usage:
+//   node example/benchmark-dbus-reply.js capture <directory>   captures the process descriptions of all instances of the device
+//   node example/benchmark-dbus-reply.js <directory>           benchmarks the decoding of the captured process descriptions
+const iterations = 20;
+
+async function capture(directory) {
+    mkdirSync(directory, { recursive: true });
+    for await (const instance of browse()) {
+        // fetch the complete description, the one of the provider handler is already compact
+        const description = await dbusGateway({
+            serviceName: instance.moduleName,
+            objectPath: '/' + instance.objectName,
+            interfaceName: 'Interface.ProcessDecription',
+            method: 'getProcessDataDescription',
+            params: [instance.name, 'us_EN'],
+        });
+        const fileName = `${instance.moduleName}_${instance.name}.json`.replace(/[^\w.-]/g, '_');
+        writeFileSync(path.join(directory, fileName), JSON.stringify(description));
+        console.log(`captured ${fileName}`);
+    }
+}
+
+// the D-Bus message of a successful getProcessDataDescription with the description as JSON string
+function createMessage(json) {
+    return [null, [[
+        [[{ type: 'i' }], [0]],
+        [[{ type: 's' }], ['']],
+        [[{ type: 's' }], [json]],
+    ]]];
+}
+
+// the decoding before the first/last character check
+function legacyFormatData(data) {
+    if (data.match(/^\s*(\{.*\}|\[.*\])\s*$/gs)) {
+        return JSON.parse(data);
+    }
+    return [data];
+}
+
+function measure(name, run) {
+    const start = performance.now();
+    for (let i = 0; i < iterations; i++) {
+        run();
+    }
+    const duration = (performance.now() - start) / iterations;
+    console.log(`  ${name.padEnd(24)} ${duration.toFixed(3)} ms`);
+}
+
+function benchmark(directory) {
+    const files = readdirSync(directory).filter(file => file.endsWith('.json'));
+    const jsons = files.map(file => readFileSync(path.join(directory, file), 'utf8'));
+    const messages = jsons.map(createMessage);
+
+    const size = jsons.reduce((sum, json) => sum + json.length, 0);
+    const compactSize = jsons.reduce((sum, json) => sum + JSON.stringify(compactProcessDescription(JSON.parse(json))).length, 0);
+    console.log(`${files.length} process descriptions, ${size} bytes, ${compactSize} bytes compact`);
+
+    console.log(`decoding all descriptions, mean of ${iterations} runs:`);
+    measure('regex + JSON.parse', () => jsons.forEach(legacyFormatData));
+    measure('parse', () => messages.forEach(parse));
+    measure('parse + compact', () => messages.forEach(message => compactProcessDescription(parse(message))));
+}
+
+if (process.argv[2] === 'capture') {
+    await capture(process.argv[3]);
+} else {
+    benchmark(process.argv[2]);
+}
@@ -0,0 +1,99 @@
+import { spawn } from 'child_process';
+import { createInterface } from 'readline';
+import { native } from '../src/importShm.js';
+import { readGroup } from '../src/readProcessValues.js';
+import { writeTargets } from '../src/writeProcessValues.js';
+
+// usage:
+//   node example/benchmark-shared-memory.js [size] [rateHz] [values]
+// starts the native benchmark as simulated producer of all buffer types and measures the JS read and write paths
+// against it, the resolution of the selectors via D-Bus is not part of the measurement
+const [size = 4096, rateHz = 1000, numberOfValues = 16] = process.argv.slice(2).map(Number);
+const durationMs = 2000;
+const serveS = 60;
+
+// the producer prints the attach parameters of its segments as one line of JSON
+async function startProducer() {
+    const producer = spawn(new URL('../benchmark/build/Release/benchmark', import.meta.url).pathname,
+        ['--serve', String(serveS), '--size', String(size), '--rate', String(rateHz)], { stdio: ['ignore', 'pipe', 'inherit'] });
+    for await (const line of createInterface({ input: producer.stdout })) {
+        if (line.startsWith('[')) {
+            return { producer, segments: JSON.parse(line) };
+        }
+    }
+    throw new Error('The producer exited without segments');
+}
+
+// values of the type Double without metadata at the beginning of the current buffer, like the descriptions of the index
+function createResolvedValues(memory) {
+    const count = Math.min(numberOfValues, Math.floor(size / 8));
+    const offsets = Array.from({ length: count }, (_, i) => i * 8);
+    const index = {
+        types: offsets.map(() => 'Double'),
+        offsets,
+        sizes: offsets.map(() => 8),
+        bitMasks: offsets.map(() => 0),
+        metadataOffsets: offsets.map(() => 0),
+        metadataSizes: offsets.map(() => 0),
+    };
+    return offsets.map((offset, entry) => ({
+        selector: `benchmark/${entry}`,
+        valueDescription: { type: 'Double', readOnly: false, offsetSharedMemory: offset, sizeValue: 8, bitMask: 0, sizeMetadata: 0, relativeOffsetMetadata: 0 },
+        memory,
+        index,
+        entry,
+    }));
+}
+
+function getPercentile(sortedLatencies, percentile) {
+    return sortedLatencies[Math.round(percentile / 100 * (sortedLatencies.length - 1))];
+}
+
+function measure(name, run) {
+    const latencies = [];
+    const start = process.hrtime.bigint();
+    const end = start + BigInt(durationMs) * 1000000n;
+    let now = start;
+    while (now < end) {
+        const before = now;
+        run();
+        now = process.hrtime.bigint();
+        latencies.push(Number(now - before) / 1000);
+    }
+    latencies.sort((a, b) => a - b);
+
+    const throughput = latencies.length / (Number(now - start) / 1e9);
+    const percentiles = [50, 90, 99, 99.9].map(p => `p${p} ${getPercentile(latencies, p).toFixed(2).padStart(8)}`).join('  ');
+    console.log(`  ${name.padEnd(10)} ${throughput.toFixed(0).padStart(9)} ops/s  ${percentiles}  max ${latencies.at(-1).toFixed(2)} µs`);
+}
+
+function benchmark({ name, size: segmentSize, bufferType, semaphoreKey, sizeOfSingleBuffer }) {
+    // creationType 0 attaches to the semaphore of the producer
+    const memory = new native.SharedMemory(name, segmentSize, bufferType, semaphoreKey, 0, sizeOfSingleBuffer);
+    const resolvedValues = createResolvedValues(memory);
+    const group = { memory, entries: resolvedValues.map((resolvedValue, index) => ({ resolvedValue, index })), descriptorTable: null };
+    const results = new Array(resolvedValues.length);
+    const target = Buffer.alloc(sizeOfSingleBuffer);
+
+    console.log(`${bufferType}, ${sizeOfSingleBuffer} bytes, producer ${rateHz} Hz, ${resolvedValues.length} values`);
+    measure('readRange', () => memory.readRange(0, sizeOfSingleBuffer, target));
+    measure('read', () => readGroup(group, results));
+
+    // write() only accepts values of singleBufferSemaphore shared memories
+    if (bufferType === 'singleBufferSemaphore') {
+        const targets = resolvedValues.map(({ valueDescription }) => ({ memory, valueDescription, bufferStartAddress: 0, value: 1.5 }));
+        measure('write', () => writeTargets(memory, targets.slice(0, 1)));
+        measure('writeMany', () => writeTargets(memory, targets));
+    }
+
+    const { locks, contendedLocks, timeouts, maxWaitUs } = memory.getLockStatistics();
+    console.log(`  semaphore  ${locks} locks, ${contendedLocks} contended, ${timeouts} timeouts, max wait ${maxWaitUs} µs`);
+    memory.close();
+}
+
+const { producer, segments } = await startProducer();
+try {
+    segments.forEach(benchmark);
+} finally {
+    producer.kill();
+}
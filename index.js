@@ -1,4 +1,14 @@
-export { getList } from './src/browseProcessValues.js';
+export { browse, getList, refreshList } from './src/browseProcessValues.js';
+export { setDescriptionCacheFile } from './src/descriptionCache.js';
 export { read } from './src/readProcessValues.js';
 export { write } from './src/writeProcessValues.js';
+export { createWriteBehindQueue } from './src/writeBehind.js';
 export { setPlcActiveFlags } from './src/plcActive.js';
+export { compile, readCompiled, writeCompiled } from './src/compiledSelectors.js';
+export { subscribe } from './src/subscribeProcessValues.js';
+export { detachAll, getLockStatistics, getMappingStatistics, getStats, resetStats, setLockTimeout, setReadTimeout } from './src/bufferHandler.js';
+export { mapView } from './src/sharedMemoryView.js';
+export { startRecording } from './src/recordProcessValues.js';
+export { readRecording } from './src/recordingReader.js';
+export { createChangeDetector } from './src/detectChanges.js';
+export { getPrometheusMetrics } from './src/prometheusMetrics.js';
@@ -1,5 +1,7 @@
 import { getRegisteredProvidersList, getListOfInstances } from './systemInformationManager.js';
-import { getProcessDataDescription } from './providerHandler.js';
+import { getProcessDataDescription, refreshProcessDataDescription } from './providerHandler.js';
+import { getProcessDescriptionIndex } from './processDescriptionIndex.js';
+import { createConcurrencyLimit } from './concurrencyLimit.js';
 
 /**
  * Checks if an object has a property.
@@ -45,53 +47,295 @@ async function getProcessValueProvidingModules() {
     return modules;
 }
 
+// number of parallel D-Bus requests of a browse, if no other value is given
+const defaultConcurrency = 4;
+
+// result of the last browse with the instances of each module, the base of an incremental refresh
+let browseState = null;
+
 /**
  * Retrieves a list of possible process values from all available modules of the JUMO variTRON system.
  *
+ * @param {Object} [options] - The options of the browse.
+ * @param {number} [options.concurrency=4] - The maximal number of D-Bus requests in flight at the same time.
  * @returns {Promise<Array>} A promise that resolves to an array of modules and their associated process values.
  * @throws {Error} If there is an error retrieving the list of process values.
+ *
+ * @description
+ * Modules, instances and substructures are browsed in parallel, but only up to concurrency D-Bus requests are
+ * in flight at the same time. The order of the result is the same as with a sequential browse.
+ * The list is browsed once, later calls return the same list until it is updated by refreshList.
 */
-// eslint-disable-next-line max-statements
-export async function getList() {
+export async function getList({ concurrency = defaultConcurrency } = {}) {
     // return provider list from cache if available
-    if (typeof getList.providerCache !== 'undefined') {
-        return getList.providerCache;
+    if (browseState !== null) {
+        return browseState.providerList;
+    }
+
+    browseState = await browseModules(concurrency, null, false);
+    return browseState.providerList;
+}
+
+/**
+ * Updates the list of process values incrementally and returns the changes since the last browse.
+ *
+ * @param {Object} [options] - The options of the refresh.
+ * @param {number} [options.concurrency=4] - The maximal number of D-Bus requests in flight at the same time.
+ * @param {boolean} [options.revalidate=false] - Fetches the descriptions of all instances again instead of only the new ones.
+ * @returns {Promise<Object>} - A promise that resolves with the generation of the list, the updated list and the
+ *                              selectors that were added, removed or changed.
+ * @throws {Error} If there is an error retrieving the list of providers.
+ *
+ * @description
+ * The providers and their instances are requested again, which are cheap D-Bus calls. Only the descriptions of
+ * new instances are fetched, with revalidate also the descriptions of the known instances. Every refresh is a new
+ * generation, each instance keeps the generation in which its process values changed the last time.
+ * If a module can't be browsed, its instances of the last browse are kept.
+ *
+ * @example
+ * // Example usage:
+ * const { added, removed, changed } = await refreshList();
+ */
+export async function refreshList({ concurrency = defaultConcurrency, revalidate = false } = {}) {
+    const previousState = browseState;
+    const state = await browseModules(concurrency, previousState, revalidate);
+    browseState = state;
+    return { generation: state.generation, list: state.providerList, ...createDelta(previousState, state) };
+}
+
+/**
+ * Browses all modules, reusing the instances of a previous browse.
+ *
+ * @param {number} concurrency - The maximal number of D-Bus requests in flight at the same time.
+ * @param {Object|null} previousState - The result of the previous browse or null.
+ * @param {boolean} revalidate - Fetches the descriptions of the known instances again.
+ * @returns {Promise<Object>} - A promise that resolves with the generation, the modules with all instances and the provider list.
+ */
+async function browseModules(concurrency, previousState, revalidate) {
+    const context = createContext(concurrency, previousState, revalidate);
+    const moduleList = await getModuleList();
+    const modules = await Promise.all(moduleList.map(module => browseModule(module, context)));
+    return { generation: context.generation, modules, providerList: createProviderList(modules) };
+}
+
+/**
+ * Creates the context of a browse, which is shared by the browses of all modules and instances.
+ *
+ * @param {number} concurrency - The maximal number of D-Bus requests in flight at the same time.
+ * @param {Object|null} previousState - The result of the previous browse or null.
+ * @param {boolean} revalidate - Fetches the descriptions of the known instances again.
+ * @returns {Object} - The context.
+ * @throws {Error} - Throws an error if concurrency is not a positive integer.
+ */
+function createContext(concurrency, previousState, revalidate) {
+    if (!Number.isInteger(concurrency) || concurrency < 1) {
+        throw new Error('concurrency is not a positive integer');
     }
+    return {
+        limit: createConcurrencyLimit(concurrency),
+        generation: previousState === null ? 1 : previousState.generation + 1,
+        previousState,
+        previousInstances: new Map(getInstanceEntries(previousState).map(entry => [entry.key, entry])),
+        revalidate,
+        // filters process values out before they are added to the result
+        filter: {},
+        // called with each browsed instance instead of collecting it, if set
+        onInstance: null,
+        // set when the result is not needed anymore, no further D-Bus requests are started
+        stopped: false,
+    };
+}
 
-    let moduleList;
+/**
+ * Retrieves the list of modules providing process values.
+ *
+ * @returns {Promise<Array<Object>>} - A promise that resolves with the moduleName and objectName of each module.
+ * @throws {Error} - Throws an error if the list of modules can't be retrieved.
+ */
+async function getModuleList() {
     try {
-        moduleList = await getProcessValueProvidingModules();
+        return await getProcessValueProvidingModules();
     } catch (e) {
         throw new Error(`Unable to getProcessValueProvidingModules: ${e}`, { cause: e });
     }
+}
+
+/**
+ * Browses the process values instance by instance.
+ *
+ * @param {Object} [options] - The options of the browse.
+ * @param {number} [options.concurrency=4] - The maximal number of D-Bus requests in flight at the same time.
+ * @param {string} [options.moduleName] - Browses only the module with this name.
+ * @param {string} [options.type] - Yields only process values of this type, e.g. 'Float'.
+ * @param {boolean} [options.writable] - Yields only writable process values if true, only read-only process values if false.
+ * @yields {Object} - An instance with moduleName, objectName, name and values like in the list of getList.
+ * @throws {Error} - Throws an error if the list of modules can't be retrieved or concurrency is not a positive integer.
+ *
+ * @description
+ * Each instance is yielded as soon as its description is parsed, in the order the D-Bus requests are answered.
+ * The filters are applied while parsing, process values that don't match are never created, instances without
+ * matching process values are skipped. Ending the iteration early stops all further D-Bus requests.
+ * The result is not cached and does not change the list of getList.
+ *
+ * @example
+ * // Example usage:
+ * for await (const instance of browse({ type: 'Float', writable: true })) {
+ *     console.log(instance.moduleName, instance.name, instance.values);
+ * }
+ */
+export async function* browse({ concurrency = defaultConcurrency, moduleName, type, writable } = {}) {
+    const context = createContext(concurrency, null, false);
+    const instances = [];
+    let finished = false;
+    let failure = null;
+    let wakeUp = () => { };
+
+    context.filter = { type, writable };
+    context.onInstance = (description, entry) => {
+        if (entry.fingerprints.size > 0) {
+            instances.push({ moduleName: description.moduleName, objectName: description.objectName, name: entry.name, values: entry.values });
+            wakeUp();
+        }
+    };
+
+    getModuleList()
+        .then(moduleList => Promise.all(moduleList
+            .filter(module => moduleName === undefined || module.moduleName === moduleName)
+            .map(module => browseModule(module, context))))
+        .catch(error => { failure = error; })
+        .finally(() => {
+            finished = true;
+            wakeUp();
+        });
 
-    const providerList = [];
-    for (const module of moduleList) {
-        const result = [];
-        try {
-            // get all instances of a module
-            const instanceList = await getListOfInstances(module.moduleName, module.objectName, 'us_EN');
-
-            //result = [];
-            for (const instance of instanceList) {
-                const activeInstances = await recursiveFindInstance(instance);
-                result.push(...activeInstances);
+    try {
+        while (instances.length > 0 || !finished) {
+            if (instances.length === 0) {
+                await new Promise(resolve => { wakeUp = resolve; });
+                continue;
             }
-        } catch (e) {
-            console.log(`Error while processing module ${module.moduleName}: ${e}`);
+            yield instances.shift();
         }
+        if (failure !== null) {
+            throw failure;
+        }
+    } finally {
+        context.stopped = true;
+    }
+}
 
+/**
+ * Creates the public list of the browsed modules.
+ *
+ * @param {Array<Object>} modules - The browsed modules with all of their instances.
+ * @returns {Array<Object>} - The modules with the instances that have process values.
+ */
+function createProviderList(modules) {
+    return modules
+        .map(module => ({
+            moduleName: module.moduleName,
+            objectName: module.objectName,
+            instances: module.entries.filter(entry => entry.fingerprints.size > 0).map(entry => ({ name: entry.name, values: entry.values })),
+        }))
         // keep only modules with instances because we don't want to see modules without process values
-        if (result.length > 0) {
-            providerList.push({
-                moduleName: module.moduleName,
-                objectName: module.objectName,
-                instances: result,
-            });
+        .filter(module => module.instances.length > 0);
+}
+
+/**
+ * Browses all instances of a module.
+ *
+ * @param {Object} module - The module with its moduleName and objectName.
+ * @param {Object} context - The context of the browse.
+ * @returns {Promise<Object>} - A promise that resolves with the module and its instances.
+ *
+ * @description
+ * An error of an instance ends the browse of the module like a sequential browse would: the instances before the
+ * failing one are kept, the error is logged. On a refresh the instances of the previous browse are kept instead.
+ */
+async function browseModule(module, context) {
+    const entries = [];
+    try {
+        // get all instances of a module
+        const instanceList = await context.limit(() => getListOfInstances(module.moduleName, module.objectName, 'us_EN'));
+        entries.push(...await settleInOrder(instanceList.map(instance => recursiveFindInstance(instance, context)), entries));
+    } catch (e) {
+        console.log(`Error while processing module ${module.moduleName}: ${e}`);
+        const previousModule = findModule(context.previousState, module);
+        if (previousModule !== undefined) {
+            return previousModule;
+        }
+    }
+
+    return { moduleName: module.moduleName, objectName: module.objectName, entries };
+}
+
+/**
+ * Finds a module in the result of a browse.
+ *
+ * @param {Object|null} state - The result of a browse or null.
+ * @param {Object} module - The module with its moduleName and objectName.
+ * @returns {Object|undefined} - The module of the browse.
+ */
+function findModule(state, module) {
+    return state?.modules.find(entry => entry.moduleName === module.moduleName && entry.objectName === module.objectName);
+}
+
+/**
+ * Gets the instances of all modules of a browse.
+ *
+ * @param {Object|null} state - The result of a browse or null.
+ * @returns {Array<Object>} - The instances.
+ */
+function getInstanceEntries(state) {
+    return state === null ? [] : state.modules.flatMap(module => module.entries);
+}
+
+/**
+ * Compares the process values of two browses.
+ *
+ * @param {Object|null} previousState - The result of the previous browse or null.
+ * @param {Object} state - The result of the current browse.
+ * @returns {Object} - The selectors that were added, removed or changed.
+ */
+function createDelta(previousState, state) {
+    const collectSelectors = entries => new Map(entries.flatMap(entry => [...entry.fingerprints]));
+    const previousSelectors = collectSelectors(getInstanceEntries(previousState));
+    const selectors = collectSelectors(getInstanceEntries(state));
+
+    const added = [];
+    const changed = [];
+    for (const [selector, fingerprint] of selectors) {
+        const previousFingerprint = previousSelectors.get(selector);
+        if (previousFingerprint === undefined) {
+            added.push(selector);
+        } else if (previousFingerprint !== fingerprint) {
+            changed.push(selector);
         }
     }
-    getList.providerCache = providerList;
-    return providerList;
+    const removed = [...previousSelectors.keys()].filter(selector => !selectors.has(selector));
+
+    return { added, removed, changed };
+}
+
+/**
+ * Waits for all browses of instances and flattens their results in the original order.
+ *
+ * @param {Array<Promise<Array>>} browses - The running browses of the instances.
+ * @param {Array} [partialResult] - Receives the results before the first failed browse.
+ * @returns {Promise<Array>} - A promise that resolves with the flat list of all instances.
+ * @throws {Error} - Throws the error of the first failed browse in the original order.
+ */
+async function settleInOrder(browses, partialResult = []) {
+    const outcomes = await Promise.allSettled(browses);
+    const instances = [];
+    for (const outcome of outcomes) {
+        if (outcome.status === 'rejected') {
+            partialResult.push(...instances);
+            throw outcome.reason;
+        }
+        instances.push(...outcome.value);
+    }
+    return instances;
 }
 
 // filter out modules and instances that should not be shown because they are invalid, useless or for internal use only
@@ -107,6 +351,7 @@ const instanceBlocklist = [
  * Recursively finds and structures process data instances from a given instance object.
  *
  * @param {Object} instance - The instance object containing information about a module, instance, and substructure.
+ * @param {Object} context - The context of the browse with the limit of the D-Bus requests and the instances of the previous browse.
  * @returns {Promise<Array<Object>>} - A promise that resolves with an array of structured process data instances.
  * @throws {Error} - Throws an error if there is an issue retrieving the ProcessDataDescription or creating the object hierarchy.
  *
@@ -120,25 +365,17 @@ const instanceBlocklist = [
  * // Example usage:
  * const instanceData = {...}; // An instance object containing information about modules, instances, and substructure.
  * try {
- *     const structuredInstances = await recursiveFindInstance(instanceData);
+ *     const structuredInstances = await recursiveFindInstance(instanceData, context);
  *     // Process the array of structured process data instances...
  * } catch (error) {
  *     // Handle the error...
  * }
  */
-// eslint-disable-next-line max-statements
-async function recursiveFindInstance(instance) {
-    // if instance has a substructure, recursive call recursiveFindInstance for each substructure
+async function recursiveFindInstance(instance, context) {
+    // if instance has a substructure, recursive call recursiveFindInstance for each substructure,
+    // the D-Bus requests of all substructures are pipelined through the limit
     if (hasProperty(instance, 'substructure')) {
-        const filteredSubInstances = [];
-        // process each substucture after another to avoid parallel dbus calls
-        for (const subInstance of instance.substructure) {
-            const result = await recursiveFindInstance(subInstance);
-
-            // add flat list of subinstances to to our list, if there are any
-            if (result.length > 0) filteredSubInstances.push(...result);
-        }
-        return filteredSubInstances;
+        return settleInOrder(instance.substructure.map(subInstance => recursiveFindInstance(subInstance, context)));
     }
 
     // process the leaf instance
@@ -150,27 +387,91 @@ async function recursiveFindInstance(instance) {
         return [];
     }
 
+    // a known instance is only fetched again if it should be revalidated
+    const previousEntry = context.previousInstances.get(getInstanceKey(instance));
+    if (previousEntry !== undefined && !context.revalidate) {
+        return [previousEntry];
+    }
+
     try {
-        const processDataDescription = await getProcessDataDescription(moduleName, instanceName, objectName, 'us_EN');
-
-        const structuredProcessDataDescription = {};
-        recursiveFindLeafObjects(structuredProcessDataDescription, processDataDescription, { moduleName, instanceName, objectName }, []);
-
-        // return only, if structuredProcessDataDescription has elements
-        if (Object.keys(structuredProcessDataDescription).length > 0) {
-            return [{
-                name: instanceName,
-                values: structuredProcessDataDescription,
-            }];
-        } else {
+        // a refresh bypasses the cached descriptions, they may be outdated
+        const load = context.previousState === null ? getProcessDataDescription : refreshProcessDataDescription;
+        const processDataDescription = await context.limit(() => context.stopped ? null : load(moduleName, instanceName, objectName, 'us_EN'));
+        if (processDataDescription === null) {
             return [];
         }
+        const entry = createInstanceEntry(processDataDescription, { moduleName, instanceName, objectName }, context);
+
+        // a streamed instance is handed over at once and not collected
+        if (context.onInstance !== null) {
+            context.onInstance(instance, entry);
+            return [];
+        }
+
+        // an unchanged instance keeps its generation
+        return [previousEntry !== undefined && isSameInstance(previousEntry, entry) ? previousEntry : entry];
     } catch (error) {
         const errMsg = `Can't get ProcessDataDescription for module: ${moduleName},  instance: ${instanceName}, object: ${objectName}: ${error}`;
         throw new Error(errMsg, { cause: error });
     }
 }
 
+/**
+ * Gets the key of an instance, which is the common beginning of the selectors of its process values.
+ *
+ * @param {Object} description - The module name, instance name and object name of the instance.
+ * @returns {string} - The key of the instance.
+ */
+function getInstanceKey(description) {
+    return `ProcessData#${description.moduleName}#${description.objectName}#${description.instanceName}`;
+}
+
+/**
+ * Creates the browse result of an instance.
+ *
+ * @param {Object} processDataDescription - The process description of the instance.
+ * @param {Object} description - The module name, instance name and object name of the instance.
+ * @param {Object} context - The context of the browse with its generation and filter.
+ * @returns {Object} - The instance with its structured process values and a fingerprint of each process value by selector.
+ */
+function createInstanceEntry(processDataDescription, description, context) {
+    const values = {};
+    const fingerprints = new Map();
+    findLeafObjects(values, getProcessDescriptionIndex(processDataDescription), description, fingerprints, context.filter);
+    return { key: getInstanceKey(description), name: description.instanceName, values, fingerprints, generation: context.generation };
+}
+
+/**
+ * Checks if a process value matches the filter of a browse.
+ *
+ * @param {Object} source - The description of the process value.
+ * @param {Object} filter - The filter with an optional type and writability.
+ * @returns {boolean} - True if the process value matches all given filters.
+ */
+function matchesFilter(source, filter) {
+    return (filter.type === undefined || source.type === filter.type)
+        && (filter.writable === undefined || !source.readOnly === filter.writable);
+}
+
+/**
+ * Checks if two browse results of an instance have the same process values.
+ *
+ * @param {Object} entry - The first browse result.
+ * @param {Object} otherEntry - The second browse result.
+ * @returns {boolean} - True if both have the same selectors with the same fingerprints.
+ */
+function isSameInstance(entry, otherEntry) {
+    if (entry.fingerprints.size !== otherEntry.fingerprints.size) {
+        return false;
+    }
+    for (const [selector, fingerprint] of entry.fingerprints) {
+        if (otherEntry.fingerprints.get(selector) !== fingerprint) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Sets a deep property in an object based on a given path.
  *
@@ -202,48 +503,46 @@ const leafObjectBlocklist = [
 ];
 
 /**
- * Recursively finds leaf objects in a source object and adds them to a destination object hierarchy.
+ * Adds the process values of an instance to a destination object hierarchy.
  *
  * @param {object} destination - The destination object hierarchy.
- * @param {object} source - The source object to search for leaf objects.
+ * @param {ProcessDescriptionIndex} index - The index of the process description of the instance.
  * @param {object} description - The description of the leaf objects with the module name, instance name, and object name.
- * @param {Array} objectPath - The current path in the object hierarchy.
+ * @param {Map<string, string>} fingerprints - Receives a fingerprint of the description of each process value by selector.
+ * @param {Object} filter - Process values that don't match the filter are skipped.
  */
-function recursiveFindLeafObjects(destination, source, description, objectPath) {
-    // filter out leafs that should not be shown because they are invalid, useless or for internal use only
-    if (leafObjectBlocklist.some(entry => entry.moduleName === description.moduleName && entry.object.test(objectPath[objectPath.length - 1]))) {
-        return;
-    }
+function findLeafObjects(destination, index, description, fingerprints, filter) {
+    const blocklist = leafObjectBlocklist.filter(entry => entry.moduleName === description.moduleName);
 
-    // if a source is of type TreeNode, there are structures one stage deeper in the value property
-    if (hasProperty(source, 'type') && source.type === 'TreeNode') {
-        // recursive call this function with all structures
-        for (const [key, value] of Object.entries(source.value)) {
-            const nextPath = objectPath.concat(key);
-            recursiveFindLeafObjects(destination, value, description, nextPath);
-        }
-        return;
-    }
-
-    // leafs with 'offsetSharedMemory' property are process values but can contain internal data that should not be visible
-    // @todo: use 'selectorTypeListEndpoint' instead. problem: the outputs of ethercat modules have no
-    //        'selectorTypeListEndpoint' property. This will be coming probably in a future version of the variTRON.
-    if (hasProperty(source, 'offsetSharedMemory')) {
+    index.paths.forEach((pathName, entry) => {
         // pathName is the path to the element as a string, divided by '/'
-        const pathName = objectPath.join('/');
+        const objectPath = pathName.split('/');
+
+        // filter out leafs that should not be shown because they are invalid, useless or for internal use only,
+        // a blocked structure hides all process values inside of it
+        if (blocklist.some(blocked => objectPath.some(key => blocked.object.test(key)))) {
+            return;
+        }
 
-        // if we use array indices in the path, we need to replace them with '#value[index]'
-        // pathName = pathName.replace(/\[(\d+)\]/g, '#value[$1]');
+        // @todo: use 'selectorTypeListEndpoint' instead. problem: the outputs of ethercat modules have no
+        //        'selectorTypeListEndpoint' property. This will be coming probably in a future version of the variTRON.
+        const source = index.valueDescriptions[entry];
+        if (!matchesFilter(source, filter)) {
+            return;
+        }
 
         // add unit if unit is available
         const unit = hasProperty(source, 'measurementRangeAttributes') ? source.measurementRangeAttributes[0].unitText.POSIX : '';
 
+        const selector = `${getInstanceKey(description)}#${pathName}`;
         setDeepProperty(destination, objectPath, {
             name: source.labelText,
-            selector: `ProcessData#${description.moduleName}#${description.objectName}#${description.instanceName}#${pathName}`,
+            selector,
             type: source.type,
             readOnly: source.readOnly,
             unit
         });
-    }
+        // the layout and the attributes of the process value, a change is reported by refreshList
+        fingerprints.set(selector, JSON.stringify(source));
+    });
 }
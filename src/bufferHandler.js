@@ -1,33 +1,5 @@
 import { native } from './importShm.js';
 
-/**
- * Retrieves the process data description buffer entry for a specified module, instance, and object.
- *
- * @param {string} moduleName - The name of the module associated with the process data.
- * @param {string} instanceName - The name of the instance associated with the process data.
- * @param {string} objectName - The name of the object associated with the process data.
- * @param {Array} buffer - The buffer containing process data description entries.
- * @returns {Object|undefined} - The process data description entry if found; otherwise, undefined.
- *
- * @description
- * This function searches the provided buffer for an entry matching the specified module, instance, and object names.
- * If a matching entry is found, the associated process description is returned; otherwise, undefined is returned.
- */
-export function getProcessDataDescriptionBuffer(moduleName, instanceName, objectName, buffer) {
-    // Find the process data description entry in the buffer based on module, instance, and object names.
-    const foundObject = buffer.find(obj =>
-        obj.moduleName === moduleName &&
-        obj.instanceName === instanceName &&
-        obj.objectName === objectName
-    );
-    // Return the process data description if a matching entry is found; otherwise, return undefined.
-    if (foundObject) {
-        return foundObject.processDescription;
-    } else {
-        return undefined;
-    }
-}
-
 /**
  * checks if the system version is at least 9
  * @param {*} cpveVersion - the version of the CPVE out of the process description
@@ -139,6 +111,70 @@ export function getCurrentBufferStartAddress(processDescription, buf) {
     return startAddress;
 }
 
+// deadline for a consistent read of a buffer with a sequence number, undefined keeps the native default of 10 ms
+let readTimeoutMs;
+
+/**
+ * Sets the deadline for a consistent read of shared memories with a sequence number (singleBufferSequenceLock and doubleBuffer).
+ * A reader that collides with the producer retries until the deadline and then throws an Error with the code ERR_READ_TIMEOUT.
+ * The timeout applies to all attached shared memories and to those attached later.
+ *
+ * @param {number} timeoutMs - The timeout in ms, 0 tries exactly once.
+ */
+export function setReadTimeout(timeoutMs) {
+    if (typeof timeoutMs !== 'number' || !(timeoutMs >= 0)) {
+        throw new Error('The read timeout must be a non-negative number');
+    }
+    readTimeoutMs = timeoutMs;
+    attachToSharedMemory.cache?.forEach(memory => memory.setReadTimeout(timeoutMs));
+}
+
+// deadline to lock the semaphore of a shared memory, undefined keeps the native default of 100 ms
+let lockTimeoutMs;
+
+/**
+ * Sets the deadline to lock the semaphore of a shared memory for a write or for a read of a singleBufferSemaphore.
+ * An operation that doesn't get the semaphore until the deadline fails with an Error with the code ERR_LOCK_TIMEOUT,
+ * so a hanging producer can't block the event loop. The timeout applies to all attached shared memories and to
+ * those attached later.
+ *
+ * @param {number} timeoutMs - The timeout in ms, 0 only takes a free semaphore.
+ */
+export function setLockTimeout(timeoutMs) {
+    if (typeof timeoutMs !== 'number' || !(timeoutMs >= 0)) {
+        throw new Error('The lock timeout must be a non-negative number');
+    }
+    lockTimeoutMs = timeoutMs;
+    attachToSharedMemory.cache?.forEach(memory => memory.setLockTimeout(timeoutMs));
+}
+
+/**
+ * Gets the counters of the semaphores of all attached shared memories.
+ *
+ * @returns {Array<Object>} - The key of each attached shared memory with the numbers of locks, contended locks,
+ *                            timeouts and failures, the total and maximal wait time in µs and the wait time histogram.
+ */
+export function getLockStatistics() {
+    return [...(attachToSharedMemory.cache?.entries() || [])].map(([key, memory]) => ({ key, ...memory.getLockStatistics() }));
+}
+
+/**
+ * Gets the counters and latency histograms of all attached shared memories.
+ *
+ * @returns {Array<Object>} - The key of each attached shared memory with the counters of its reads, writes and
+ *                            semaphore and the latency histograms of its reads and writes.
+ */
+export function getStats() {
+    return [...(attachToSharedMemory.cache?.entries() || [])].map(([key, memory]) => ({ key, ...memory.getStats() }));
+}
+
+/**
+ * Resets the counters and latency histograms of all attached shared memories to 0.
+ */
+export function resetStats() {
+    attachToSharedMemory.cache?.forEach(memory => memory.resetStats());
+}
+
 /**
  * Attaches to a shared memory segment based on the provided process description.
  * Caches shared memory objects to avoid redundant attachments.
@@ -172,10 +208,36 @@ export function attachToSharedMemory(processDescription) {
 
     // create new shared memory object and store it in the cache
     const newMemory = createSharedMemoryObject(processDescription, sharedMemoryKey, shmKey, offsetSharedMemory);
+    if (readTimeoutMs !== undefined) {
+        newMemory.setReadTimeout(readTimeoutMs);
+    }
+    if (lockTimeoutMs !== undefined) {
+        newMemory.setLockTimeout(lockTimeoutMs);
+    }
     attachToSharedMemory.cache.set(cacheKey, newMemory);
     return newMemory;
 }
 
+/**
+ * Closes all attached shared memories and clears the cache, so the next access attaches again.
+ * The mappings are unmapped natively as soon as no shared memory object uses them anymore.
+ * Compiled selectors, subscriptions and views created before keep no access to the closed shared memories.
+ */
+export function detachAll() {
+    attachToSharedMemory.cache?.forEach(memory => memory.close());
+    attachToSharedMemory.cache?.clear();
+}
+
+/**
+ * Gets the counters of the native pool of shared memory mappings, which shares one mapping per shared memory
+ * between all attachments of the process.
+ *
+ * @returns {Object} - The number of live mappings, the mapped bytes and the numbers of created, released and reused mappings.
+ */
+export function getMappingStatistics() {
+    return native.getMappingStatistics();
+}
+
 /**
  * Creates a new shared memory object.
  * @param {*} processDescription - The process description containing details for shared memory creation.
@@ -206,5 +268,6 @@ function createSharedMemoryObject(processDescription, sharedMemoryKey, shmKey, o
 
     //console.log(`attachToSharedMemory() ${shmKey}, bufferType: ${processDescription.bufferType}, singleSize: ${sizeOfSingleSharedMemory}, offsetSharedMemory: ${offsetSharedMemory}`);
 
-    return new native.SharedMemory(shmKey, completeSizeSharedMemory, isDoubleBuffer, semaphoreKey, creationType);
+    // the buffer type and the size of a single buffer let the native side locate the current buffer for ranged reads
+    return new native.SharedMemory(shmKey, completeSizeSharedMemory, bufferType, semaphoreKey, creationType, sizeOfSingleSharedMemory);
 }
@@ -0,0 +1,145 @@
+/*!
+ * @file   DescriptionRegistry.cpp
+ *
+ * @brief  This class shares the process descriptions between the main thread and all worker threads of the process,
+ *         so a description is fetched via D-Bus only once. A thread claims a description before it fetches it, the
+ *         other threads wait until it is published instead of fetching it as well. A waiting thread is notified by
+ *         its listener when the description is published or the claim is released.
+ *
+ */
+
+#include "DescriptionRegistry.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace
+{
+    struct Entry
+    {
+        // shared, so a description is copied outside of the lock
+        std::shared_ptr<const std::string> description;
+        const void *pClaimOwner = nullptr;
+        // the owners that wait until the description is published or the claim is released
+        std::set<const void *> waiters;
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::map<std::string, Entry> entries;
+        std::map<const void *, DescriptionRegistry::Listener> listeners;
+    };
+
+    // the registry is never destroyed, worker threads may still use it during the exit of the process
+    Registry &getRegistry()
+    {
+        static Registry *pRegistry = new Registry();
+        return *pRegistry;
+    }
+
+    // called with the lock held, so a listener is never called after it was removed
+    void notifyWaiters(Registry &registry, const std::string &key, Entry &entry)
+    {
+        for (const void *pWaiter : entry.waiters)
+        {
+            auto it = registry.listeners.find(pWaiter);
+            if (it != registry.listeners.end())
+            {
+                it->second(key);
+            }
+        }
+        entry.waiters.clear();
+    }
+}
+
+bool DescriptionRegistry::get(const std::string &key, std::string &description)
+{
+    std::shared_ptr<const std::string> published;
+    {
+        Registry &registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.entries.find(key);
+        if (it == registry.entries.end() || !it->second.description)
+        {
+            return false;
+        }
+        published = it->second.description;
+    }
+    description = *published;
+    return true;
+}
+
+bool DescriptionRegistry::claim(const std::string &key, const void *pOwner)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Entry &entry = registry.entries[key];
+    if (entry.description)
+    {
+        return false;
+    }
+    if (entry.pClaimOwner != nullptr && entry.pClaimOwner != pOwner)
+    {
+        // registered under the lock, so the owner can't miss the publication
+        entry.waiters.insert(pOwner);
+        return false;
+    }
+    entry.pClaimOwner = pOwner;
+    return true;
+}
+
+void DescriptionRegistry::publish(const std::string &key, const std::string &description)
+{
+    auto published = std::make_shared<const std::string>(description);
+
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    Entry &entry = registry.entries[key];
+    entry.description = std::move(published);
+    entry.pClaimOwner = nullptr;
+    notifyWaiters(registry, key, entry);
+}
+
+void DescriptionRegistry::release(const std::string &key, const void *pOwner)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto it = registry.entries.find(key);
+    if (it != registry.entries.end() && it->second.pClaimOwner == pOwner)
+    {
+        it->second.pClaimOwner = nullptr;
+        notifyWaiters(registry, key, it->second);
+    }
+}
+
+void DescriptionRegistry::releaseAll(const void *pOwner)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto &keyAndEntry : registry.entries)
+    {
+        keyAndEntry.second.waiters.erase(pOwner);
+        if (keyAndEntry.second.pClaimOwner == pOwner)
+        {
+            keyAndEntry.second.pClaimOwner = nullptr;
+            notifyWaiters(registry, keyAndEntry.first, keyAndEntry.second);
+        }
+    }
+}
+
+void DescriptionRegistry::setListener(const void *pOwner, Listener listener)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.listeners[pOwner] = std::move(listener);
+}
+
+void DescriptionRegistry::removeListener(const void *pOwner)
+{
+    Registry &registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.listeners.erase(pOwner);
+}
@@ -0,0 +1,80 @@
+/*!
+ * @file   DescriptionRegistry.hpp
+ *
+ * @brief  This class shares the process descriptions between the main thread and all worker threads of the process,
+ *         so a description is fetched via D-Bus only once. A thread claims a description before it fetches it, the
+ *         other threads wait until it is published instead of fetching it as well. A waiting thread is notified by
+ *         its listener when the description is published or the claim is released.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+class DescriptionRegistry
+{
+public:
+    // called with the key of a description, under the lock of the registry, so it must not block
+    using Listener = std::function<void(const std::string &key)>;
+
+    /**
+     * Get a published description
+     *
+     * @param key the key of the description
+     * @param description the description, e.g. as JSON
+     * @return false if the description has not been published yet
+     */
+    static bool get(const std::string &key, std::string &description);
+
+    /**
+     * Claim the fetch of a description that has not been published yet
+     *
+     * @param key the key of the description
+     * @param pOwner the owner of the claim, e.g. the instance data of the environment of the thread
+     * @return true if the owner has the claim and has to publish or release it, false if the description is
+     *         published or claimed by another owner. If it is claimed by another owner, the listener of the owner is
+     *         called once when it is published or the claim is released.
+     */
+    static bool claim(const std::string &key, const void *pOwner);
+
+    /**
+     * Publish a description and release the claim on it. A published description is replaced.
+     *
+     * @param key the key of the description
+     * @param description the description
+     */
+    static void publish(const std::string &key, const std::string &description);
+
+    /**
+     * Release the claim of an owner on a description, e.g. after the fetch failed
+     *
+     * @param key the key of the description
+     * @param pOwner the owner of the claim
+     */
+    static void release(const std::string &key, const void *pOwner);
+
+    /**
+     * Release all claims of an owner, e.g. when its thread exits
+     *
+     * @param pOwner the owner of the claims
+     */
+    static void releaseAll(const void *pOwner);
+
+    /**
+     * Set the listener of an owner, it replaces a listener that was set before
+     *
+     * @param pOwner the owner, e.g. the instance data of the environment of the thread
+     * @param listener the listener that is notified about the descriptions the owner waits for
+     */
+    static void setListener(const void *pOwner, Listener listener);
+
+    /**
+     * Remove the listener of an owner, it is not called anymore after this returns
+     *
+     * @param pOwner the owner of the listener
+     */
+    static void removeListener(const void *pOwner);
+};
@@ -0,0 +1,116 @@
+/*!
+ * @file   LatencyHistogram.cpp
+ *
+ * @brief  This class counts latencies in a log-linear histogram like HdrHistogram. Every power of two is split into
+ *         8 buckets, so a percentile is at most 12.5 % above the real value. Recording only uses relaxed atomics, so
+ *         it can be called by all threads on the hot path.
+ *
+ */
+
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram()
+    : m_count(0),
+      m_sumNs(0),
+      m_maxNs(0)
+{
+    for (auto &bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::getBucketIndex(uint64_t latencyNs)
+{
+    if (latencyNs < numberOfSubBuckets)
+    {
+        return static_cast<size_t>(latencyNs);
+    }
+
+    // the highest bit selects the power of two, the next bits the sub bucket inside of it
+    const unsigned int exponent = 63 - __builtin_clzll(latencyNs);
+    const size_t subBucket = (latencyNs >> (exponent - subBucketBits)) & (numberOfSubBuckets - 1);
+    return numberOfSubBuckets + (exponent - subBucketBits) * numberOfSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t index)
+{
+    if (index < numberOfSubBuckets)
+    {
+        return index;
+    }
+
+    const unsigned int shift = static_cast<unsigned int>((index - numberOfSubBuckets) / numberOfSubBuckets);
+    const uint64_t subBucket = (index - numberOfSubBuckets) % numberOfSubBuckets;
+    const uint64_t lowerBound = (numberOfSubBuckets + subBucket) << shift;
+    return lowerBound + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t latencyNs)
+{
+    m_buckets[getBucketIndex(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(latencyNs, std::memory_order_relaxed);
+
+    uint64_t maxNs = m_maxNs.load(std::memory_order_relaxed);
+    while (latencyNs > maxNs && !m_maxNs.compare_exchange_weak(maxNs, latencyNs, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::getSnapshot() const
+{
+    // the counters are read one by one, a latency recorded meanwhile may be missing in some of them
+    Snapshot snapshot;
+    snapshot.count = m_count.load(std::memory_order_relaxed);
+    snapshot.sumNs = m_sumNs.load(std::memory_order_relaxed);
+    snapshot.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < numberOfBuckets; i++)
+    {
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::getValueAtPercentile(double percentile) const
+{
+    uint64_t total = 0;
+    for (uint64_t bucket : buckets)
+    {
+        total += bucket;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    const double clampedPercentile = std::min(100.0, std::max(0.0, percentile));
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clampedPercentile / 100 * total)));
+
+    uint64_t cumulated = 0;
+    for (size_t i = 0; i < numberOfBuckets; i++)
+    {
+        cumulated += buckets[i];
+        if (cumulated >= rank)
+        {
+            // the bucket can't contain more than the maximum, unless the maximum was read before a latency was recorded
+            const uint64_t lowerBound = (i == 0) ? 0 : getBucketUpperBound(i - 1) + 1;
+            return std::max(lowerBound, std::min(getBucketUpperBound(i), maxNs));
+        }
+    }
+    return maxNs;
+}
@@ -0,0 +1,65 @@
+/*!
+ * @file   LatencyHistogram.hpp
+ *
+ * @brief  This class counts latencies in a log-linear histogram like HdrHistogram. Every power of two is split into
+ *         8 buckets, so a percentile is at most 12.5 % above the real value. Recording only uses relaxed atomics, so
+ *         it can be called by all threads on the hot path.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class LatencyHistogram
+{
+public:
+    static const unsigned int subBucketBits = 3;
+    static const size_t numberOfSubBuckets = 1 << subBucketBits;
+    // exact buckets for the values below numberOfSubBuckets, then numberOfSubBuckets per power of two up to 2^64
+    static const size_t numberOfBuckets = numberOfSubBuckets + (64 - subBucketBits) * numberOfSubBuckets;
+
+    struct Snapshot
+    {
+        uint64_t count;
+        uint64_t sumNs;
+        uint64_t maxNs;
+        std::array<uint64_t, numberOfBuckets> buckets;
+
+        /**
+         * Get the latency below which a percentage of the recorded latencies are
+         *
+         * @param percentile the percentage between 0 and 100
+         * @return the upper bound of the bucket that contains the percentile, 0 without latencies
+         */
+        uint64_t getValueAtPercentile(double percentile) const;
+    };
+
+    LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram &other) = delete;
+
+    LatencyHistogram &operator=(const LatencyHistogram &other) = delete;
+
+    void record(uint64_t latencyNs);
+    Snapshot getSnapshot() const;
+    void reset();
+
+    static size_t getBucketIndex(uint64_t latencyNs);
+
+    /**
+     * Get the largest latency that is counted in a bucket
+     *
+     * @param index the index of the bucket
+     * @return the inclusive upper bound of the bucket in ns
+     */
+    static uint64_t getBucketUpperBound(size_t index);
+
+private:
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sumNs;
+    std::atomic<uint64_t> m_maxNs;
+    std::array<std::atomic<uint64_t>, numberOfBuckets> m_buckets;
+};
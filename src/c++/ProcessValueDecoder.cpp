@@ -0,0 +1,270 @@
+/*!
+ * @file   ProcessValueDecoder.cpp
+ *
+ * @brief  This class decodes process values and the error code of their metadata out of a snapshot of a shared memory buffer.
+ *
+ */
+
+#include "ProcessValueDecoder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    template <typename T>
+    T readFromSnapshot(const char *pSnapshot, size_t snapshotOffset, size_t offset)
+    {
+        T value;
+        memcpy(&value, pSnapshot + (offset - snapshotOffset), sizeof(T));
+        return value;
+    }
+
+    // error codes stored inside of Double and Float values without metadata
+    const uint32_t maxErrorCodeInValue = 9;
+
+    template <typename To, typename From>
+    To bitCast(From value)
+    {
+        static_assert(sizeof(To) == sizeof(From), "bitCast requires types of the same size");
+        To result;
+        memcpy(&result, &value, sizeof(To));
+        return result;
+    }
+
+    const char *const valueTypeNames[] = {
+        "Char",
+        "UnsignedChar",
+        "ShortInteger",
+        "UnsignedShortInteger",
+        "Integer",
+        "UnsignedInteger",
+        "LongLong",
+        "UnsignedLongLong",
+        "Double",
+        "Float",
+        "Boolean",
+        "Bit",
+        "String",
+        "Selection",
+        "Selector",
+    };
+}
+
+const char *ProcessValueDecoder::getValueTypeName(ValueType type)
+{
+    return valueTypeNames[static_cast<int>(type)];
+}
+
+bool ProcessValueDecoder::isValidValueType(int32_t type)
+{
+    return (type >= 0) && (type < static_cast<int32_t>(ValueType::numberOfValueTypes));
+}
+
+bool ProcessValueDecoder::isSupportedMetadataSize(size_t metadataSize)
+{
+    // 0: no metadata, 3: 1 byte error and 2 bytes state, 4: legacy 32-bit error, 8: 32-bit error and 32-bit state
+    return metadataSize == 0 || metadataSize == 3 || metadataSize == 4 || metadataSize == 8;
+}
+
+size_t ProcessValueDecoder::getSizeOfValue(const Descriptor &descriptor)
+{
+    switch (descriptor.type)
+    {
+    case ValueType::Char:
+    case ValueType::UnsignedChar:
+    case ValueType::Bit:
+        return 1;
+    case ValueType::ShortInteger:
+    case ValueType::UnsignedShortInteger:
+        return 2;
+    case ValueType::Integer:
+    case ValueType::UnsignedInteger:
+    case ValueType::Float:
+        return 4;
+    case ValueType::LongLong:
+    case ValueType::UnsignedLongLong:
+    case ValueType::Double:
+        return 8;
+    case ValueType::Boolean:
+        return descriptor.size == 1 ? 1 : 4;
+    default:
+        return descriptor.size;
+    }
+}
+
+size_t ProcessValueDecoder::getSnapshotRange(const std::vector<Descriptor> &descriptors, size_t &start)
+{
+    start = descriptors.empty() ? 0 : SIZE_MAX;
+    size_t end = 0;
+    for (const auto &descriptor : descriptors)
+    {
+        start = std::min(start, descriptor.offset);
+        end = std::max(end, descriptor.offset + getSizeOfValue(descriptor));
+        if (descriptor.metadataSize > 0)
+        {
+            start = std::min(start, descriptor.metadataOffset);
+            end = std::max(end, descriptor.metadataOffset + descriptor.metadataSize);
+        }
+    }
+    return end - start;
+}
+
+void ProcessValueDecoder::decode(const char *pSnapshot, size_t snapshotOffset, const Descriptor &descriptor, DecodedValue &decodedValue)
+{
+    const size_t offset = descriptor.offset;
+
+    switch (descriptor.type)
+    {
+    case ValueType::Char:
+        decodedValue.kind = DecodedKind::signedInteger;
+        decodedValue.signedValue = readFromSnapshot<int8_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::UnsignedChar:
+        decodedValue.kind = DecodedKind::unsignedInteger;
+        decodedValue.unsignedValue = readFromSnapshot<uint8_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::ShortInteger:
+        decodedValue.kind = DecodedKind::signedInteger;
+        decodedValue.signedValue = readFromSnapshot<int16_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::UnsignedShortInteger:
+        decodedValue.kind = DecodedKind::unsignedInteger;
+        decodedValue.unsignedValue = readFromSnapshot<uint16_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::Integer:
+        decodedValue.kind = DecodedKind::signedInteger;
+        decodedValue.signedValue = readFromSnapshot<int32_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::UnsignedInteger:
+        decodedValue.kind = DecodedKind::unsignedInteger;
+        decodedValue.unsignedValue = readFromSnapshot<uint32_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::LongLong:
+        decodedValue.kind = DecodedKind::bigSignedInteger;
+        decodedValue.signedValue = readFromSnapshot<int64_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::UnsignedLongLong:
+        decodedValue.kind = DecodedKind::bigUnsignedInteger;
+        decodedValue.unsignedValue = readFromSnapshot<uint64_t>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::Double:
+        decodedValue.kind = DecodedKind::floatingPoint;
+        decodedValue.floatingPointValue = readFromSnapshot<double>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::Float:
+        decodedValue.kind = DecodedKind::floatingPoint;
+        decodedValue.floatingPointValue = readFromSnapshot<float>(pSnapshot, snapshotOffset, offset);
+        break;
+    case ValueType::Boolean:
+        decodedValue.kind = DecodedKind::boolean;
+        decodedValue.booleanValue = (descriptor.size == 1) ? readFromSnapshot<uint8_t>(pSnapshot, snapshotOffset, offset) != 0
+                                                           : readFromSnapshot<uint32_t>(pSnapshot, snapshotOffset, offset) != 0;
+        break;
+    case ValueType::Bit:
+        decodedValue.kind = DecodedKind::boolean;
+        decodedValue.booleanValue = (readFromSnapshot<uint8_t>(pSnapshot, snapshotOffset, offset) & descriptor.bitMask) != 0;
+        break;
+    default:
+    {
+        // String, Selection and Selector are NUL terminated inside of their size, assign reuses the capacity of the previous text
+        const char *pText = pSnapshot + (offset - snapshotOffset);
+        const void *pTerminator = memchr(pText, '\0', descriptor.size);
+        decodedValue.kind = DecodedKind::text;
+        decodedValue.textValue.assign(pText, pTerminator != nullptr ? static_cast<const char *>(pTerminator) - pText : descriptor.size);
+        break;
+    }
+    }
+
+    decodedValue.hasErrorCode = decodeErrorCode(pSnapshot, snapshotOffset, descriptor, decodedValue.errorCode);
+}
+
+bool ProcessValueDecoder::isSameValue(const DecodedValue &first, const DecodedValue &second)
+{
+    if (first.kind != second.kind || first.hasErrorCode != second.hasErrorCode || first.errorCode != second.errorCode)
+    {
+        return false;
+    }
+
+    switch (first.kind)
+    {
+    case DecodedKind::signedInteger:
+    case DecodedKind::bigSignedInteger:
+        return first.signedValue == second.signedValue;
+    case DecodedKind::unsignedInteger:
+    case DecodedKind::bigUnsignedInteger:
+        return first.unsignedValue == second.unsignedValue;
+    case DecodedKind::floatingPoint:
+        return memcmp(&first.floatingPointValue, &second.floatingPointValue, sizeof(double)) == 0;
+    case DecodedKind::boolean:
+        return first.booleanValue == second.booleanValue;
+    default:
+        return first.textValue == second.textValue;
+    }
+}
+
+bool ProcessValueDecoder::decodeErrorCode(const char *pSnapshot, size_t snapshotOffset, const Descriptor &descriptor, uint32_t &errorCode)
+{
+    errorCode = 0;
+    switch (descriptor.metadataSize)
+    {
+    case 8:
+        // standard case: metadata containing a 32-bit error code and a 32-bit state (ignoring the state for now)
+    case 4:
+        // legacy case: metadata containing a 32-bit error code without state information (Jupiter Version < 9)
+        errorCode = readFromSnapshot<uint32_t>(pSnapshot, snapshotOffset, descriptor.metadataOffset);
+        return true;
+    case 3:
+        // reduced size metadata containing 1 byte for error and 2 bytes for state (ignoring the state for now)
+        errorCode = readFromSnapshot<uint8_t>(pSnapshot, snapshotOffset, descriptor.metadataOffset);
+        return true;
+    case 0:
+        // legacy devices store the error code of floating point values without metadata inside of the value
+        if (descriptor.type == ValueType::Double)
+        {
+            errorCode = getErrorCodeFromDouble(readFromSnapshot<uint64_t>(pSnapshot, snapshotOffset, descriptor.offset));
+            return true;
+        }
+        if (descriptor.type == ValueType::Float)
+        {
+            errorCode = getErrorCodeFromFloat(readFromSnapshot<uint32_t>(pSnapshot, snapshotOffset, descriptor.offset));
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+uint32_t ProcessValueDecoder::getErrorCodeFromDouble(uint64_t bits)
+{
+    const uint64_t exponent = (bits >> 52) & 0x7FF;
+    const uint64_t mantissa = bits & 0xFFFFFFFFFFFFFULL;
+
+    // a NaN with the error code in the mantissa, other NaNs and infinity are valid values
+    if (exponent == 0x7FF && mantissa <= maxErrorCodeInValue)
+    {
+        return static_cast<uint32_t>(mantissa);
+    }
+    return 0;
+}
+
+uint32_t ProcessValueDecoder::getErrorCodeFromFloat(uint32_t bits)
+{
+    // the floats nearest to 1e37 ... 9e37, like the values written by the devices
+    static const uint32_t errorBits[maxErrorCodeInValue] = {
+        bitCast<uint32_t>(static_cast<float>(1e37)), bitCast<uint32_t>(static_cast<float>(2e37)), bitCast<uint32_t>(static_cast<float>(3e37)),
+        bitCast<uint32_t>(static_cast<float>(4e37)), bitCast<uint32_t>(static_cast<float>(5e37)), bitCast<uint32_t>(static_cast<float>(6e37)),
+        bitCast<uint32_t>(static_cast<float>(7e37)), bitCast<uint32_t>(static_cast<float>(8e37)), bitCast<uint32_t>(static_cast<float>(9e37)),
+    };
+
+    for (uint32_t i = 0; i < maxErrorCodeInValue; i++)
+    {
+        if (bits == errorBits[i])
+        {
+            return i + 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*!
+ * @file   ProcessValueDecoder.hpp
+ *
+ * @brief  This class decodes process values and the error code of their metadata out of a snapshot of a shared memory buffer.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ProcessValueDecoder
+{
+public:
+    // the type codes are exported to JS as valueTypes, the order must not be changed
+    enum class ValueType
+    {
+        Char,
+        UnsignedChar,
+        ShortInteger,
+        UnsignedShortInteger,
+        Integer,
+        UnsignedInteger,
+        LongLong,
+        UnsignedLongLong,
+        Double,
+        Float,
+        Boolean,
+        Bit,
+        String,
+        Selection,
+        Selector,
+        numberOfValueTypes
+    };
+
+    // offsets are relative to the start of the current buffer
+    struct Descriptor
+    {
+        size_t offset;
+        ValueType type;
+        size_t size;
+        uint8_t bitMask;
+        size_t metadataOffset;
+        size_t metadataSize;
+    };
+
+    enum class DecodedKind
+    {
+        signedInteger,
+        unsignedInteger,
+        bigSignedInteger,
+        bigUnsignedInteger,
+        floatingPoint,
+        boolean,
+        text
+    };
+
+    struct DecodedValue
+    {
+        DecodedKind kind;
+        union
+        {
+            int64_t signedValue;
+            uint64_t unsignedValue;
+            double floatingPointValue;
+            bool booleanValue;
+        };
+        std::string textValue;
+        // the error code is only valid if the value has one, in the metadata or in the value itself
+        bool hasErrorCode;
+        uint32_t errorCode;
+    };
+
+    static const char *getValueTypeName(ValueType type);
+    static bool isValidValueType(int32_t type);
+    static bool isSupportedMetadataSize(size_t metadataSize);
+
+    /**
+     * Get the number of bytes a value occupies in the shared memory
+     *
+     * @param descriptor the description of the value
+     * @return the size of the value
+     */
+    static size_t getSizeOfValue(const Descriptor &descriptor);
+
+    /**
+     * Get the range of the current buffer that covers all values and their metadata
+     *
+     * @param descriptors the descriptions of the values, at least one
+     * @param start the start of the range relative to the start of the current buffer
+     * @return the length of the range, 0 without descriptors
+     */
+    static size_t getSnapshotRange(const std::vector<Descriptor> &descriptors, size_t &start);
+
+    /**
+     * Decode a value and its error code. The error code is taken out of the metadata, values without metadata of the
+     * types Double and Float carry it inside of the value itself. Texts end at the first NUL.
+     *
+     * @param pSnapshot the snapshot of the current buffer
+     * @param snapshotOffset the offset of the snapshot relative to the start of the current buffer
+     * @param descriptor the description of the value
+     * @param decodedValue the decoded value
+     */
+    static void decode(const char *pSnapshot, size_t snapshotOffset, const Descriptor &descriptor, DecodedValue &decodedValue);
+
+    /**
+     * Compare two decoded values including their error code. Floating point values are compared bitwise,
+     * so an unchanged NaN is the same value.
+     *
+     * @param first the first value
+     * @param second the second value
+     * @return true if both values are the same
+     */
+    static bool isSameValue(const DecodedValue &first, const DecodedValue &second);
+
+    /**
+     * Get the error code of a Double without metadata. Legacy devices store it as NaN with the error code in the
+     * mantissa.
+     *
+     * @param bits the bits of the double
+     * @return the error code between 1 and 9 or 0 for a valid value and an unknown NaN
+     */
+    static uint32_t getErrorCodeFromDouble(uint64_t bits);
+
+    /**
+     * Get the error code of a Float without metadata. Legacy devices store it as the error code times 1e37.
+     *
+     * @param bits the bits of the float
+     * @return the error code between 1 and 9 or 0 for a valid value
+     */
+    static uint32_t getErrorCodeFromFloat(uint32_t bits);
+
+private:
+    static bool decodeErrorCode(const char *pSnapshot, size_t snapshotOffset, const Descriptor &descriptor, uint32_t &errorCode);
+};
@@ -0,0 +1,140 @@
+/*!
+ * @file   ProcessValueEncoder.cpp
+ *
+ * @brief  This class encodes process values into the byte representation of the shared memory.
+ *
+ */
+
+#include "ProcessValueEncoder.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    template <typename T>
+    void writeToDestination(T value, char *destination, size_t &length)
+    {
+        // the shared memory uses the byte order of the system, which is little endian on all variTRON devices
+        memcpy(destination, &value, sizeof(T));
+        length = sizeof(T);
+    }
+
+    template <typename T>
+    ProcessValueEncoder::Result encodeIntegral(double value, char *destination, size_t &length)
+    {
+        // the bounds are powers of two and therefore exact as double, the upper bound is exclusive
+        const double lowerBound = static_cast<double>(std::numeric_limits<T>::min());
+        const double upperBound = std::ldexp(1.0, std::numeric_limits<T>::digits);
+
+        if (std::trunc(value) != value || value < lowerBound || value >= upperBound)
+        {
+            return ProcessValueEncoder::Result::outOfRange;
+        }
+        writeToDestination(static_cast<T>(value), destination, length);
+        return ProcessValueEncoder::Result::ok;
+    }
+
+    template <typename T, typename V>
+    ProcessValueEncoder::Result encodeIntegral(V value, char *destination, size_t &length)
+    {
+        using Limits = std::numeric_limits<T>;
+
+        // compare in the type of the value, only the side that can overflow has to be checked
+        if (std::numeric_limits<V>::is_signed && value < 0)
+        {
+            if (!Limits::is_signed || static_cast<int64_t>(value) < static_cast<int64_t>(Limits::min()))
+            {
+                return ProcessValueEncoder::Result::outOfRange;
+            }
+        }
+        else if (static_cast<uint64_t>(value) > static_cast<uint64_t>(Limits::max()))
+        {
+            return ProcessValueEncoder::Result::outOfRange;
+        }
+        writeToDestination(static_cast<T>(value), destination, length);
+        return ProcessValueEncoder::Result::ok;
+    }
+
+    template <typename V>
+    ProcessValueEncoder::Result encodeInteger(ProcessValueEncoder::ValueType type, V value, char *destination, size_t &length)
+    {
+        using ValueType = ProcessValueEncoder::ValueType;
+
+        switch (type)
+        {
+        case ValueType::Char:
+            return encodeIntegral<int8_t>(value, destination, length);
+        case ValueType::UnsignedChar:
+            return encodeIntegral<uint8_t>(value, destination, length);
+        case ValueType::ShortInteger:
+            return encodeIntegral<int16_t>(value, destination, length);
+        case ValueType::UnsignedShortInteger:
+            return encodeIntegral<uint16_t>(value, destination, length);
+        case ValueType::Integer:
+            return encodeIntegral<int32_t>(value, destination, length);
+        case ValueType::UnsignedInteger:
+            return encodeIntegral<uint32_t>(value, destination, length);
+        case ValueType::LongLong:
+            return encodeIntegral<int64_t>(value, destination, length);
+        case ValueType::UnsignedLongLong:
+            return encodeIntegral<uint64_t>(value, destination, length);
+        default:
+            return ProcessValueEncoder::Result::unsupportedType;
+        }
+    }
+}
+
+ProcessValueEncoder::Result ProcessValueEncoder::encodeNumber(ValueType type, size_t size, double value, char *destination, size_t &length)
+{
+    switch (type)
+    {
+    case ValueType::Double:
+        writeToDestination(value, destination, length);
+        return Result::ok;
+    case ValueType::Float:
+        if (std::isfinite(value) && std::fabs(value) > FLT_MAX)
+        {
+            return Result::outOfRange;
+        }
+        writeToDestination(static_cast<float>(value), destination, length);
+        return Result::ok;
+    case ValueType::Boolean:
+        if (size == 1)
+        {
+            writeToDestination(static_cast<uint8_t>(value != 0), destination, length);
+        }
+        else
+        {
+            writeToDestination(static_cast<uint32_t>(value != 0), destination, length);
+        }
+        return Result::ok;
+    default:
+        return encodeInteger(type, value, destination, length);
+    }
+}
+
+ProcessValueEncoder::Result ProcessValueEncoder::encodeSignedInteger(ValueType type, int64_t value, char *destination, size_t &length)
+{
+    return encodeInteger(type, value, destination, length);
+}
+
+ProcessValueEncoder::Result ProcessValueEncoder::encodeUnsignedInteger(ValueType type, uint64_t value, char *destination, size_t &length)
+{
+    return encodeInteger(type, value, destination, length);
+}
+
+const char *ProcessValueEncoder::getResultText(Result result)
+{
+    switch (result)
+    {
+    case Result::ok:
+        return "ok";
+    case Result::unsupportedType:
+        return "the type can't be encoded";
+    default:
+        return "the value is out of the range of the type";
+    }
+}
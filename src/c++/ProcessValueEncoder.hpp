@@ -0,0 +1,65 @@
+/*!
+ * @file   ProcessValueEncoder.hpp
+ *
+ * @brief  This class encodes process values into the byte representation of the shared memory.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ProcessValueDecoder.hpp"
+
+class ProcessValueEncoder
+{
+public:
+    using ValueType = ProcessValueDecoder::ValueType;
+
+    enum class Result
+    {
+        ok,
+        unsupportedType,
+        outOfRange
+    };
+
+    // the largest encoded value, big enough for every numeric type
+    static const size_t maxSizeOfValue = 8;
+
+    /**
+     * Encode a number. Integer types require an integral value inside of their range.
+     *
+     * @param type the type of the value
+     * @param size the size of the value out of the description, needed for Boolean
+     * @param value the value to encode
+     * @param destination the destination with at least maxSizeOfValue bytes
+     * @param length the number of encoded bytes
+     * @return ok or the reason why the value can't be encoded
+     */
+    static Result encodeNumber(ValueType type, size_t size, double value, char *destination, size_t &length);
+
+    /**
+     * Encode a signed 64-bit integer, e.g. a JS BigInt, without the precision loss of a double
+     *
+     * @param type the type of the value, must be an integer type
+     * @param value the value to encode
+     * @param destination the destination with at least maxSizeOfValue bytes
+     * @param length the number of encoded bytes
+     * @return ok or the reason why the value can't be encoded
+     */
+    static Result encodeSignedInteger(ValueType type, int64_t value, char *destination, size_t &length);
+
+    /**
+     * Encode an unsigned 64-bit integer, e.g. a JS BigInt, without the precision loss of a double
+     *
+     * @param type the type of the value, must be an integer type
+     * @param value the value to encode
+     * @param destination the destination with at least maxSizeOfValue bytes
+     * @param length the number of encoded bytes
+     * @return ok or the reason why the value can't be encoded
+     */
+    static Result encodeUnsignedInteger(ValueType type, uint64_t value, char *destination, size_t &length);
+
+    static const char *getResultText(Result result);
+};
@@ -0,0 +1,131 @@
+/*!
+ * @file   SampleRing.cpp
+ *
+ * @brief  This class is a lock-free ring buffer of fixed size records for one producer thread and one consumer, which
+ *         is either a native thread or JS.
+ *
+ */
+
+#include "SampleRing.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace
+{
+    const size_t cacheLineSize = 64;
+
+    // the counters wrap around at 2^32, the capacity must stay below to tell a full from an empty ring buffer
+    const size_t maximalCapacity = size_t(1) << 30;
+
+    uint32_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value && result < maximalCapacity)
+        {
+            result <<= 1;
+        }
+        return static_cast<uint32_t>(result);
+    }
+}
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "The fields of the ring buffer are shared with JS and need to be plain lock-free 32 bit words");
+
+SampleRing::SampleRing(size_t recordSize, size_t capacity)
+    : m_recordSize(recordSize),
+      m_mask(roundUpToPowerOfTwo(capacity) - 1),
+      m_size(recordsOffset + recordSize * (static_cast<size_t>(m_mask) + 1)),
+      m_pData(nullptr)
+{
+    void *pData = nullptr;
+    if (posix_memalign(&pData, cacheLineSize, m_size) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    m_pData = static_cast<char *>(pData);
+    memset(m_pData, 0, recordsOffset);
+
+    getField(recordSizeOffset).store(static_cast<uint32_t>(m_recordSize), std::memory_order_relaxed);
+    getField(capacityOffset).store(m_mask + 1, std::memory_order_relaxed);
+}
+
+SampleRing::~SampleRing()
+{
+    free(m_pData);
+}
+
+bool SampleRing::tryPush(const char *pRecord)
+{
+    std::atomic<uint32_t> &head = getField(headOffset);
+    const uint32_t position = head.load(std::memory_order_relaxed);
+    if (position - getField(tailOffset).load(std::memory_order_acquire) > m_mask)
+    {
+        getField(droppedRecordsOffset).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    memcpy(m_pData + recordsOffset + (position & m_mask) * m_recordSize, pRecord, m_recordSize);
+    // publish the record after it has been copied
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool SampleRing::tryPop(char *pRecord)
+{
+    std::atomic<uint32_t> &tail = getField(tailOffset);
+    const uint32_t position = tail.load(std::memory_order_relaxed);
+    if (position == getField(headOffset).load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    memcpy(pRecord, m_pData + recordsOffset + (position & m_mask) * m_recordSize, m_recordSize);
+    // release the slot after the record has been copied out
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool SampleRing::requestWakeup()
+{
+    // the consumer clears the flag and then reads head, the fence orders the pushed head before the flag, so either
+    // the consumer sees the new records or the producer sees the cleared flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return getField(wakeupOffset).exchange(1, std::memory_order_seq_cst) == 0;
+}
+
+void SampleRing::cancelWakeup()
+{
+    getField(wakeupOffset).store(0, std::memory_order_seq_cst);
+}
+
+size_t SampleRing::getRecordSize() const
+{
+    return m_recordSize;
+}
+
+size_t SampleRing::getCapacity() const
+{
+    return static_cast<size_t>(m_mask) + 1;
+}
+
+uint32_t SampleRing::getDroppedRecords() const
+{
+    return getField(droppedRecordsOffset).load(std::memory_order_relaxed);
+}
+
+char *SampleRing::getData() const
+{
+    return m_pData;
+}
+
+size_t SampleRing::getSize() const
+{
+    return m_size;
+}
+
+std::atomic<uint32_t> &SampleRing::getField(size_t offset) const
+{
+    return *reinterpret_cast<std::atomic<uint32_t> *>(m_pData + offset);
+}
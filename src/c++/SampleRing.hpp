@@ -0,0 +1,98 @@
+/*!
+ * @file   SampleRing.hpp
+ *
+ * @brief  This class is a lock-free ring buffer of fixed size records for one producer thread and one consumer, which
+ *         is either a native thread or JS.
+ *
+ * The ring buffer lives in one block of memory, which can be exposed to JS as an ArrayBuffer. JS accesses the indices
+ * with Atomics on an Int32Array of the block. Each index is on its own cache line:
+ *   word  0 (byte   0)  head, the number of records pushed by the producer
+ *   word 16 (byte  64)  tail, the number of records popped by the consumer
+ *   word 32 (byte 128)  wakeup flag, set by the producer when the consumer has to be woken up, cleared by the consumer
+ *   word 48 (byte 192)  number of records dropped because the ring buffer was full
+ *   word 49             size of a record in bytes
+ *   word 50             capacity in records, a power of two
+ *   byte 256            the records
+ * The indices are 32 bit counters that wrap around, the number of stored records is head - tail modulo 2^32.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class SampleRing
+{
+public:
+    // byte offsets of the fields in the block, exported to JS
+    static const size_t headOffset = 0;
+    static const size_t tailOffset = 64;
+    static const size_t wakeupOffset = 128;
+    static const size_t droppedRecordsOffset = 192;
+    static const size_t recordSizeOffset = 196;
+    static const size_t capacityOffset = 200;
+    static const size_t recordsOffset = 256;
+
+    /**
+     * Create a ring buffer
+     *
+     * @param recordSize the size of a record in bytes
+     * @param capacity the minimal number of records, rounded up to a power of two
+     */
+    SampleRing(size_t recordSize, size_t capacity);
+    SampleRing(const SampleRing &other) = delete;
+    ~SampleRing();
+
+    SampleRing &operator=(const SampleRing &other) = delete;
+
+    /**
+     * Copy a record into the ring buffer, only called by the producer thread. A record that does not fit is counted
+     * as dropped.
+     *
+     * @param pRecord the record with recordSize bytes
+     * @return false if the ring buffer is full
+     */
+    bool tryPush(const char *pRecord);
+
+    /**
+     * Copy the oldest record out of the ring buffer, only called by a native consumer thread
+     *
+     * @param pRecord the destination with recordSize bytes
+     * @return false if the ring buffer is empty
+     */
+    bool tryPop(char *pRecord);
+
+    /**
+     * Set the wakeup flag after records have been pushed, only called by the producer thread. The consumer clears the
+     * flag before it drains the ring buffer, so a batch of records needs a single wakeup.
+     *
+     * @return true if the flag was clear and the consumer has to be woken up
+     */
+    bool requestWakeup();
+
+    /**
+     * Clear the wakeup flag if the wakeup could not be delivered, so the next push requests it again
+     */
+    void cancelWakeup();
+
+    size_t getRecordSize() const;
+    size_t getCapacity() const;
+    uint32_t getDroppedRecords() const;
+
+    /**
+     * Get the block of memory with the indices and the records, e.g. to expose it to JS
+     *
+     * @return the block
+     */
+    char *getData() const;
+    size_t getSize() const;
+
+private:
+    std::atomic<uint32_t> &getField(size_t offset) const;
+
+    const size_t m_recordSize;
+    const uint32_t m_mask;
+    const size_t m_size;
+    char *m_pData;
+};
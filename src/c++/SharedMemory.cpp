@@ -1,4 +1,11 @@
 #include "SharedMemory.hpp"
+#include "DescriptionRegistry.hpp"
+#include "ProcessValueEncoder.hpp"
+#include "SharedMemoryReadWorker.hpp"
+#include "SharedMemoryRecorder.hpp"
+#include "SharedMemoryWatcher.hpp"
+#include "SharedMemoryWriteWorker.hpp"
+#include "SnapshotDiff.hpp"
 #include <v8.h>
 #include <node.h>
 #include <node_buffer.h>
@@ -9,6 +16,9 @@
 #include <sys/shm.h>
 #include <string>
 #include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
 
 #include <unistd.h>
 #include <semaphore.h>
@@ -18,27 +28,19 @@
 #include <sys/stat.h>
 #include <sys/fcntl.h>
 
-#include <ck_sequence.h>
-
 using namespace v8;
 using namespace std;
 
-std::string getErrnoAsString()
-{
-    return strerror(errno);
-}
-
-enum class ActiveBuffer
-{
-    buffer1,
-    buffer2
-};
+// number of Int32Array elements per value in the descriptor table of readMany
+const size_t descriptorTableStride = 6;
 
-struct ManagementBuffer
+struct SharedMemory::InstanceData
 {
-    ActiveBuffer activeReadBuffer;
-    ActiveBuffer activeWriteBuffer;
-    ck_sequence_t seqlock;
+    Napi::FunctionReference constructor;
+    std::shared_ptr<std::set<SharedMemory *>> instances;
+    // notifies the thread about the shared descriptions it waits for
+    Napi::ThreadSafeFunction descriptionListener;
+    bool hasDescriptionListener = false;
 };
 
 void SharedMemory::init(Napi::Env env, Napi::Object &exports)
@@ -46,64 +48,134 @@ void SharedMemory::init(Napi::Env env, Napi::Object &exports)
     Napi::Function func = DefineClass(env, "SharedMemory", {
                                                                 InstanceMethod("writeByte", &SharedMemory::writeByte, napi_enumerable),
                                                                 InstanceMethod("write", &SharedMemory::writeData, napi_enumerable),
+                                                                InstanceMethod("writeMany", &SharedMemory::writeMany, napi_enumerable),
+                                                                InstanceMethod("writeManyAsync", &SharedMemory::writeManyAsync, napi_enumerable),
+                                                                InstanceMethod("writeTyped", &SharedMemory::writeTyped, napi_enumerable),
                                                                 InstanceMethod("readBuffer", &SharedMemory::readBuffer, napi_enumerable),
+                                                                InstanceMethod("readRange", &SharedMemory::readRange, napi_enumerable),
+                                                                InstanceMethod("readMany", &SharedMemory::readMany, napi_enumerable),
+                                                                InstanceMethod("readAsync", &SharedMemory::readAsync, napi_enumerable),
+                                                                InstanceMethod("snapshotRange", &SharedMemory::snapshotRange, napi_enumerable),
+                                                                InstanceMethod("mapView", &SharedMemory::mapView, napi_enumerable),
+                                                                InstanceMethod("snapshotVersion", &SharedMemory::snapshotVersion, napi_enumerable),
+                                                                InstanceMethod("validate", &SharedMemory::validate, napi_enumerable),
+                                                                InstanceMethod("currentBufferOffset", &SharedMemory::currentBufferOffset, napi_enumerable),
+                                                                InstanceMethod("setReadTimeout", &SharedMemory::setReadTimeout, napi_enumerable),
+                                                                InstanceMethod("setLockTimeout", &SharedMemory::setLockTimeout, napi_enumerable),
+                                                                InstanceMethod("getLockStatistics", &SharedMemory::getLockStatistics, napi_enumerable),
+                                                                InstanceMethod("getStats", &SharedMemory::getStats, napi_enumerable),
+                                                                InstanceMethod("resetStats", &SharedMemory::resetStats, napi_enumerable),
+                                                                InstanceMethod("watch", &SharedMemory::watch, napi_enumerable),
+                                                                InstanceMethod("watchBatched", &SharedMemory::watchBatched, napi_enumerable),
+                                                                InstanceMethod("unwatch", &SharedMemory::unwatch, napi_enumerable),
+                                                                InstanceMethod("startRecording", &SharedMemory::startRecording, napi_enumerable),
+                                                                InstanceMethod("stopRecording", &SharedMemory::stopRecording, napi_enumerable),
+                                                                InstanceMethod("getRecordingStatistics", &SharedMemory::getRecordingStatistics, napi_enumerable),
+                                                                InstanceMethod("close", &SharedMemory::close, napi_enumerable),
                                                                 InstanceAccessor("buffer", &SharedMemory::readBuffer, &SharedMemory::setBuffer, napi_enumerable),
                                                             });
 
-    auto constructor = new Napi::FunctionReference();
-    *constructor = Napi::Persistent(func);
+    auto pInstanceData = new InstanceData();
+    pInstanceData->constructor = Napi::Persistent(func);
+    pInstanceData->instances = std::make_shared<std::set<SharedMemory *>>();
 
     exports.Set("SharedMemory", func);
-    env.SetInstanceData<Napi::FunctionReference>(constructor);
+
+    // type codes and layout of the descriptor table used by readMany
+    Napi::Object valueTypes = Napi::Object::New(env);
+    for (int type = 0; type < static_cast<int>(ProcessValueDecoder::ValueType::numberOfValueTypes); type++)
+    {
+        valueTypes.Set(ProcessValueDecoder::getValueTypeName(static_cast<ProcessValueDecoder::ValueType>(type)), Napi::Number::New(env, type));
+    }
+    exports.Set("valueTypes", valueTypes);
+    exports.Set("descriptorTableStride", Napi::Number::New(env, descriptorTableStride));
+
+    // layout of the ring buffers of watchBatched
+    Napi::Object sampleRingLayout = Napi::Object::New(env);
+    sampleRingLayout.Set("headOffset", Napi::Number::New(env, SampleRing::headOffset));
+    sampleRingLayout.Set("tailOffset", Napi::Number::New(env, SampleRing::tailOffset));
+    sampleRingLayout.Set("wakeupOffset", Napi::Number::New(env, SampleRing::wakeupOffset));
+    sampleRingLayout.Set("droppedRecordsOffset", Napi::Number::New(env, SampleRing::droppedRecordsOffset));
+    sampleRingLayout.Set("recordSizeOffset", Napi::Number::New(env, SampleRing::recordSizeOffset));
+    sampleRingLayout.Set("capacityOffset", Napi::Number::New(env, SampleRing::capacityOffset));
+    sampleRingLayout.Set("recordsOffset", Napi::Number::New(env, SampleRing::recordsOffset));
+    sampleRingLayout.Set("changeRecordHeaderSize", Napi::Number::New(env, SharedMemoryWatcher::changeRecordHeaderSize));
+    sampleRingLayout.Set("changeRecordHasErrorCode", Napi::Number::New(env, SharedMemoryWatcher::changeRecordHasErrorCode));
+    exports.Set("sampleRingLayout", sampleRingLayout);
+    exports.Set("getMappingStatistics", Napi::Function::New(env, &SharedMemory::getMappingStatistics, "getMappingStatistics"));
+    exports.Set("diffSnapshots", Napi::Function::New(env, &SharedMemory::diffSnapshots, "diffSnapshots"));
+    exports.Set("getSharedDescription", Napi::Function::New(env, &SharedMemory::getSharedDescription, "getSharedDescription"));
+    exports.Set("claimSharedDescription", Napi::Function::New(env, &SharedMemory::claimSharedDescription, "claimSharedDescription"));
+    exports.Set("publishSharedDescription", Napi::Function::New(env, &SharedMemory::publishSharedDescription, "publishSharedDescription"));
+    exports.Set("releaseSharedDescription", Napi::Function::New(env, &SharedMemory::releaseSharedDescription, "releaseSharedDescription"));
+    exports.Set("setSharedDescriptionListener", Napi::Function::New(env, &SharedMemory::setSharedDescriptionListener, "setSharedDescriptionListener"));
+    exports.Set("snapshotDiffImplementation", Napi::String::New(env, SnapshotDiff::getImplementationName()));
+    env.SetInstanceData<InstanceData>(pInstanceData);
+
+    // a terminating worker thread stops the native threads of its instances before its environment is torn down
+    env.AddCleanupHook([pInstanceData]()
+                       { cleanUp(pInstanceData); });
+}
+
+void SharedMemory::cleanUp(InstanceData *pInstanceData)
+{
+    // release() doesn't unregister, the finalizers of the instances still run afterwards
+    for (SharedMemory *pInstance : *pInstanceData->instances)
+    {
+        pInstance->release();
+    }
+    DescriptionRegistry::removeListener(pInstanceData);
+    DescriptionRegistry::releaseAll(pInstanceData);
+    if (pInstanceData->hasDescriptionListener)
+    {
+        pInstanceData->descriptionListener.Release();
+        pInstanceData->hasDescriptionListener = false;
+    }
 }
 
 SharedMemory::SharedMemory(const Napi::CallbackInfo &info)
-    : ObjectWrap(info), m_semaphoreLock(info[3].ToString().Utf8Value(), static_cast<SystemVSemaphoreBaseClass::CreationType>(info[4].ToNumber().Int32Value()))
+    : ObjectWrap(info)
 {
     // CHECK_ARGS(napi_tools::string, napi_tools::number);
     std::string name = info[0].ToString().Utf8Value();
 
-    m_size = info[1].ToNumber().Int32Value();
-    if (m_size <= 0)
+    int64_t size = info[1].ToNumber().Int32Value();
+    if (size <= 0)
     {
         throw Napi::TypeError::New(info.Env(), "The buffer size must be greater than zero");
     }
 
-    Value().DefineProperties({Napi::PropertyDescriptor::Value("size", Napi::Number::From(info.Env(), m_size),
+    Value().DefineProperties({Napi::PropertyDescriptor::Value("size", Napi::Number::From(info.Env(), size),
                                                               napi_enumerable),
                               Napi::PropertyDescriptor::Value("name", info[0].ToString(),
                                                               napi_enumerable)});
 
-    m_isDoubleBuffer = info[2].ToBoolean();
+    SharedMemorySegment::BufferType bufferType = getBufferType(info[2]);
 
-    int shmFileDescriptor = shm_open(name.c_str(), O_RDWR, 0666);
+    // the size of a single buffer is needed to find the active half of a double buffer
+    size_t sizeOfSingleBuffer = (info.Length() > 5 && info[5].IsNumber()) ? info[5].As<Napi::Number>().Int64Value() : 0;
 
-    #ifdef DEBUG
-    std::cout << "(native) shmFileDescriptor " << shmFileDescriptor << " " << errno << endl;
-    #endif
-
-    if (shmFileDescriptor < 0)
+    try
     {
-        throw Napi::Error::New(info.Env(), "Could not get the shared memory segment: " + getErrnoAsString());
+        m_segment = std::make_shared<SharedMemorySegment>(name, size, bufferType, sizeOfSingleBuffer, info[3].ToString().Utf8Value(),
+                                                          static_cast<SystemVSemaphoreBaseClass::CreationType>(info[4].ToNumber().Int32Value()));
     }
-
-    const off_t offset = 0;
-    m_buffer = static_cast<char *>(mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFileDescriptor, offset));
-
-    #ifdef DEBUG
-    std::cout << "(native) buffer " << static_cast<void *>(buffer) << " " << errno << endl;
-    #endif
-
-    if (m_buffer == (char *)-1)
+    catch (const std::exception &e)
     {
-        throw Napi::Error::New(info.Env(), "Could not attach the shared memory segment: " + getErrnoAsString());
+        throw Napi::Error::New(info.Env(), e.what());
     }
 
     Value().DefineProperty(Napi::PropertyDescriptor::Value("id", Napi::Number::From(info.Env(), name), napi_enumerable));
+
+    m_strings = std::make_shared<StringInterner>();
+    m_instances = info.Env().GetInstanceData<InstanceData>()->instances;
+    m_instances->insert(this);
 }
 
 void SharedMemory::writeData(const Napi::CallbackInfo &info)
 {
+    checkOpen(info.Env());
+
     if (info.Length() < 3 || !info[1].IsNumber() || !info[2].IsNumber())
     {
         throw Napi::TypeError::New(info.Env(), "writeValue requires a value, an offset, and a length as arguments");
@@ -112,7 +184,7 @@ void SharedMemory::writeData(const Napi::CallbackInfo &info)
     size_t offset = info[1].As<Napi::Number>().Int64Value();
     size_t length = info[2].As<Napi::Number>().Int64Value();
 
-    if (offset + length > this->m_size)
+    if (offset + length > m_segment->getSize())
     {
         throw Napi::RangeError::New(info.Env(), "Offset and length exceed buffer size");
     }
@@ -125,38 +197,9 @@ void SharedMemory::writeData(const Napi::CallbackInfo &info)
             throw Napi::RangeError::New(info.Env(), "Value buffer length does not match the specified length");
         }
 
-        unsigned int counter = 0;
-        bool bRepetitionRequired = true;
-        const unsigned int maxWriteRetries = 10;
-
-        // try to write value for maxWriteRetries times
-        while (bRepetitionRequired && (counter <= maxWriteRetries))
-        {
-            if (m_semaphoreLock.lock())
-            {
-                memcpy(this->m_buffer + offset, buf.Data(), length);
-                if (m_semaphoreLock.unlock())
-                {
-                    bRepetitionRequired = false;
-                }
-                else
-                {
-                    #ifdef DEBUG
-                    std::cout << "C++: unable to unlock semaphore for writing" << std::endl;
-                    #endif
-                }
-            }
-            else
-            {
-                #ifdef DEBUG
-                std::cout << "C++: unable to lock semaphore for writing" << std::endl;
-                #endif
-            }
-            counter++;
-        }
-        if (bRepetitionRequired)
+        if (!m_segment->write(offset, buf.Data(), length))
         {
-            throw Napi::TypeError::New(info.Env(), "Unable to write value");
+            throw createLockError(info.Env(), "Unable to write value");
         }
     }
     else
@@ -167,6 +210,8 @@ void SharedMemory::writeData(const Napi::CallbackInfo &info)
 
 void SharedMemory::writeByte(const Napi::CallbackInfo &info)
 {
+    checkOpen(info.Env());
+
     Napi::Env env = info.Env();
 
     if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsBoolean() || !info[2].IsNumber())
@@ -179,141 +224,1198 @@ void SharedMemory::writeByte(const Napi::CallbackInfo &info)
     bool bitValue = info[1].As<Napi::Boolean>().Value();
     size_t offset = info[2].As<Napi::Number>().Uint32Value();
 
-    if (offset >= this->m_size)
+    if (offset >= m_segment->getSize())
     {
         Napi::RangeError::New(env, "Offset exceeds buffer size").ThrowAsJavaScriptException();
         return;
     }
 
-    unsigned int counter = 0;
-    bool bRepetitionRequired = true;
-    const unsigned int maxWriteRetries = 10;
+    if (!m_segment->writeBits(offset, bitmask, bitValue))
+    {
+        throw createLockError(info.Env(), "Unable to write value");
+    }
+}
+
+void SharedMemory::writeMany(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
 
-    while (bRepetitionRequired && (counter <= maxWriteRetries))
+    if (info.Length() < 1 || !info[0].IsArray())
     {
-        if (m_semaphoreLock.lock())
-        {
-            uint8_t currentValue = this->m_buffer[offset];
-            uint8_t newValue = bitValue ? (currentValue | bitmask) : (currentValue & ~bitmask);
-            const size_t length = 1;
-            memcpy(this->m_buffer + offset, &newValue, length);
+        throw Napi::TypeError::New(env, "writeMany requires an array of entries as argument");
+    }
 
-            if (m_semaphoreLock.unlock())
-            {
-                bRepetitionRequired = false;
-            }
-            else
-            {
-                #ifdef DEBUG
-                std::cout << "C++: unable to unlock semaphore for writing" << std::endl;
-                #endif
-            }
+    auto entries = info[0].As<Napi::Array>();
+    const uint32_t numberOfEntries = entries.Length();
+
+    // the encoded values must not move while the operations point to them
+    m_writeOperations.resize(numberOfEntries);
+    m_encodedValues.resize(numberOfEntries * ProcessValueEncoder::maxSizeOfValue);
+
+    // validate and encode all entries before the semaphore is taken
+    for (uint32_t i = 0; i < numberOfEntries; i++)
+    {
+        try
+        {
+            parseWriteOperation(entries.Get(i), m_encodedValues.data() + i * ProcessValueEncoder::maxSizeOfValue, m_writeOperations[i]);
         }
-        else
+        catch (const Napi::Error &e)
         {
-            #ifdef DEBUG
-            std::cout << "C++: unable to lock semaphore for writing" << std::endl;
-            #endif
+            throw Napi::TypeError::New(env, "Invalid entry " + std::to_string(i) + " of writeMany: " + e.Message());
         }
-        counter++;
     }
-    if (bRepetitionRequired)
+
+    if (numberOfEntries > 0 && !m_segment->writeMany(m_writeOperations))
     {
-        throw Napi::TypeError::New(info.Env(), "Unable to write value");
+        throw createLockError(env, "Unable to write values");
     }
 }
 
-Napi::Value SharedMemory::readBuffer(const Napi::CallbackInfo &info)
+Napi::Value SharedMemory::writeManyAsync(const Napi::CallbackInfo &info)
 {
-    ManagementBuffer *pManagmentBuffer = (ManagementBuffer *)m_buffer;
+    checkOpen(info.Env());
+
     Napi::Env env = info.Env();
 
-    auto buf = Napi::Buffer<char>::New(info.Env(), this->m_size);
-    const unsigned int maxReadRetries = 10;
-    unsigned int counter = 0;
-    bool bRepetitionRequired = true;
+    if (info.Length() < 1 || !info[0].IsArray())
+    {
+        throw Napi::TypeError::New(env, "writeManyAsync requires an array of entries as argument");
+    }
+
+    auto entries = info[0].As<Napi::Array>();
+    const uint32_t numberOfEntries = entries.Length();
 
-    if (m_isDoubleBuffer)
+    // the worker owns the encoded values, so they outlive this call
+    auto *pWorker = new SharedMemoryWriteWorker(env, m_segment, numberOfEntries, ProcessValueEncoder::maxSizeOfValue);
+
+    // validate and encode all entries on this thread, the worker only writes
+    for (uint32_t i = 0; i < numberOfEntries; i++)
     {
-        while (bRepetitionRequired && (counter <= maxReadRetries))
+        try
+        {
+            parseWriteOperation(entries.Get(i), pWorker->getEncodedValue(i), pWorker->getOperation(i));
+        }
+        catch (const Napi::Error &e)
         {
-            // ck_sequenz lock read
-            auto m_version = ck_sequence_read_begin(&pManagmentBuffer->seqlock);
+            delete pWorker;
+            throw Napi::TypeError::New(env, "Invalid entry " + std::to_string(i) + " of writeManyAsync: " + e.Message());
+        }
+    }
+
+    Napi::Promise promise = pWorker->getPromise();
+    pWorker->Queue();
+    return promise;
+}
+
+void SharedMemory::writeTyped(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[0].IsNumber() || !info[1].IsNumber() ||
+        !ProcessValueDecoder::isValidValueType(info[0].As<Napi::Number>().Int32Value()) || info[1].As<Napi::Number>().Int64Value() < 0)
+    {
+        throw Napi::TypeError::New(env, "writeTyped requires a type code, an offset and a value as arguments");
+    }
+
+    auto type = static_cast<ProcessValueDecoder::ValueType>(info[0].As<Napi::Number>().Int32Value());
+    const size_t size = info[3].IsNumber() ? info[3].As<Napi::Number>().Uint32Value() : 0;
+    const uint32_t bitMask = info[4].IsNumber() ? info[4].As<Napi::Number>().Uint32Value() : 0;
+    const size_t metadataSize = info[6].IsNumber() ? info[6].As<Napi::Number>().Uint32Value() : 0;
+
+    // the value and the zeroed metadata are encoded on the stack, the segment is only touched under the semaphore
+    char encoded[ProcessValueEncoder::maxSizeOfValue];
+    static const char zeroedMetadata[8] = {};
+    SharedMemorySegment::WriteOperation operations[2];
+    size_t numberOfOperations = 1;
 
-            // read value
-            memcpy(buf.Data(), this->m_buffer, this->m_size);
+    SharedMemorySegment::WriteOperation &operation = operations[0];
+    operation.offset = info[1].As<Napi::Number>().Int64Value();
+    operation.bitMask = 0;
+    operation.bitValue = false;
+    if (type == ProcessValueDecoder::ValueType::Bit)
+    {
+        if (bitMask == 0 || bitMask > 0xFF)
+        {
+            throw Napi::TypeError::New(env, "bitMask is not a number between 1 and 255");
+        }
+        operation.pData = nullptr;
+        operation.length = 1;
+        operation.bitMask = static_cast<uint8_t>(bitMask);
+        operation.bitValue = info[2].ToBoolean().Value();
+    }
+    else
+    {
+        encodeValue(info[2], type, size, encoded, operation.length);
+        operation.pData = encoded;
+    }
 
-            // read ck_sequenz again - if true read again
-            bRepetitionRequired = ck_sequence_read_retry(&pManagmentBuffer->seqlock, m_version);
-            counter++;
+    if (metadataSize > 0)
+    {
+        if (!info[5].IsNumber() || info[5].As<Napi::Number>().Int64Value() < 0 || !ProcessValueDecoder::isSupportedMetadataSize(metadataSize))
+        {
+            throw Napi::TypeError::New(env, "Invalid metadata offset or size");
         }
+        SharedMemorySegment::WriteOperation &metadata = operations[numberOfOperations++];
+        metadata.offset = info[5].As<Napi::Number>().Int64Value();
+        metadata.pData = zeroedMetadata;
+        metadata.length = metadataSize;
+        metadata.bitMask = 0;
+        metadata.bitValue = false;
+    }
 
-        if (bRepetitionRequired)
+    for (size_t i = 0; i < numberOfOperations; i++)
+    {
+        if (operations[i].offset + operations[i].length > m_segment->getSize())
         {
-            throw Napi::Error::New(env, "Unable to read value");
+            throw Napi::RangeError::New(env, "Offset and length exceed buffer size");
         }
+    }
+
+    if (!m_segment->writeMany(operations, numberOfOperations))
+    {
+        throw createLockError(env, "Unable to write value");
+    }
+}
+
+Napi::Value SharedMemory::readBuffer(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    auto buf = Napi::Buffer<char>::New(info.Env(), m_segment->getSize());
+
+    if (!m_segment->copyConsistent(buf.Data(), 0, m_segment->getSize(), false))
+    {
+        throw createReadError(env, *m_segment);
+    }
+
+    // return buffer
+    return buf.ToObject();
+}
+
+Napi::Value SharedMemory::readRange(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "readRange requires an offset and a length as arguments");
+    }
+
+    int64_t offset = info[0].As<Napi::Number>().Int64Value();
+    int64_t length = info[1].As<Napi::Number>().Int64Value();
+
+    if (offset < 0 || length < 0)
+    {
+        throw Napi::RangeError::New(env, "Offset and length must not be negative");
+    }
+
+    if (m_segment->getBufferType() == SharedMemorySegment::BufferType::doubleBuffer && m_segment->getSizeOfSingleBuffer() == 0)
+    {
+        throw Napi::Error::New(env, "readRange requires the size of a single buffer for double buffers");
+    }
+
+    // the range has to fit into the buffer, regardless of which half of a double buffer is active
+    if (static_cast<size_t>(offset + length) > m_segment->getSizeOfCurrentBuffer())
+    {
+        throw Napi::RangeError::New(env, "Offset and length exceed buffer size");
+    }
 
-        // return buffer
-        return buf.ToObject();
+    Napi::Value result;
+    char *destination;
+    if (info.Length() > 2 && info[2].IsBuffer())
+    {
+        // copy into the buffer of the caller to avoid an allocation per read
+        auto target = info[2].As<Napi::Buffer<char>>();
+        if (target.Length() < static_cast<size_t>(length))
+        {
+            throw Napi::RangeError::New(env, "Target buffer is smaller than the specified length");
+        }
+        destination = target.Data();
+        result = target;
     }
     else
     {
-        while (bRepetitionRequired && (counter <= maxReadRetries))
+        auto buf = Napi::Buffer<char>::New(env, length);
+        destination = buf.Data();
+        result = buf;
+    }
+
+    if (!m_segment->copyConsistent(destination, offset, length, true))
+    {
+        throw createReadError(env, *m_segment);
+    }
+
+    return result;
+}
+
+Napi::Value SharedMemory::readMany(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1)
+    {
+        throw Napi::TypeError::New(env, "readMany requires a descriptor table as argument");
+    }
+
+    parseDescriptorTable(info[0], m_descriptors);
+
+    // the snapshot covers all values and their metadata
+    size_t snapshotStart = 0;
+    m_snapshot.resize(ProcessValueDecoder::getSnapshotRange(m_descriptors, snapshotStart));
+
+    const size_t numberOfValues = m_descriptors.size();
+    Napi::Array values = Napi::Array::New(env, numberOfValues);
+    Napi::Uint32Array errorCodes = Napi::Uint32Array::New(env, numberOfValues);
+    Napi::Uint8Array hasErrorCodes = Napi::Uint8Array::New(env, numberOfValues);
+
+    if (numberOfValues > 0)
+    {
+        if (!m_segment->copyConsistent(m_snapshot.data(), snapshotStart, m_snapshot.size(), true))
         {
-            if (m_semaphoreLock.lock())
-            {
-                // read Value
-                memcpy(buf.Data(), this->m_buffer, this->m_size);
-
-                if (m_semaphoreLock.unlock())
-                {
-                    bRepetitionRequired = false;
-                }
-                else
-                {
-                    #ifdef DEBUG
-                    std::cout << "read semaphore unlock failed" << std::endl;
-                    #endif
-                }
-            }
-            else
-            {
-                #ifdef DEBUG
-                std::cout << "read semaphore lock failed" << std::endl;
-                #endif
-            }
-            counter++;
+            throw createReadError(env, *m_segment);
         }
 
-        if (bRepetitionRequired)
+        for (size_t i = 0; i < numberOfValues; i++)
         {
-            throw Napi::Error::New(env, "Unable to read value");
+            ProcessValueDecoder::decode(m_snapshot.data(), snapshotStart, m_descriptors[i], m_decodedValue);
+            values.Set(i, toNapiValue(env, m_decodedValue, *m_strings, m_descriptors[i].offset));
+            errorCodes[i] = m_decodedValue.errorCode;
+            hasErrorCodes[i] = m_decodedValue.hasErrorCode ? 1 : 0;
         }
-        // return buffer
-        return buf.ToObject();
     }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("values", values);
+    result.Set("errorCodes", errorCodes);
+    result.Set("hasErrorCodes", hasErrorCodes);
+    return result;
 }
 
-void SharedMemory::setBuffer(const Napi::CallbackInfo &info, const Napi::Value &value)
+Napi::Value SharedMemory::readAsync(const Napi::CallbackInfo &info)
 {
-    if (!value.IsBuffer())
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1)
     {
-        throw Napi::TypeError::New(info.Env(), "The buffer setter requires a buffer as an argument");
+        throw Napi::TypeError::New(env, "readAsync requires a descriptor table as argument");
     }
 
-    auto buf = info[0].As<Napi::Buffer<char>>();
-    if (buf.Length() > this->m_size)
+    // the worker gets its own descriptors, the reused ones of readMany may change before it runs
+    std::vector<ProcessValueDecoder::Descriptor> descriptors;
+    parseDescriptorTable(info[0], descriptors);
+
+    auto *pWorker = new SharedMemoryReadWorker(env, m_segment, m_strings, std::move(descriptors));
+    Napi::Promise promise = pWorker->getPromise();
+    pWorker->Queue();
+    return promise;
+}
+
+Napi::Value SharedMemory::snapshotRange(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1)
     {
-        throw Napi::Error::New(info.Env(), "Could not write to the buffer: The input is bigger than the buffer size");
+        throw Napi::TypeError::New(env, "snapshotRange requires a descriptor table as argument");
     }
 
-    memcpy(this->m_buffer, buf.Data(), buf.Length());
+    std::vector<ProcessValueDecoder::Descriptor> descriptors;
+    parseDescriptorTable(info[0], descriptors);
+
+    size_t start = 0;
+    const size_t length = ProcessValueDecoder::getSnapshotRange(descriptors, start);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("offset", Napi::Number::New(env, start));
+    result.Set("length", Napi::Number::New(env, length));
+    return result;
 }
 
-SharedMemory::~SharedMemory()
+Napi::Value SharedMemory::mapView(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    // decodes from the view are validated with the sequence number, a semaphore can't be held across JS code
+    if (m_segment->getBufferType() == SharedMemorySegment::BufferType::singleBufferSemaphore)
+    {
+        throw Napi::TypeError::New(env, "A singleBufferSemaphore can't be mapped, its reads can't be validated");
+    }
+
+    std::shared_ptr<const SharedMemorySegment::ReadOnlyMapping> mapping;
+    try
+    {
+        mapping = m_segment->getReadOnlyMapping();
+    }
+    catch (const std::exception &e)
+    {
+        throw Napi::Error::New(env, e.what());
+    }
+
+    // every view keeps the mapping alive until it is garbage collected
+    auto pOwner = new std::shared_ptr<const SharedMemorySegment::ReadOnlyMapping>(mapping);
+    return Napi::ArrayBuffer::New(env, const_cast<char *>(mapping->getData()), mapping->getSize(),
+                                  [](Napi::Env, void *, std::shared_ptr<const SharedMemorySegment::ReadOnlyMapping> *pOwner)
+                                  { delete pOwner; },
+                                  pOwner);
+}
+
+Napi::Value SharedMemory::snapshotVersion(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (m_segment->getBufferType() == SharedMemorySegment::BufferType::singleBufferSemaphore)
+    {
+        throw Napi::TypeError::New(env, "A singleBufferSemaphore has no sequence number to validate a read");
+    }
+
+    unsigned int version = 0;
+    if (!m_segment->beginRead(version))
+    {
+        throw createReadError(env, *m_segment);
+    }
+    return Napi::Number::New(env, version);
+}
+
+Napi::Value SharedMemory::validate(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "validate requires the version returned by snapshotVersion as argument");
+    }
+    return Napi::Boolean::New(env, m_segment->validateRead(info[0].As<Napi::Number>().Uint32Value()));
+}
+
+Napi::Value SharedMemory::currentBufferOffset(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    return Napi::Number::New(info.Env(), m_segment->getCurrentBufferStartAddress());
+}
+
+void SharedMemory::setReadTimeout(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "setReadTimeout requires the timeout in ms as argument");
+    }
+
+    double timeoutMs = info[0].As<Napi::Number>().DoubleValue();
+    if (!(timeoutMs >= 0))
+    {
+        throw Napi::RangeError::New(env, "The read timeout must not be negative");
+    }
+
+    m_segment->setReadTimeout(std::chrono::microseconds(static_cast<int64_t>(timeoutMs * 1000)));
+}
+
+void SharedMemory::setLockTimeout(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "setLockTimeout requires the timeout in ms as argument");
+    }
+
+    double timeoutMs = info[0].As<Napi::Number>().DoubleValue();
+    if (!(timeoutMs >= 0))
+    {
+        throw Napi::RangeError::New(env, "The lock timeout must not be negative");
+    }
+
+    m_segment->setLockTimeout(std::chrono::microseconds(static_cast<int64_t>(timeoutMs * 1000)));
+}
+
+Napi::Value SharedMemory::getLockStatistics(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    return toNapiLockStatistics(info.Env(), m_segment->getLockStatistics());
+}
+
+Napi::Value SharedMemory::getStats(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+    const SharedMemorySegment::Statistics statistics = m_segment->getStatistics();
+
+    Napi::Object reads = Napi::Object::New(env);
+    reads.Set("count", Napi::Number::New(env, statistics.reads.reads));
+    reads.Set("bytes", Napi::Number::New(env, statistics.reads.bytes));
+    reads.Set("retries", Napi::Number::New(env, statistics.reads.retries));
+    reads.Set("timeouts", Napi::Number::New(env, statistics.reads.timeouts));
+    reads.Set("failures", Napi::Number::New(env, statistics.reads.failures));
+    reads.Set("latency", toNapiLatencyHistogram(env, statistics.readLatency));
+
+    Napi::Object writes = Napi::Object::New(env);
+    writes.Set("count", Napi::Number::New(env, statistics.writes.writes));
+    writes.Set("bytes", Napi::Number::New(env, statistics.writes.bytes));
+    writes.Set("failures", Napi::Number::New(env, statistics.writes.failures));
+    writes.Set("latency", toNapiLatencyHistogram(env, statistics.writeLatency));
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("reads", reads);
+    result.Set("writes", writes);
+    result.Set("locks", toNapiLockStatistics(env, statistics.locks));
+    return result;
+}
+
+void SharedMemory::resetStats(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    m_segment->resetStatistics();
+}
+
+Napi::Value SharedMemory::toNapiLockStatistics(Napi::Env env, const SharedMemorySegment::LockStatistics &statistics)
+{
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("locks", Napi::Number::New(env, statistics.locks));
+    result.Set("contendedLocks", Napi::Number::New(env, statistics.contendedLocks));
+    result.Set("timeouts", Napi::Number::New(env, statistics.timeouts));
+    result.Set("failures", Napi::Number::New(env, statistics.failures));
+    result.Set("totalWaitUs", Napi::Number::New(env, statistics.totalWaitUs));
+    result.Set("maxWaitUs", Napi::Number::New(env, statistics.maxWaitUs));
+
+    // one bucket per upper bound, the last bucket counts all longer waits and has an infinite bound
+    Napi::Array histogram = Napi::Array::New(env, SharedMemorySegment::numberOfLockWaitBuckets);
+    for (size_t i = 0; i < SharedMemorySegment::numberOfLockWaitBuckets; i++)
+    {
+        Napi::Object bucket = Napi::Object::New(env);
+        const bool hasUpperBound = i < SharedMemorySegment::lockWaitBucketBoundsUs.size();
+        bucket.Set("upperBoundUs", Napi::Number::New(env, hasUpperBound ? static_cast<double>(SharedMemorySegment::lockWaitBucketBoundsUs[i]) : INFINITY));
+        bucket.Set("count", Napi::Number::New(env, statistics.waitHistogram[i]));
+        histogram.Set(static_cast<uint32_t>(i), bucket);
+    }
+    result.Set("waitHistogram", histogram);
+    return result;
+}
+
+Napi::Value SharedMemory::toNapiLatencyHistogram(Napi::Env env, const LatencyHistogram::Snapshot &snapshot)
+{
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("count", Napi::Number::New(env, snapshot.count));
+    result.Set("sumNs", Napi::Number::New(env, snapshot.sumNs));
+    result.Set("maxNs", Napi::Number::New(env, snapshot.maxNs));
+    result.Set("p50Ns", Napi::Number::New(env, snapshot.getValueAtPercentile(50)));
+    result.Set("p90Ns", Napi::Number::New(env, snapshot.getValueAtPercentile(90)));
+    result.Set("p99Ns", Napi::Number::New(env, snapshot.getValueAtPercentile(99)));
+    result.Set("p999Ns", Napi::Number::New(env, snapshot.getValueAtPercentile(99.9)));
+
+    // most of the log-linear buckets are empty, only the others are exported
+    Napi::Array buckets = Napi::Array::New(env);
+    for (size_t i = 0; i < LatencyHistogram::numberOfBuckets; i++)
+    {
+        if (snapshot.buckets[i] > 0)
+        {
+            Napi::Object bucket = Napi::Object::New(env);
+            bucket.Set("upperBoundNs", Napi::Number::New(env, static_cast<double>(LatencyHistogram::getBucketUpperBound(i))));
+            bucket.Set("count", Napi::Number::New(env, snapshot.buckets[i]));
+            buckets.Set(buckets.Length(), bucket);
+        }
+    }
+    result.Set("buckets", buckets);
+    return result;
+}
+
+Napi::Error SharedMemory::createLockError(Napi::Env env, const std::string &message, int error)
+{
+    // the segment reports a lock timeout by errno
+    const bool timedOut = error == EAGAIN;
+
+    Napi::Error lockError = Napi::Error::New(env, timedOut ? message + ": timeout while waiting for the semaphore" : message);
+    lockError.Set("code", Napi::String::New(env, timedOut ? "ERR_LOCK_TIMEOUT" : "ERR_SEMAPHORE_LOCK"));
+    return lockError;
+}
+
+Napi::Error SharedMemory::createReadError(Napi::Env env, const SharedMemorySegment &segment, int error)
 {
-    // detach from shared memory
-    shmdt(this->m_buffer);
+    if (segment.getBufferType() == SharedMemorySegment::BufferType::singleBufferSemaphore)
+    {
+        return createLockError(env, "Unable to read value", error);
+    }
+
+    // the producer kept writing or died while writing
+    Napi::Error readError = Napi::Error::New(env, "Timeout while waiting for a consistent read of " + segment.getName());
+    readError.Set("code", Napi::String::New(env, "ERR_READ_TIMEOUT"));
+    return readError;
+}
+
+Napi::Value SharedMemory::watch(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !info[1].IsNumber() || !info[2].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "watch requires a descriptor table, a minimal interval in ms and a callback as arguments");
+    }
+
+    std::vector<ProcessValueDecoder::Descriptor> descriptors;
+    parseDescriptorTable(info[0], descriptors);
+    if (descriptors.empty())
+    {
+        throw Napi::RangeError::New(env, "The descriptor table must contain at least one value");
+    }
+
+    int64_t minInterval = info[1].As<Napi::Number>().Int64Value();
+    if (minInterval < 0)
+    {
+        throw Napi::RangeError::New(env, "The minimal interval must not be negative");
+    }
+
+    auto callback = Napi::ThreadSafeFunction::New(env, info[2].As<Napi::Function>(), "SharedMemoryWatcher", 0, 1);
+
+    if (!m_watcher)
+    {
+        m_watcher.reset(new SharedMemoryWatcher(m_segment));
+    }
+    uint32_t id = m_watcher->subscribe(std::move(descriptors), std::chrono::milliseconds(minInterval), callback);
+
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value SharedMemory::watchBatched(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 4 || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "watchBatched requires a descriptor table, a minimal interval in ms, a capacity and a callback as arguments");
+    }
+
+    std::vector<ProcessValueDecoder::Descriptor> descriptors;
+    parseDescriptorTable(info[0], descriptors);
+    if (descriptors.empty())
+    {
+        throw Napi::RangeError::New(env, "The descriptor table must contain at least one value");
+    }
+
+    int64_t minInterval = info[1].As<Napi::Number>().Int64Value();
+    if (minInterval < 0)
+    {
+        throw Napi::RangeError::New(env, "The minimal interval must not be negative");
+    }
+
+    int64_t capacity = info[2].As<Napi::Number>().Int64Value();
+    if (capacity <= 0)
+    {
+        throw Napi::RangeError::New(env, "The capacity must be greater than zero");
+    }
+
+    auto ring = std::make_shared<SampleRing>(SharedMemoryWatcher::getChangeRecordSize(descriptors), capacity);
+    auto callback = Napi::ThreadSafeFunction::New(env, info[3].As<Napi::Function>(), "SharedMemoryWatcher", 0, 1);
+
+    if (!m_watcher)
+    {
+        m_watcher.reset(new SharedMemoryWatcher(m_segment));
+    }
+    uint32_t id = m_watcher->subscribe(std::move(descriptors), std::chrono::milliseconds(minInterval), callback, ring);
+
+    // N-API can't create a SharedArrayBuffer, the external ArrayBuffer is backed by the ring buffer and JS accesses
+    // its indices with Atomics. It keeps the ring buffer alive after the subscription has been removed.
+    auto pOwner = new std::shared_ptr<SampleRing>(ring);
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, ring->getData(), ring->getSize(),
+                                                      [](Napi::Env, void *, std::shared_ptr<SampleRing> *pOwner)
+                                                      { delete pOwner; },
+                                                      pOwner);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("id", Napi::Number::New(env, id));
+    result.Set("ring", buffer);
+    return result;
+}
+
+Napi::Value SharedMemory::unwatch(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "unwatch requires the id of a subscription as argument");
+    }
+
+    bool found = m_watcher && m_watcher->unsubscribe(info[0].As<Napi::Number>().Uint32Value());
+
+    // stop the watcher thread if nothing is watched anymore
+    if (m_watcher && m_watcher->getNumberOfSubscriptions() == 0)
+    {
+        m_watcher.reset();
+    }
+
+    return Napi::Boolean::New(env, found);
+}
+
+Napi::Value SharedMemory::startRecording(const Napi::CallbackInfo &info)
+{
+    checkOpen(info.Env());
+
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 5 || !info[1].IsNumber() || !info[2].IsString() || !info[3].IsBoolean() || !info[4].IsString())
+    {
+        throw Napi::TypeError::New(env, "startRecording requires a descriptor table, a period in µs, a file name, the delta encoding and an info as arguments");
+    }
+
+    std::vector<ProcessValueDecoder::Descriptor> descriptors;
+    parseDescriptorTable(info[0], descriptors);
+    if (descriptors.empty())
+    {
+        throw Napi::RangeError::New(env, "The descriptor table must contain at least one value");
+    }
+
+    int64_t period = info[1].As<Napi::Number>().Int64Value();
+    if (period <= 0)
+    {
+        throw Napi::RangeError::New(env, "The period must be greater than zero");
+    }
+
+    std::unique_ptr<SharedMemoryRecorder> recorder;
+    try
+    {
+        recorder.reset(new SharedMemoryRecorder(m_segment, std::move(descriptors), std::chrono::microseconds(period), info[2].As<Napi::String>().Utf8Value(),
+                                                info[3].As<Napi::Boolean>().Value(), info[4].As<Napi::String>().Utf8Value()));
+    }
+    catch (const std::exception &e)
+    {
+        throw Napi::Error::New(env, e.what());
+    }
+
+    uint32_t id = m_nextRecordingId++;
+    m_recorders[id] = std::move(recorder);
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value SharedMemory::stopRecording(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "stopRecording requires the id of a recording as argument");
+    }
+
+    auto it = m_recorders.find(info[0].As<Napi::Number>().Uint32Value());
+    if (it == m_recorders.end())
+    {
+        return env.Undefined();
+    }
+
+    // waits until the writer has written the remaining samples
+    it->second->stop();
+    Napi::Value statistics = toNapiRecordingStatistics(env, *it->second);
+    m_recorders.erase(it);
+    return statistics;
+}
+
+Napi::Value SharedMemory::getRecordingStatistics(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber())
+    {
+        throw Napi::TypeError::New(env, "getRecordingStatistics requires the id of a recording as argument");
+    }
+
+    auto it = m_recorders.find(info[0].As<Napi::Number>().Uint32Value());
+    if (it == m_recorders.end())
+    {
+        return env.Undefined();
+    }
+    return toNapiRecordingStatistics(env, *it->second);
+}
+
+Napi::Value SharedMemory::toNapiRecordingStatistics(Napi::Env env, const SharedMemoryRecorder &recorder)
+{
+    const SharedMemoryRecorder::Statistics statistics = recorder.getStatistics();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("samples", Napi::Number::New(env, statistics.samples));
+    result.Set("droppedSamples", Napi::Number::New(env, statistics.droppedSamples));
+    result.Set("missedPeriods", Napi::Number::New(env, statistics.missedPeriods));
+    result.Set("readFailures", Napi::Number::New(env, statistics.readFailures));
+    result.Set("writtenBlocks", Napi::Number::New(env, statistics.writtenBlocks));
+    result.Set("writtenBytes", Napi::Number::New(env, statistics.writtenBytes));
+    result.Set("writeErrors", Napi::Number::New(env, statistics.writeErrors));
+    return result;
+}
+
+void SharedMemory::parseDescriptorTable(const Napi::Value &value, std::vector<ProcessValueDecoder::Descriptor> &descriptors) const
+{
+    // the values have to fit into the buffer, regardless of which half of a double buffer is active
+    if (m_segment->getBufferType() == SharedMemorySegment::BufferType::doubleBuffer && m_segment->getSizeOfSingleBuffer() == 0)
+    {
+        throw Napi::Error::New(value.Env(), "The descriptor table requires the size of a single buffer for double buffers");
+    }
+    parseDescriptorTable(value, 0, m_segment->getSizeOfCurrentBuffer(), descriptors);
+}
+
+void SharedMemory::parseDescriptorTable(const Napi::Value &value, size_t rangeStart, size_t rangeEnd, std::vector<ProcessValueDecoder::Descriptor> &descriptors)
+{
+    Napi::Env env = value.Env();
+
+    if (!value.IsTypedArray() || value.As<Napi::TypedArray>().TypedArrayType() != napi_int32_array)
+    {
+        throw Napi::TypeError::New(env, "The descriptor table must be an Int32Array");
+    }
+
+    auto table = value.As<Napi::Int32Array>();
+    if (table.ElementLength() % descriptorTableStride != 0)
+    {
+        throw Napi::TypeError::New(env, "The length of the descriptor table must be a multiple of " + std::to_string(descriptorTableStride));
+    }
+
+    descriptors.clear();
+    for (size_t i = 0; i < table.ElementLength(); i += descriptorTableStride)
+    {
+        const int32_t *entry = table.Data() + i;
+        if (entry[0] < 0 || entry[2] < 0 || entry[4] < 0 || !ProcessValueDecoder::isValidValueType(entry[1]) ||
+            !ProcessValueDecoder::isSupportedMetadataSize(entry[5]))
+        {
+            throw Napi::TypeError::New(env, "Invalid entry " + std::to_string(i / descriptorTableStride) + " in descriptor table");
+        }
+
+        ProcessValueDecoder::Descriptor descriptor;
+        descriptor.offset = entry[0];
+        descriptor.type = static_cast<ProcessValueDecoder::ValueType>(entry[1]);
+        descriptor.size = entry[2];
+        descriptor.bitMask = static_cast<uint8_t>(entry[3]);
+        descriptor.metadataOffset = entry[4];
+        descriptor.metadataSize = entry[5];
+
+        if (descriptor.offset < rangeStart || descriptor.offset + ProcessValueDecoder::getSizeOfValue(descriptor) > rangeEnd ||
+            (descriptor.metadataSize > 0 && (descriptor.metadataOffset < rangeStart || descriptor.metadataOffset + descriptor.metadataSize > rangeEnd)))
+        {
+            throw Napi::RangeError::New(env, "Entry " + std::to_string(i / descriptorTableStride) + " of the descriptor table exceeds buffer size");
+        }
+        descriptors.push_back(descriptor);
+    }
+}
+
+void SharedMemory::parseWriteOperation(const Napi::Value &value, char *pEncoded, SharedMemorySegment::WriteOperation &operation) const
+{
+    Napi::Env env = value.Env();
+
+    if (!value.IsObject())
+    {
+        throw Napi::TypeError::New(env, "entry is not an object");
+    }
+    auto entry = value.As<Napi::Object>();
+
+    Napi::Value offset = entry.Get("offset");
+    if (!offset.IsNumber() || offset.As<Napi::Number>().Int64Value() < 0)
+    {
+        throw Napi::TypeError::New(env, "offset is not a non-negative number");
+    }
+    operation.offset = offset.As<Napi::Number>().Int64Value();
+    operation.bitMask = 0;
+    operation.bitValue = false;
+
+    Napi::Value bytes = entry.Get("bytes");
+    Napi::Value type = entry.Get("type");
+    if (bytes.IsBuffer())
+    {
+        auto buffer = bytes.As<Napi::Buffer<char>>();
+        operation.pData = buffer.Data();
+        operation.length = buffer.Length();
+    }
+    else if (type.IsNumber() && ProcessValueDecoder::isValidValueType(type.As<Napi::Number>().Int32Value()))
+    {
+        auto valueType = static_cast<ProcessValueDecoder::ValueType>(type.As<Napi::Number>().Int32Value());
+        if (valueType == ProcessValueDecoder::ValueType::Bit)
+        {
+            Napi::Value bitMask = entry.Get("bitMask");
+            if (!bitMask.IsNumber() || bitMask.As<Napi::Number>().Uint32Value() == 0 || bitMask.As<Napi::Number>().Uint32Value() > 0xFF)
+            {
+                throw Napi::TypeError::New(env, "bitMask is not a number between 1 and 255");
+            }
+            operation.pData = nullptr;
+            operation.length = 1;
+            operation.bitMask = static_cast<uint8_t>(bitMask.As<Napi::Number>().Uint32Value());
+            operation.bitValue = entry.Get("value").ToBoolean().Value();
+        }
+        else
+        {
+            Napi::Value size = entry.Get("size");
+            encodeValue(entry.Get("value"), valueType, size.IsNumber() ? size.As<Napi::Number>().Uint32Value() : 0, pEncoded, operation.length);
+            operation.pData = pEncoded;
+        }
+    }
+    else
+    {
+        throw Napi::TypeError::New(env, "entry has neither bytes nor a valid type");
+    }
+
+    if (operation.offset + operation.length > m_segment->getSize())
+    {
+        throw Napi::RangeError::New(env, "Offset and length exceed buffer size");
+    }
+}
+
+void SharedMemory::encodeValue(const Napi::Value &value, ProcessValueDecoder::ValueType type, size_t size, char *destination, size_t &length)
+{
+    Napi::Env env = value.Env();
+    ProcessValueEncoder::Result result;
+
+    if (value.IsNumber())
+    {
+        result = ProcessValueEncoder::encodeNumber(type, size, value.As<Napi::Number>().DoubleValue(), destination, length);
+    }
+    else if (value.IsBoolean())
+    {
+        result = ProcessValueEncoder::encodeNumber(type, size, value.As<Napi::Boolean>().Value() ? 1 : 0, destination, length);
+    }
+    else if (value.IsBigInt())
+    {
+        // a BigInt that does not fit into 64 bits is out of the range of every type
+        bool lossless = false;
+        if (type == ProcessValueDecoder::ValueType::UnsignedLongLong)
+        {
+            uint64_t unsignedValue = value.As<Napi::BigInt>().Uint64Value(&lossless);
+            result = ProcessValueEncoder::encodeUnsignedInteger(type, unsignedValue, destination, length);
+        }
+        else
+        {
+            int64_t signedValue = value.As<Napi::BigInt>().Int64Value(&lossless);
+            result = ProcessValueEncoder::encodeSignedInteger(type, signedValue, destination, length);
+        }
+        if (!lossless && result == ProcessValueEncoder::Result::ok)
+        {
+            result = ProcessValueEncoder::Result::outOfRange;
+        }
+    }
+    else
+    {
+        throw Napi::TypeError::New(env, "value is not a number, boolean or BigInt");
+    }
+
+    if (result == ProcessValueEncoder::Result::outOfRange)
+    {
+        throw Napi::RangeError::New(env, std::string(ProcessValueEncoder::getResultText(result)) + " " + ProcessValueDecoder::getValueTypeName(type));
+    }
+    if (result != ProcessValueEncoder::Result::ok)
+    {
+        throw Napi::TypeError::New(env, std::string(ProcessValueEncoder::getResultText(result)) + ": " + ProcessValueDecoder::getValueTypeName(type));
+    }
+}
+
+Napi::Value SharedMemory::toNapiValue(Napi::Env env, const ProcessValueDecoder::DecodedValue &decodedValue)
+{
+    switch (decodedValue.kind)
+    {
+    case ProcessValueDecoder::DecodedKind::signedInteger:
+        return Napi::Number::New(env, static_cast<double>(decodedValue.signedValue));
+    case ProcessValueDecoder::DecodedKind::unsignedInteger:
+        return Napi::Number::New(env, static_cast<double>(decodedValue.unsignedValue));
+    case ProcessValueDecoder::DecodedKind::bigSignedInteger:
+        return Napi::BigInt::New(env, decodedValue.signedValue);
+    case ProcessValueDecoder::DecodedKind::bigUnsignedInteger:
+        return Napi::BigInt::New(env, decodedValue.unsignedValue);
+    case ProcessValueDecoder::DecodedKind::floatingPoint:
+        return Napi::Number::New(env, decodedValue.floatingPointValue);
+    case ProcessValueDecoder::DecodedKind::boolean:
+        return Napi::Boolean::New(env, decodedValue.booleanValue);
+    default:
+        return Napi::String::New(env, decodedValue.textValue);
+    }
+}
+
+Napi::Value SharedMemory::toNapiValue(Napi::Env env, const ProcessValueDecoder::DecodedValue &decodedValue, StringInterner &strings, size_t offset)
+{
+    if (decodedValue.kind == ProcessValueDecoder::DecodedKind::text)
+    {
+        return strings.get(env, offset, decodedValue.textValue);
+    }
+    return toNapiValue(env, decodedValue);
+}
+
+SharedMemorySegment::BufferType SharedMemory::getBufferType(const Napi::Value &value)
+{
+    // legacy: only a flag for double buffers is passed
+    if (!value.IsString())
+    {
+        return value.ToBoolean() ? SharedMemorySegment::BufferType::doubleBuffer : SharedMemorySegment::BufferType::singleBufferSemaphore;
+    }
+
+    std::string bufferType = value.As<Napi::String>().Utf8Value();
+    if (bufferType == "singleBufferSemaphore")
+    {
+        return SharedMemorySegment::BufferType::singleBufferSemaphore;
+    }
+    if (bufferType == "singleBufferSequenceLock")
+    {
+        return SharedMemorySegment::BufferType::singleBufferSequenceLock;
+    }
+    if (bufferType == "doubleBuffer")
+    {
+        return SharedMemorySegment::BufferType::doubleBuffer;
+    }
+    throw Napi::TypeError::New(value.Env(), "Unknown buffer type: " + bufferType);
+}
+
+void SharedMemory::setBuffer(const Napi::CallbackInfo &info, const Napi::Value &value)
+{
+    checkOpen(info.Env());
+
+    if (!value.IsBuffer())
+    {
+        throw Napi::TypeError::New(info.Env(), "The buffer setter requires a buffer as an argument");
+    }
+
+    auto buf = info[0].As<Napi::Buffer<char>>();
+    if (buf.Length() > m_segment->getSize())
+    {
+        throw Napi::Error::New(info.Env(), "Could not write to the buffer: The input is bigger than the buffer size");
+    }
+
+    m_segment->overwrite(buf.Data(), buf.Length());
+}
+
+void SharedMemory::close(const Napi::CallbackInfo &)
+{
+    release();
+}
+
+void SharedMemory::release()
+{
+    // stop the watcher and the recorder threads before the segment is released, the mapping is released with the last segment
+    m_watcher.reset();
+    m_recorders.clear();
+    m_segment.reset();
+    m_strings->clear();
+}
+
+Napi::Value SharedMemory::getMappingStatistics(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    const SharedMemoryMappingPool::Statistics statistics = SharedMemoryMappingPool::getStatistics();
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("liveMappings", Napi::Number::New(env, statistics.liveMappings));
+    result.Set("mappedBytes", Napi::Number::New(env, statistics.mappedBytes));
+    result.Set("createdMappings", Napi::Number::New(env, statistics.createdMappings));
+    result.Set("releasedMappings", Napi::Number::New(env, statistics.releasedMappings));
+    result.Set("reusedMappings", Napi::Number::New(env, statistics.reusedMappings));
+    return result;
+}
+
+Napi::Value SharedMemory::diffSnapshots(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 3 || !(info[0].IsBuffer() || info[0].IsNull()) || !info[1].IsBuffer())
+    {
+        throw Napi::TypeError::New(env, "diffSnapshots requires the previous snapshot or null, the current snapshot and a descriptor table as arguments");
+    }
+
+    auto current = info[1].As<Napi::Buffer<char>>();
+    const size_t length = current.Length();
+
+    int64_t snapshotOffset = 0;
+    if (info.Length() > 3 && info[3].IsNumber())
+    {
+        snapshotOffset = info[3].As<Napi::Number>().Int64Value();
+    }
+    if (snapshotOffset < 0)
+    {
+        throw Napi::RangeError::New(env, "The offset of the snapshots must not be negative");
+    }
+
+    std::vector<ProcessValueDecoder::Descriptor> descriptors;
+    parseDescriptorTable(info[2], snapshotOffset, snapshotOffset + length, descriptors);
+
+    std::vector<SnapshotDiff::Range> ranges;
+    if (info[0].IsNull())
+    {
+        if (length > 0)
+        {
+            ranges.push_back({0, length});
+        }
+    }
+    else
+    {
+        auto previous = info[0].As<Napi::Buffer<char>>();
+        if (previous.Length() != length)
+        {
+            throw Napi::RangeError::New(env, "The snapshots must have the same length");
+        }
+        SnapshotDiff::findChangedRanges(previous.Data(), current.Data(), length, ranges);
+    }
+
+    // the ranges are relative to the snapshots, the descriptors relative to the current buffer
+    std::vector<uint32_t> changed;
+    for (size_t i = 0; i < descriptors.size() && !ranges.empty(); i++)
+    {
+        const ProcessValueDecoder::Descriptor &descriptor = descriptors[i];
+        if (SnapshotDiff::intersects(ranges, descriptor.offset - snapshotOffset, ProcessValueDecoder::getSizeOfValue(descriptor)) ||
+            (descriptor.metadataSize > 0 && SnapshotDiff::intersects(ranges, descriptor.metadataOffset - snapshotOffset, descriptor.metadataSize)))
+        {
+            changed.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    Napi::Uint32Array changedRanges = Napi::Uint32Array::New(env, ranges.size() * 2);
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        changedRanges[2 * i] = static_cast<uint32_t>(ranges[i].offset);
+        changedRanges[2 * i + 1] = static_cast<uint32_t>(ranges[i].length);
+    }
+
+    Napi::Uint32Array indices = Napi::Uint32Array::New(env, changed.size());
+    Napi::Array values = Napi::Array::New(env, changed.size());
+    Napi::Uint32Array errorCodes = Napi::Uint32Array::New(env, changed.size());
+    Napi::Uint8Array hasErrorCodes = Napi::Uint8Array::New(env, changed.size());
+    ProcessValueDecoder::DecodedValue decodedValue;
+    for (size_t i = 0; i < changed.size(); i++)
+    {
+        ProcessValueDecoder::decode(current.Data(), snapshotOffset, descriptors[changed[i]], decodedValue);
+        indices[i] = changed[i];
+        values.Set(i, toNapiValue(env, decodedValue));
+        errorCodes[i] = decodedValue.errorCode;
+        hasErrorCodes[i] = decodedValue.hasErrorCode ? 1 : 0;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("ranges", changedRanges);
+    result.Set("indices", indices);
+    result.Set("values", values);
+    result.Set("errorCodes", errorCodes);
+    result.Set("hasErrorCodes", hasErrorCodes);
+    return result;
+}
+
+void SharedMemory::checkOpen(Napi::Env env) const
+{
+    if (!m_segment)
+    {
+        throw Napi::Error::New(env, "The shared memory has been closed");
+    }
+}
+
+Napi::Value SharedMemory::getSharedDescription(const Napi::CallbackInfo &info)
+{
+    std::string description;
+    if (!DescriptionRegistry::get(getKeyArgument(info, "getSharedDescription"), description))
+    {
+        return info.Env().Undefined();
+    }
+    return Napi::String::New(info.Env(), description);
+}
+
+Napi::Value SharedMemory::claimSharedDescription(const Napi::CallbackInfo &info)
+{
+    // the instance data identifies the thread, its claims are released when the thread exits
+    const bool claimed = DescriptionRegistry::claim(getKeyArgument(info, "claimSharedDescription"), info.Env().GetInstanceData<InstanceData>());
+    return Napi::Boolean::New(info.Env(), claimed);
+}
+
+void SharedMemory::publishSharedDescription(const Napi::CallbackInfo &info)
+{
+    const std::string key = getKeyArgument(info, "publishSharedDescription");
+    if (info.Length() < 2 || !info[1].IsString())
+    {
+        throw Napi::TypeError::New(info.Env(), "publishSharedDescription requires the description as string");
+    }
+    DescriptionRegistry::publish(key, info[1].As<Napi::String>().Utf8Value());
+}
+
+void SharedMemory::releaseSharedDescription(const Napi::CallbackInfo &info)
+{
+    DescriptionRegistry::release(getKeyArgument(info, "releaseSharedDescription"), info.Env().GetInstanceData<InstanceData>());
+}
+
+void SharedMemory::setSharedDescriptionListener(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsFunction())
+    {
+        throw Napi::TypeError::New(env, "setSharedDescriptionListener requires a function");
+    }
+
+    InstanceData *pInstanceData = env.GetInstanceData<InstanceData>();
+    DescriptionRegistry::removeListener(pInstanceData);
+    if (pInstanceData->hasDescriptionListener)
+    {
+        pInstanceData->descriptionListener.Release();
+    }
+
+    // the listener doesn't keep the event loop alive, a waiting thread has its own timeout
+    pInstanceData->descriptionListener = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "DescriptionRegistry", 0, 1);
+    pInstanceData->descriptionListener.Unref(env);
+    pInstanceData->hasDescriptionListener = true;
+
+    Napi::ThreadSafeFunction listener = pInstanceData->descriptionListener;
+    DescriptionRegistry::setListener(pInstanceData, [listener](const std::string &key)
+                                     {
+                                         auto pKey = new std::string(key);
+                                         if (listener.NonBlockingCall(pKey, &SharedMemory::notifySharedDescription) != napi_ok)
+                                         {
+                                             delete pKey;
+                                         } });
+}
+
+void SharedMemory::notifySharedDescription(Napi::Env env, Napi::Function callback, std::string *pKey)
+{
+    std::unique_ptr<std::string> key(pKey);
+
+    // the environment is gone if the listener is released while notifications are pending
+    if (env == nullptr || callback == nullptr)
+    {
+        return;
+    }
+    callback.Call({Napi::String::New(env, *key)});
+}
+
+std::string SharedMemory::getKeyArgument(const Napi::CallbackInfo &info, const char *function)
+{
+    if (info.Length() < 1 || !info[0].IsString())
+    {
+        throw Napi::TypeError::New(info.Env(), std::string(function) + " requires the key of the description as string");
+    }
+    return info[0].As<Napi::String>().Utf8Value();
+}
+
+SharedMemory::~SharedMemory()
+{
+    // stop the watcher and the recorder threads before the segment is released
+    m_watcher.reset();
+    m_recorders.clear();
+    if (m_instances)
+    {
+        m_instances->erase(this);
+    }
 }
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports)
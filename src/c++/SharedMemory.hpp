@@ -7,11 +7,20 @@
 
 #pragma once
 
+#include <cerrno>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 #include <napi.h>
 
-#include "SystemVSemaphore.hpp"
+#include "ProcessValueDecoder.hpp"
+#include "SharedMemorySegment.hpp"
+#include "StringInterner.hpp"
+
+class SharedMemoryRecorder;
+class SharedMemoryWatcher;
 
 /**
  * The shared memory node wrapper class
@@ -64,16 +73,351 @@ public:
      */
     Napi::Value readBuffer(const Napi::CallbackInfo &info);
 
+    /**
+     * Read a range of the current buffer into a node buffer. The offset is relative to the start of the current
+     * buffer (behind the management buffer, the active half of a double buffer). If a target buffer is passed,
+     * the data is copied into it instead of allocating a new node buffer.
+     *
+     * @param info the callback info
+     * @return the read data
+     */
+    Napi::Value readRange(const Napi::CallbackInfo &info);
+
+    /**
+     * Read and decode many process values out of one consistent snapshot. The descriptor table is an Int32Array
+     * with the entries (offset, type, size, bitMask, metadataOffset, metadataSize) for each value.
+     *
+     * @param info the callback info
+     * @return an object with the decoded values and their error codes
+     */
+    Napi::Value readMany(const Napi::CallbackInfo &info);
+
+    /**
+     * Like readMany, but the semaphore is locked and the snapshot copied and decoded on a thread of the libuv
+     * thread pool, so a contended semaphore does not block the event loop
+     *
+     * @param info the callback info with the descriptor table
+     * @return a promise, which resolves with the decoded values and their error codes
+     */
+    Napi::Value readAsync(const Napi::CallbackInfo &info);
+
+    /**
+     * Get the range of the current buffer that covers all values of a descriptor table and their metadata, the
+     * range to copy with readRange for diffSnapshots
+     *
+     * @param info the callback info with the descriptor table
+     * @return an object with the offset relative to the current buffer and the length of the range
+     */
+    Napi::Value snapshotRange(const Napi::CallbackInfo &info);
+
+    /**
+     * Write many values while holding the semaphore once. Each entry is an object with the offset relative to the
+     * segment and either the bytes to copy as node buffer or a type code and a value to encode. Bits are written with
+     * the type Bit, a bitMask and a boolean value. All entries are validated before the first one is written.
+     *
+     * @param info the callback info with the array of entries
+     */
+    void writeMany(const Napi::CallbackInfo &info);
+
+    /**
+     * Like writeMany, but the entries are only validated and encoded on the event loop thread. The semaphore is
+     * locked and the values written on a thread of the libuv thread pool.
+     *
+     * @param info the callback info with the array of entries
+     * @return a promise, which resolves when all values are written
+     */
+    Napi::Value writeManyAsync(const Napi::CallbackInfo &info);
+
+    /**
+     * Encode a single value and write it while holding the semaphore, without a temporary node buffer.
+     * The arguments are the type code, the offset relative to the segment, the value and optionally the size of
+     * the value (for Boolean), the bitMask (for Bit) and the offset and size of the metadata. The metadata is reset
+     * to error code 0 and state 0 in the same semaphore acquisition.
+     *
+     * @param info the callback info
+     */
+    void writeTyped(const Napi::CallbackInfo &info);
+
+    /**
+     * Get an ArrayBuffer that is backed directly by a read-only mapping of the whole segment. The mapping lives as
+     * long as any view or the wrapper uses it. Writing to the view terminates the process with SIGSEGV.
+     * Reads are verified with snapshotVersion() and validate(), so a singleBufferSemaphore can't be mapped. The
+     * ArrayBuffer is internal to the JS module, which only hands out typed getters.
+     *
+     * @param info the callback info
+     * @return the external ArrayBuffer
+     */
+    Napi::Value mapView(const Napi::CallbackInfo &info);
+
+    /**
+     * Wait until the producer is not writing and return the sequence number to validate a read of the view
+     *
+     * @param info the callback info
+     * @return the sequence number
+     */
+    Napi::Value snapshotVersion(const Napi::CallbackInfo &info);
+
+    /**
+     * Check that the producer has not written since snapshotVersion()
+     *
+     * @param info the callback info with the sequence number returned by snapshotVersion()
+     * @return true if everything read from the view since snapshotVersion() is consistent
+     */
+    Napi::Value validate(const Napi::CallbackInfo &info);
+
+    /**
+     * Get the offset of the current buffer in the view, which changes with the active half of a double buffer.
+     * It has to be read after snapshotVersion() and is only valid if validate() succeeds.
+     *
+     * @param info the callback info
+     * @return the offset of the current buffer relative to the segment
+     */
+    Napi::Value currentBufferOffset(const Napi::CallbackInfo &info);
+
+    /**
+     * Set the deadline for a consistent read of a buffer with a sequence number. A read that does not get a
+     * consistent copy until the deadline throws an Error with the code ERR_READ_TIMEOUT.
+     *
+     * @param info the callback info with the timeout in ms
+     */
+    void setReadTimeout(const Napi::CallbackInfo &info);
+
+    /**
+     * Set the deadline to lock the semaphore for a write or for a read of a singleBufferSemaphore. An operation
+     * that does not get the semaphore until the deadline throws an Error with the code ERR_LOCK_TIMEOUT.
+     *
+     * @param info the callback info with the timeout in ms
+     */
+    void setLockTimeout(const Napi::CallbackInfo &info);
+
+    /**
+     * Get the counters of the semaphore of the segment
+     *
+     * @param info the callback info
+     * @return the numbers of locks, contended locks, timeouts and failures, the total and maximal wait time in µs
+     *         and the wait time histogram
+     */
+    Napi::Value getLockStatistics(const Napi::CallbackInfo &info);
+
+    /**
+     * Get the counters of the segment: the reads with their bytes, retries, timeouts and failures, the writes with
+     * their bytes and failures, the counters of the semaphore and the latency histograms of reads and writes
+     *
+     * @param info the callback info
+     * @return the counters and for each histogram the count, the sum, the maximum, the main percentiles and the
+     *         non-empty buckets, all latencies in ns
+     */
+    Napi::Value getStats(const Napi::CallbackInfo &info);
+
+    /**
+     * Reset all counters and histograms of the segment to 0
+     *
+     * @param info the callback info
+     */
+    void resetStats(const Napi::CallbackInfo &info);
+
+    /**
+     * Watch process values for changes. A native thread per segment samples the sequence number of the buffer and
+     * calls the callback with the changed values only. The first call contains all values.
+     *
+     * @param info the callback info with the descriptor table, the minimal interval in ms and the callback
+     * @return the id of the subscription
+     */
+    Napi::Value watch(const Napi::CallbackInfo &info);
+
+    /**
+     * Watch process values for changes like watch, but the changes are pushed into a ring buffer, which JS drains
+     * in batches. The callback is called without arguments when the ring buffer has to be drained.
+     *
+     * @param info the callback info with the descriptor table, the minimal interval in ms, the capacity of the ring
+     *             buffer in changes and the callback
+     * @return the id of the subscription and the ring buffer as ArrayBuffer
+     */
+    Napi::Value watchBatched(const Napi::CallbackInfo &info);
+
+    /**
+     * Stop watching process values
+     *
+     * @param info the callback info with the id of the subscription
+     * @return true if the subscription existed
+     */
+    Napi::Value unwatch(const Napi::CallbackInfo &info);
+
+    /**
+     * Record process values with a fixed period into a columnar binary file. A native sampler thread takes a
+     * consistent snapshot per period, a native writer thread appends the samples to the file in blocks.
+     *
+     * @param info the callback info with the descriptor table, the period in µs, the file name, true for delta encoding
+     *             and an info string that is stored in the header of the file
+     * @return the id of the recording
+     */
+    Napi::Value startRecording(const Napi::CallbackInfo &info);
+
+    /**
+     * Stop a recording, write its remaining samples and close its file
+     *
+     * @param info the callback info with the id of the recording
+     * @return the final statistics of the recording or undefined if the recording does not exist
+     */
+    Napi::Value stopRecording(const Napi::CallbackInfo &info);
+
+    /**
+     * Get the counters of a running recording
+     *
+     * @param info the callback info with the id of the recording
+     * @return the numbers of samples, dropped samples, missed periods, read failures, written blocks and bytes and
+     *         write errors or undefined if the recording does not exist
+     */
+    Napi::Value getRecordingStatistics(const Napi::CallbackInfo &info);
+
+    /**
+     * Stop all watches and recordings and release the segment. The mapping of the shared memory is unmapped when no
+     * other SharedMemory instance uses it. All other methods throw after close.
+     *
+     * @param info the callback info
+     */
+    void close(const Napi::CallbackInfo &info);
+
+    /**
+     * Get the counters of the process-wide pool of shared memory mappings
+     *
+     * @param info the callback info
+     * @return the number of live mappings, the mapped bytes and the numbers of created, released and reused mappings
+     */
+    static Napi::Value getMappingStatistics(const Napi::CallbackInfo &info);
+
+    /**
+     * Get a process description shared by all threads of the process
+     *
+     * @param info the callback info with the key of the description
+     * @return the description as string or undefined if it has not been published
+     */
+    static Napi::Value getSharedDescription(const Napi::CallbackInfo &info);
+
+    /**
+     * Claim the fetch of a process description for the calling thread, so the other threads wait for it
+     *
+     * @param info the callback info with the key of the description
+     * @return true if the calling thread has to fetch and publish the description or release the claim
+     */
+    static Napi::Value claimSharedDescription(const Napi::CallbackInfo &info);
+
+    /**
+     * Publish a process description to all threads and release the claim on it
+     *
+     * @param info the callback info with the key and the description as string
+     */
+    static void publishSharedDescription(const Napi::CallbackInfo &info);
+
+    /**
+     * Release the claim of the calling thread on a process description after its fetch failed
+     *
+     * @param info the callback info with the key of the description
+     */
+    static void releaseSharedDescription(const Napi::CallbackInfo &info);
+
+    /**
+     * Set the listener of the calling thread, it is called with the key of a description the thread waits for, i.e.
+     * whose claim by another thread made claimSharedDescription return false, once it is published or released
+     *
+     * @param info the callback info with the listener
+     */
+    static void setSharedDescriptionListener(const Napi::CallbackInfo &info);
+
+    /**
+     * Compare two snapshots of the same range of a current buffer and decode the values that changed between them.
+     * The snapshots are compared with SIMD instructions, the changed byte ranges are mapped to the entries of the
+     * descriptor table whose value or metadata overlaps them. Without a previous snapshot all values have changed.
+     *
+     * @param info the callback info with the previous snapshot or null, the current snapshot, the descriptor table
+     *             and the offset of the snapshots relative to the current buffer
+     * @return an object with the changed byte ranges as pairs of offset and length, the indices of the changed
+     *         entries, their decoded values and their error codes
+     */
+    static Napi::Value diffSnapshots(const Napi::CallbackInfo &info);
+
+    /**
+     * Convert a decoded process value into a JS value
+     *
+     * @param env the environment
+     * @param decodedValue the decoded value
+     * @return the JS value
+     */
+    static Napi::Value toNapiValue(Napi::Env env, const ProcessValueDecoder::DecodedValue &decodedValue);
+
+    /**
+     * Convert a decoded process value into a JS value, texts are taken from the interned strings if unchanged
+     *
+     * @param env the environment
+     * @param decodedValue the decoded value
+     * @param strings the interned strings of the shared memory
+     * @param offset the offset of the value
+     * @return the JS value
+     */
+    static Napi::Value toNapiValue(Napi::Env env, const ProcessValueDecoder::DecodedValue &decodedValue, StringInterner &strings, size_t offset);
+
+    /**
+     * Create the error of a failed read, ERR_READ_TIMEOUT for a buffer with a sequence number, otherwise the error
+     * of the failed lock of the semaphore
+     *
+     * @param env the environment
+     * @param segment the segment that could not be read
+     * @param error the errno of the failed read, captured by the thread that read
+     * @return the error
+     */
+    static Napi::Error createReadError(Napi::Env env, const SharedMemorySegment &segment, int error = errno);
+
+    /**
+     * Create the error of a failed lock of the semaphore, ERR_LOCK_TIMEOUT if the deadline has been reached,
+     * otherwise ERR_SEMAPHORE_LOCK
+     *
+     * @param env the environment
+     * @param message the message of the error
+     * @param error the errno of the failed lock, captured by the thread that locked
+     * @return the error
+     */
+    static Napi::Error createLockError(Napi::Env env, const std::string &message, int error = errno);
+
     /**
      * Destroy the shared memory instance
      */
     ~SharedMemory() override;
 
 private:
-    // Properties and pointer of the memory block
-    size_t m_size;
-    char *m_buffer;
-    bool m_isDoubleBuffer;
+    // the data of the addon per environment, the main thread and every worker thread have their own
+    struct InstanceData;
+
+    static SharedMemorySegment::BufferType getBufferType(const Napi::Value &value);
+    static void cleanUp(InstanceData *pInstanceData);
+    static std::string getKeyArgument(const Napi::CallbackInfo &info, const char *function);
+    static void notifySharedDescription(Napi::Env env, Napi::Function callback, std::string *pKey);
+    void release();
+    void checkOpen(Napi::Env env) const;
+    void parseDescriptorTable(const Napi::Value &value, std::vector<ProcessValueDecoder::Descriptor> &descriptors) const;
+    static void parseDescriptorTable(const Napi::Value &value, size_t rangeStart, size_t rangeEnd, std::vector<ProcessValueDecoder::Descriptor> &descriptors);
+    void parseWriteOperation(const Napi::Value &value, char *pEncoded, SharedMemorySegment::WriteOperation &operation) const;
+    static Napi::Value toNapiRecordingStatistics(Napi::Env env, const SharedMemoryRecorder &recorder);
+    static Napi::Value toNapiLockStatistics(Napi::Env env, const SharedMemorySegment::LockStatistics &statistics);
+    static Napi::Value toNapiLatencyHistogram(Napi::Env env, const LatencyHistogram::Snapshot &snapshot);
+    static void encodeValue(const Napi::Value &value, ProcessValueDecoder::ValueType type, size_t size, char *destination, size_t &length);
+
+    // the live instances of the environment, they outlive its instance data to be unregistered by the finalizers
+    std::shared_ptr<std::set<SharedMemory *>> m_instances;
+
+    // the segment is shared with native threads, which can outlive a call into the addon
+    std::shared_ptr<SharedMemorySegment> m_segment;
+    std::unique_ptr<SharedMemoryWatcher> m_watcher;
+    std::map<uint32_t, std::unique_ptr<SharedMemoryRecorder>> m_recorders;
+    // shared with the read workers, which convert their values after the instance may have been finalized
+    std::shared_ptr<StringInterner> m_strings;
+    uint32_t m_nextRecordingId = 1;
+
+    // reused between batch reads to avoid allocations
+    std::vector<ProcessValueDecoder::Descriptor> m_descriptors;
+    std::vector<char> m_snapshot;
+    ProcessValueDecoder::DecodedValue m_decodedValue;
 
-    SystemVSemaphore m_semaphoreLock;
+    // reused between batch writes to avoid allocations
+    std::vector<SharedMemorySegment::WriteOperation> m_writeOperations;
+    std::vector<char> m_encodedValues;
 };
@@ -0,0 +1,176 @@
+/*!
+ * @file   SharedMemoryMappingPool.cpp
+ *
+ * @brief  This class shares one mapping per POSIX shared memory name between all segments of the process.
+ *         A mapping is unmapped when the last segment releases it.
+ *
+ */
+
+#include "SharedMemoryMappingPool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/fcntl.h>
+
+namespace
+{
+    std::string getErrnoAsString()
+    {
+        return strerror(errno);
+    }
+
+    struct Pool
+    {
+        std::mutex mutex;
+        std::map<std::string, std::weak_ptr<SharedMemoryMappingPool::Mapping>> mappings;
+        SharedMemoryMappingPool::Statistics statistics = {};
+    };
+
+    // the pool is never destroyed, mappings released during the exit of the process must still find it
+    Pool &getPool()
+    {
+        static Pool *pPool = new Pool();
+        return *pPool;
+    }
+}
+
+SharedMemoryMappingPool::Mapping::Mapping(const std::string &name, size_t minimalSize)
+    : m_name(name),
+      m_data(nullptr),
+      m_size(0)
+{
+    int shmFileDescriptor = shm_open(name.c_str(), O_RDWR, 0666);
+    if (shmFileDescriptor < 0)
+    {
+        throw std::runtime_error("Could not get the shared memory segment: " + getErrnoAsString());
+    }
+
+    // map the whole shared memory, so every attachment with a different offset can share the mapping
+    struct stat status;
+    if (fstat(shmFileDescriptor, &status) < 0)
+    {
+        const std::string error = getErrnoAsString();
+        close(shmFileDescriptor);
+        throw std::runtime_error("Could not get the size of the shared memory segment: " + error);
+    }
+    // pages beyond the end of the shared memory would raise SIGBUS on access
+    if (static_cast<size_t>(status.st_size) < minimalSize)
+    {
+        close(shmFileDescriptor);
+        throw std::runtime_error("The shared memory segment has " + std::to_string(status.st_size) + " bytes, but " + std::to_string(minimalSize) +
+                                 " bytes are needed");
+    }
+    m_size = static_cast<size_t>(status.st_size);
+
+    void *pData = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFileDescriptor, 0);
+    const std::string error = getErrnoAsString();
+
+    // the mapping stays valid without the file descriptor
+    close(shmFileDescriptor);
+
+    if (pData == MAP_FAILED)
+    {
+        throw std::runtime_error("Could not attach the shared memory segment: " + error);
+    }
+    m_data = static_cast<char *>(pData);
+
+    // counted here, because the destructor counts every mapping as released, including one that lost a race in acquire
+    Pool &pool = getPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.statistics.liveMappings++;
+    pool.statistics.mappedBytes += m_size;
+    pool.statistics.createdMappings++;
+}
+
+SharedMemoryMappingPool::Mapping::~Mapping()
+{
+    munmap(m_data, m_size);
+
+    Pool &pool = getPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    // the name can already belong to a newer mapping
+    auto it = pool.mappings.find(m_name);
+    if (it != pool.mappings.end() && it->second.expired())
+    {
+        pool.mappings.erase(it);
+    }
+    pool.statistics.liveMappings--;
+    pool.statistics.mappedBytes -= m_size;
+    pool.statistics.releasedMappings++;
+}
+
+const std::string &SharedMemoryMappingPool::Mapping::getName() const
+{
+    return m_name;
+}
+
+char *SharedMemoryMappingPool::Mapping::getData() const
+{
+    return m_data;
+}
+
+size_t SharedMemoryMappingPool::Mapping::getSize() const
+{
+    return m_size;
+}
+
+std::shared_ptr<SharedMemoryMappingPool::Mapping> SharedMemoryMappingPool::acquire(const std::string &name, size_t minimalSize)
+{
+    Pool &pool = getPool();
+
+    // a mapping that is too small is released outside of the lock, its destructor locks the pool as well
+    std::shared_ptr<Mapping> existing;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto it = pool.mappings.find(name);
+        if (it != pool.mappings.end())
+        {
+            existing = it->second.lock();
+            if (existing && existing->getSize() >= minimalSize)
+            {
+                pool.statistics.reusedMappings++;
+                return existing;
+            }
+        }
+    }
+
+    // mapping can take a while, so it is done outside of the lock
+    auto mapping = std::make_shared<Mapping>(name, minimalSize);
+
+    // another thread can have mapped the same name meanwhile, the mapping of the loser is released outside of the lock
+    std::shared_ptr<Mapping> winner;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto it = pool.mappings.find(name);
+        if (it != pool.mappings.end())
+        {
+            winner = it->second.lock();
+        }
+        if (winner && winner->getSize() >= minimalSize)
+        {
+            pool.statistics.reusedMappings++;
+        }
+        else
+        {
+            pool.mappings[name] = mapping;
+            winner = mapping;
+        }
+    }
+    return winner;
+}
+
+SharedMemoryMappingPool::Statistics SharedMemoryMappingPool::getStatistics()
+{
+    Pool &pool = getPool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.statistics;
+}
@@ -0,0 +1,65 @@
+/*!
+ * @file   SharedMemoryMappingPool.hpp
+ *
+ * @brief  This class shares one mapping per POSIX shared memory name between all segments of the process.
+ *         A mapping is unmapped when the last segment releases it.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class SharedMemoryMappingPool
+{
+public:
+    /**
+     * A read-write mapping of a POSIX shared memory. The file descriptor is closed right after mapping.
+     */
+    class Mapping
+    {
+    public:
+        Mapping(const std::string &name, size_t minimalSize);
+        Mapping(const Mapping &other) = delete;
+        ~Mapping();
+
+        Mapping &operator=(const Mapping &other) = delete;
+
+        const std::string &getName() const;
+        char *getData() const;
+        size_t getSize() const;
+
+    private:
+        std::string m_name;
+        char *m_data;
+        size_t m_size;
+    };
+
+    struct Statistics
+    {
+        // mappings that are currently in use
+        size_t liveMappings;
+        size_t mappedBytes;
+        // mappings created and released since the start of the process
+        uint64_t createdMappings;
+        uint64_t releasedMappings;
+        // attachments that reused a live mapping
+        uint64_t reusedMappings;
+    };
+
+    /**
+     * Get the mapping of a shared memory. A live mapping is reused if it is large enough, otherwise the shared
+     * memory is mapped again.
+     *
+     * @param name the name of the POSIX shared memory
+     * @param minimalSize the number of bytes the caller needs to access
+     * @return the mapping, which is unmapped when the last owner releases it
+     * @throws std::runtime_error if the shared memory can't be opened or mapped or is smaller than minimalSize
+     */
+    static std::shared_ptr<Mapping> acquire(const std::string &name, size_t minimalSize);
+
+    static Statistics getStatistics();
+};
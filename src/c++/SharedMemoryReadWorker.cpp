@@ -0,0 +1,73 @@
+#include "SharedMemoryReadWorker.hpp"
+#include "SharedMemory.hpp"
+
+#include <cerrno>
+
+SharedMemoryReadWorker::SharedMemoryReadWorker(Napi::Env env, std::shared_ptr<SharedMemorySegment> segment, std::shared_ptr<StringInterner> strings,
+                                               std::vector<ProcessValueDecoder::Descriptor> descriptors)
+    : Napi::AsyncWorker(env, "SharedMemoryReadWorker"),
+      m_segment(std::move(segment)),
+      m_strings(std::move(strings)),
+      m_descriptors(std::move(descriptors)),
+      m_deferred(Napi::Promise::Deferred::New(env)),
+      m_errno(0)
+{
+}
+
+Napi::Promise SharedMemoryReadWorker::getPromise() const
+{
+    return m_deferred.Promise();
+}
+
+void SharedMemoryReadWorker::Execute()
+{
+    if (m_descriptors.empty())
+    {
+        return;
+    }
+
+    // the snapshot covers all values and their metadata
+    size_t snapshotStart = 0;
+    std::vector<char> snapshot(ProcessValueDecoder::getSnapshotRange(m_descriptors, snapshotStart));
+
+    if (!m_segment->copyConsistent(snapshot.data(), snapshotStart, snapshot.size(), true))
+    {
+        // the error is created on the main thread, errno of this thread is gone by then
+        m_errno = errno;
+        SetError("Unable to read values");
+        return;
+    }
+
+    m_values.resize(m_descriptors.size());
+    for (size_t i = 0; i < m_descriptors.size(); i++)
+    {
+        ProcessValueDecoder::decode(snapshot.data(), snapshotStart, m_descriptors[i], m_values[i]);
+    }
+}
+
+void SharedMemoryReadWorker::OnOK()
+{
+    Napi::Env env = Env();
+
+    const size_t numberOfValues = m_values.size();
+    Napi::Array values = Napi::Array::New(env, numberOfValues);
+    Napi::Uint32Array errorCodes = Napi::Uint32Array::New(env, numberOfValues);
+    Napi::Uint8Array hasErrorCodes = Napi::Uint8Array::New(env, numberOfValues);
+    for (size_t i = 0; i < numberOfValues; i++)
+    {
+        values.Set(i, SharedMemory::toNapiValue(env, m_values[i], *m_strings, m_descriptors[i].offset));
+        errorCodes[i] = m_values[i].errorCode;
+        hasErrorCodes[i] = m_values[i].hasErrorCode ? 1 : 0;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("values", values);
+    result.Set("errorCodes", errorCodes);
+    result.Set("hasErrorCodes", hasErrorCodes);
+    m_deferred.Resolve(result);
+}
+
+void SharedMemoryReadWorker::OnError(const Napi::Error &)
+{
+    m_deferred.Reject(SharedMemory::createReadError(Env(), *m_segment, m_errno).Value());
+}
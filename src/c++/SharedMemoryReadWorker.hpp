@@ -0,0 +1,52 @@
+/*!
+ * @file   SharedMemoryReadWorker.hpp
+ *
+ * @brief  This class reads and decodes many process values out of one consistent snapshot on a thread of the libuv
+ *         thread pool and resolves a promise with the decoded values.
+ *
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <napi.h>
+
+#include "ProcessValueDecoder.hpp"
+#include "SharedMemorySegment.hpp"
+#include "StringInterner.hpp"
+
+class SharedMemoryReadWorker : public Napi::AsyncWorker
+{
+public:
+    /**
+     * Create a worker for the parsed descriptor table, the worker deletes itself after the promise is settled
+     *
+     * @param env the environment
+     * @param segment the segment to read, kept alive until the worker is done
+     * @param strings the interned strings of the shared memory, only used on the main thread
+     * @param descriptors the descriptions of the values to read
+     */
+    SharedMemoryReadWorker(Napi::Env env, std::shared_ptr<SharedMemorySegment> segment, std::shared_ptr<StringInterner> strings,
+                           std::vector<ProcessValueDecoder::Descriptor> descriptors);
+
+    /**
+     * Get the promise, which resolves with the decoded values and their error codes
+     *
+     * @return the promise
+     */
+    Napi::Promise getPromise() const;
+
+protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error &error) override;
+
+private:
+    std::shared_ptr<SharedMemorySegment> m_segment;
+    std::shared_ptr<StringInterner> m_strings;
+    std::vector<ProcessValueDecoder::Descriptor> m_descriptors;
+    std::vector<ProcessValueDecoder::DecodedValue> m_values;
+    Napi::Promise::Deferred m_deferred;
+    int m_errno;
+};
@@ -0,0 +1,330 @@
+/*!
+ * @file   SharedMemoryRecorder.cpp
+ *
+ * @brief  This class samples process values of a shared memory segment with a fixed period on a native thread and
+ *         appends them to a columnar binary file.
+ *
+ */
+
+#include "SharedMemoryRecorder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace
+{
+    const char fileMagic[8] = {'V', 'T', 'R', 'N', 'R', 'E', 'C', '1'};
+    const char blockMagic[4] = {'V', 'B', 'L', 'K'};
+    const uint32_t deltaEncodingFlag = 1;
+
+    const size_t timestampSize = sizeof(int64_t);
+
+    // a block is written when it is full or when its first record is older than the flush interval
+    const size_t recordsPerBlock = 1024;
+    const std::chrono::seconds flushInterval(1);
+    const std::chrono::milliseconds writerPollPeriod(10);
+
+    // the ring buffer takes the records of about two seconds while the writer waits for the file system
+    const size_t minimalRingCapacity = 1024;
+    const size_t maximalRingCapacity = 1 << 20;
+
+    bool isIntegerType(ProcessValueDecoder::ValueType type)
+    {
+        switch (type)
+        {
+        case ProcessValueDecoder::ValueType::Double:
+        case ProcessValueDecoder::ValueType::Float:
+        case ProcessValueDecoder::ValueType::String:
+        case ProcessValueDecoder::ValueType::Selection:
+        case ProcessValueDecoder::ValueType::Selector:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    size_t getRecordSize(const std::vector<ProcessValueDecoder::Descriptor> &descriptors)
+    {
+        size_t recordSize = timestampSize;
+        for (const auto &descriptor : descriptors)
+        {
+            recordSize += ProcessValueDecoder::getSizeOfValue(descriptor);
+        }
+        return recordSize;
+    }
+
+    size_t getRingCapacity(std::chrono::nanoseconds period)
+    {
+        const size_t recordsOfTwoSeconds = static_cast<size_t>(std::chrono::nanoseconds(std::chrono::seconds(2)) / std::max(period, std::chrono::nanoseconds(1)));
+        return std::min(std::max(recordsOfTwoSeconds, minimalRingCapacity), maximalRingCapacity);
+    }
+
+    template <typename T>
+    void append(std::vector<char> &destination, const T &value)
+    {
+        const char *pValue = reinterpret_cast<const char *>(&value);
+        destination.insert(destination.end(), pValue, pValue + sizeof(T));
+    }
+
+    void appendVarint(std::vector<char> &destination, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            destination.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        destination.push_back(static_cast<char>(value));
+    }
+}
+
+SharedMemoryRecorder::SharedMemoryRecorder(std::shared_ptr<SharedMemorySegment> segment, std::vector<ProcessValueDecoder::Descriptor> descriptors,
+                                           std::chrono::nanoseconds period, const std::string &fileName, bool deltaEncoding, const std::string &info)
+    : m_segment(std::move(segment)),
+      m_period(period),
+      m_deltaEncoding(deltaEncoding),
+      m_snapshotStart(0),
+      m_snapshotSize(ProcessValueDecoder::getSnapshotRange(descriptors, m_snapshotStart)),
+      m_recordSize(getRecordSize(descriptors)),
+      m_ring(m_recordSize, getRingCapacity(period)),
+      m_pFile(nullptr),
+      m_block(recordsPerBlock * m_recordSize),
+      m_numberOfBlockRecords(0),
+      m_fileFailed(false),
+      m_sampling(true),
+      m_writing(true)
+{
+    size_t recordOffset = timestampSize;
+    for (const auto &descriptor : descriptors)
+    {
+        Column column;
+        column.snapshotOffset = descriptor.offset - m_snapshotStart;
+        column.recordOffset = recordOffset;
+        column.width = ProcessValueDecoder::getSizeOfValue(descriptor);
+        column.deltaEncoded = deltaEncoding && isIntegerType(descriptor.type);
+        column.bitMask = descriptor.bitMask;
+        m_columns.push_back(column);
+        recordOffset += column.width;
+    }
+
+    m_pFile = std::fopen(fileName.c_str(), "wb");
+    if (m_pFile == nullptr)
+    {
+        throw std::runtime_error("Could not create the recording file " + fileName + ": " + strerror(errno));
+    }
+    // unbuffered, so nothing of a block that failed is written later and the block can be cut off the file
+    std::setvbuf(m_pFile, nullptr, _IONBF, 0);
+    if (!writeHeader(info))
+    {
+        const std::string error = strerror(errno);
+        std::fclose(m_pFile);
+        throw std::runtime_error("Could not write the header of the recording file " + fileName + ": " + error);
+    }
+
+    m_samplerThread = std::thread(&SharedMemoryRecorder::sample, this);
+    m_writerThread = std::thread(&SharedMemoryRecorder::write, this);
+}
+
+SharedMemoryRecorder::~SharedMemoryRecorder()
+{
+    stop();
+}
+
+void SharedMemoryRecorder::stop()
+{
+    if (!m_writerThread.joinable())
+    {
+        return;
+    }
+
+    m_sampling = false;
+    m_samplerThread.join();
+    m_writing = false;
+    m_writerThread.join();
+
+    std::fclose(m_pFile);
+    m_pFile = nullptr;
+}
+
+SharedMemoryRecorder::Statistics SharedMemoryRecorder::getStatistics() const
+{
+    Statistics statistics;
+    statistics.samples = m_counters.samples.load(std::memory_order_relaxed);
+    statistics.droppedSamples = m_ring.getDroppedRecords();
+    statistics.missedPeriods = m_counters.missedPeriods.load(std::memory_order_relaxed);
+    statistics.readFailures = m_counters.readFailures.load(std::memory_order_relaxed);
+    statistics.writtenBlocks = m_counters.writtenBlocks.load(std::memory_order_relaxed);
+    statistics.writtenBytes = m_counters.writtenBytes.load(std::memory_order_relaxed);
+    statistics.writeErrors = m_counters.writeErrors.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void SharedMemoryRecorder::sample()
+{
+    std::vector<char> snapshot(m_snapshotSize);
+    std::vector<char> record(m_recordSize);
+
+    // absolute deadlines, so the period does not drift by the time of a sample
+    auto deadline = std::chrono::steady_clock::now();
+    while (m_sampling)
+    {
+        deadline += m_period;
+        std::this_thread::sleep_until(deadline);
+
+        // a late sampler skips the missed periods instead of catching up with a burst of samples
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline + m_period)
+        {
+            const auto missedPeriods = (now - deadline) / m_period;
+            m_counters.missedPeriods.fetch_add(missedPeriods, std::memory_order_relaxed);
+            deadline += missedPeriods * m_period;
+        }
+
+        const int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        if (!m_segment->copyConsistent(snapshot.data(), m_snapshotStart, snapshot.size(), true))
+        {
+            m_counters.readFailures.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        memcpy(record.data(), &timestamp, timestampSize);
+        for (const auto &column : m_columns)
+        {
+            memcpy(record.data() + column.recordOffset, snapshot.data() + column.snapshotOffset, column.width);
+        }
+
+        // a full ring buffer counts the dropped sample
+        if (m_ring.tryPush(record.data()))
+        {
+            m_counters.samples.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SharedMemoryRecorder::write()
+{
+    auto blockStart = std::chrono::steady_clock::now();
+    while (true)
+    {
+        // read before draining, so the records of a stopped sampler are all drained
+        const bool writing = m_writing;
+
+        while (m_numberOfBlockRecords < recordsPerBlock && m_ring.tryPop(m_block.data() + m_numberOfBlockRecords * m_recordSize))
+        {
+            if (m_numberOfBlockRecords == 0)
+            {
+                blockStart = std::chrono::steady_clock::now();
+            }
+            m_numberOfBlockRecords++;
+        }
+        const bool drained = m_numberOfBlockRecords < recordsPerBlock;
+
+        if (m_numberOfBlockRecords > 0 && (!drained || !writing || std::chrono::steady_clock::now() - blockStart >= flushInterval))
+        {
+            writeBlock();
+        }
+
+        if (drained)
+        {
+            if (!writing)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(writerPollPeriod);
+        }
+    }
+}
+
+bool SharedMemoryRecorder::writeHeader(const std::string &info)
+{
+    std::vector<char> header(fileMagic, fileMagic + sizeof(fileMagic));
+    append(header, static_cast<uint32_t>(m_deltaEncoding ? deltaEncodingFlag : 0));
+    append(header, static_cast<uint32_t>(m_columns.size()));
+    append(header, static_cast<uint64_t>(m_period.count()));
+    for (const auto &column : m_columns)
+    {
+        append(header, static_cast<uint8_t>(column.deltaEncoded ? 1 : 0));
+        append(header, column.bitMask);
+        append(header, static_cast<uint16_t>(column.width));
+    }
+    append(header, static_cast<uint32_t>(info.size()));
+    header.insert(header.end(), info.begin(), info.end());
+
+    return writeToFile(header.data(), header.size());
+}
+
+void SharedMemoryRecorder::writeBlock()
+{
+    // the timestamps are encoded like a column at the start of each record
+    Column timestamps = {};
+    timestamps.recordOffset = 0;
+    timestamps.width = timestampSize;
+    timestamps.deltaEncoded = m_deltaEncoding;
+
+    m_payload.clear();
+    encodeColumn(timestamps);
+    for (const auto &column : m_columns)
+    {
+        encodeColumn(column);
+    }
+
+    std::vector<char> blockHeader(blockMagic, blockMagic + sizeof(blockMagic));
+    append(blockHeader, static_cast<uint32_t>(m_numberOfBlockRecords));
+    append(blockHeader, static_cast<uint32_t>(m_payload.size()));
+
+    const off_t blockStart = ftello(m_pFile);
+    if (!m_fileFailed && writeToFile(blockHeader.data(), blockHeader.size()) && writeToFile(m_payload.data(), m_payload.size()))
+    {
+        m_counters.writtenBlocks.fetch_add(1, std::memory_order_relaxed);
+        m_counters.writtenBytes.fetch_add(blockHeader.size() + m_payload.size(), std::memory_order_relaxed);
+    }
+    else
+    {
+        m_counters.writeErrors.fetch_add(1, std::memory_order_relaxed);
+        if (!m_fileFailed && !truncateFile(blockStart))
+        {
+            // a partial block can't be removed, the blocks behind it would not be found by a reader
+            m_fileFailed = true;
+            m_sampling = false;
+        }
+    }
+    m_numberOfBlockRecords = 0;
+}
+
+bool SharedMemoryRecorder::truncateFile(off_t length)
+{
+    // e.g. the file system was full, the next block is written to the end of the last complete one
+    std::clearerr(m_pFile);
+    return length >= 0 && ftruncate(fileno(m_pFile), length) == 0 && fseeko(m_pFile, length, SEEK_SET) == 0;
+}
+
+void SharedMemoryRecorder::encodeColumn(const Column &column)
+{
+    if (!column.deltaEncoded)
+    {
+        for (size_t i = 0; i < m_numberOfBlockRecords; i++)
+        {
+            const char *pValue = m_block.data() + i * m_recordSize + column.recordOffset;
+            m_payload.insert(m_payload.end(), pValue, pValue + column.width);
+        }
+        return;
+    }
+
+    uint64_t previous = 0;
+    for (size_t i = 0; i < m_numberOfBlockRecords; i++)
+    {
+        uint64_t value = 0;
+        memcpy(&value, m_block.data() + i * m_recordSize + column.recordOffset, column.width);
+        const int64_t difference = static_cast<int64_t>(value - previous);
+        appendVarint(m_payload, (static_cast<uint64_t>(difference) << 1) ^ static_cast<uint64_t>(difference >> 63));
+        previous = value;
+    }
+}
+
+bool SharedMemoryRecorder::writeToFile(const char *pData, size_t length)
+{
+    return std::fwrite(pData, 1, length, m_pFile) == length;
+}
@@ -0,0 +1,144 @@
+/*!
+ * @file   SharedMemoryRecorder.hpp
+ *
+ * @brief  This class samples process values of a shared memory segment with a fixed period on a native thread and
+ *         appends them to a columnar binary file.
+ *
+ * A sampler thread takes a consistent snapshot per period and pushes a record with the timestamp and the raw bytes of
+ * the values into a lock-free ring buffer. A writer thread collects the records into blocks and appends them to the
+ * file, so a slow file system does not delay the sampling.
+ *
+ * The file starts with a header:
+ *   char[8]  magic "VTRNREC1"
+ *   uint32   flags, bit 0 set if integer columns and timestamps are delta encoded
+ *   uint32   number of columns
+ *   uint64   period in ns
+ *   per column: uint8 encoding (0 raw, 1 delta), uint8 bitMask, uint16 width in bytes
+ *   uint32   length of the info, followed by the info, a UTF-8 JSON string of the caller
+ *
+ * followed by blocks, which can be decoded independently of each other:
+ *   uint32   magic "VBLK"
+ *   uint32   number of records
+ *   uint32   length of the payload
+ *   payload  the timestamps in ns since the epoch as int64, then each column with the raw values as fixed width fields
+ *
+ * With delta encoding the timestamps and the delta encoded columns contain the differences to the previous value of the
+ * block as zigzag encoded varints, the first value is the difference to 0. The differences of a column are computed on
+ * its raw bytes as unsigned integer modulo 2^64. All numbers are little endian.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "ProcessValueDecoder.hpp"
+#include "SampleRing.hpp"
+#include "SharedMemorySegment.hpp"
+
+class SharedMemoryRecorder
+{
+public:
+    struct Statistics
+    {
+        // records pushed into the ring buffer
+        uint64_t samples;
+        // samples lost because the ring buffer was full
+        uint64_t droppedSamples;
+        // periods the sampler missed because it was late
+        uint64_t missedPeriods;
+        // periods without a consistent snapshot
+        uint64_t readFailures;
+        uint64_t writtenBlocks;
+        uint64_t writtenBytes;
+        // blocks that were not written, a partially written block is cut off the file again
+        uint64_t writeErrors;
+    };
+
+    /**
+     * Create the file, write its header and start the sampler and the writer thread
+     *
+     * @param segment the segment to sample, kept alive until the recorder is stopped
+     * @param descriptors the descriptions of the values to sample, at least one
+     * @param period the sampling period
+     * @param fileName the name of the file, an existing file is truncated
+     * @param deltaEncoding true to delta encode the timestamps and the integer columns
+     * @param info an arbitrary string that is stored in the header, e.g. the selectors of the columns
+     * @throws std::runtime_error if the file can't be created
+     */
+    SharedMemoryRecorder(std::shared_ptr<SharedMemorySegment> segment, std::vector<ProcessValueDecoder::Descriptor> descriptors,
+                         std::chrono::nanoseconds period, const std::string &fileName, bool deltaEncoding, const std::string &info);
+    SharedMemoryRecorder(const SharedMemoryRecorder &other) = delete;
+    ~SharedMemoryRecorder();
+
+    SharedMemoryRecorder &operator=(const SharedMemoryRecorder &other) = delete;
+
+    /**
+     * Stop the sampling, write the remaining records and close the file. Calling stop again has no effect.
+     */
+    void stop();
+
+    Statistics getStatistics() const;
+
+private:
+    struct Column
+    {
+        // offset of the value in the snapshot and in a record behind the timestamp
+        size_t snapshotOffset;
+        size_t recordOffset;
+        size_t width;
+        bool deltaEncoded;
+        uint8_t bitMask;
+    };
+
+    void sample();
+    void write();
+    bool writeHeader(const std::string &info);
+    void writeBlock();
+    bool truncateFile(off_t length);
+    void encodeColumn(const Column &column);
+    bool writeToFile(const char *pData, size_t length);
+
+    std::shared_ptr<SharedMemorySegment> m_segment;
+    std::chrono::nanoseconds m_period;
+    bool m_deltaEncoding;
+
+    std::vector<Column> m_columns;
+    size_t m_snapshotStart;
+    size_t m_snapshotSize;
+    size_t m_recordSize;
+    SampleRing m_ring;
+    std::FILE *m_pFile;
+
+    // the records of the current block, only used by the writer thread
+    std::vector<char> m_block;
+    size_t m_numberOfBlockRecords;
+    std::vector<char> m_payload;
+    // set if a partially written block couldn't be removed, the recording stops and drops the remaining records
+    bool m_fileFailed;
+
+    // the writer is stopped after the sampler, so it writes every pushed record
+    std::atomic<bool> m_sampling;
+    std::atomic<bool> m_writing;
+    std::thread m_samplerThread;
+    std::thread m_writerThread;
+
+    struct Counters
+    {
+        std::atomic<uint64_t> samples{0};
+        std::atomic<uint64_t> missedPeriods{0};
+        std::atomic<uint64_t> readFailures{0};
+        std::atomic<uint64_t> writtenBlocks{0};
+        std::atomic<uint64_t> writtenBytes{0};
+        std::atomic<uint64_t> writeErrors{0};
+    };
+    Counters m_counters;
+};
@@ -0,0 +1,619 @@
+/*!
+ * @file   SharedMemorySegment.cpp
+ *
+ * @brief  This class maps a shared memory segment and implements the read and write protocols of the different buffer types.
+ *         It does not depend on node, so it can be shared with native threads and used outside of the addon.
+ *
+ */
+
+#include "SharedMemorySegment.hpp"
+#include "SharedMemoryMappingPool.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/fcntl.h>
+
+#include <ck_sequence.h>
+
+namespace
+{
+    std::string getErrnoAsString()
+    {
+        return strerror(errno);
+    }
+
+    enum class ActiveBuffer
+    {
+        buffer1,
+        buffer2
+    };
+
+    struct ManagementBuffer
+    {
+        ActiveBuffer activeReadBuffer;
+        ActiveBuffer activeWriteBuffer;
+        ck_sequence_t seqlock;
+    };
+
+    struct SequenceLockManagementBuffer
+    {
+        unsigned int sequence;
+    };
+
+    // a collision with the producer usually lasts only as long as the producer needs to copy its buffer
+    const std::chrono::microseconds defaultReadTimeout(10000);
+
+    // the producers hold the semaphore only to copy their buffer, a longer wait means a hanging or dead producer
+    const std::chrono::microseconds defaultLockTimeout(100000);
+
+    /**
+     * Backoff of a reader that collides with the producer: spin first, then give the producer the CPU and finally
+     * sleep with an exponentially increasing duration until the deadline is reached.
+     */
+    class ReadRetry
+    {
+    public:
+        explicit ReadRetry(std::chrono::microseconds timeout) : m_timeout(timeout), m_started(false), m_attempt(0), m_sleepNs(minSleepNs) {}
+
+        /**
+         * Wait before the next attempt
+         *
+         * @return false if the deadline has been reached
+         */
+        bool backoff()
+        {
+            // the clock is only read after a collision, so an undisturbed read stays cheap
+            const auto now = std::chrono::steady_clock::now();
+            if (!m_started)
+            {
+                m_deadline = now + m_timeout;
+                m_started = true;
+            }
+            if (now >= m_deadline)
+            {
+                return false;
+            }
+
+            if (m_attempt < spinAttempts)
+            {
+                ck_pr_stall();
+            }
+            else if (m_attempt < spinAttempts + yieldAttempts)
+            {
+                sched_yield();
+            }
+            else
+            {
+                struct timespec duration = {0, m_sleepNs};
+                nanosleep(&duration, nullptr);
+                m_sleepNs = std::min(m_sleepNs * 2, maxSleepNs);
+            }
+            m_attempt++;
+            return true;
+        }
+
+    private:
+        static const unsigned int spinAttempts = 64;
+        static const unsigned int yieldAttempts = 16;
+        static const long minSleepNs = 1000;
+        static const long maxSleepNs = 100000;
+
+        std::chrono::microseconds m_timeout;
+        std::chrono::steady_clock::time_point m_deadline;
+        bool m_started;
+        unsigned int m_attempt;
+        long m_sleepNs;
+    };
+}
+
+SharedMemorySegment::ReadOnlyMapping::ReadOnlyMapping(const std::string &name, size_t size)
+    : m_data(nullptr),
+      m_size(size)
+{
+    int shmFileDescriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    if (shmFileDescriptor < 0)
+    {
+        throw std::runtime_error("Could not open the shared memory segment read-only: " + getErrnoAsString());
+    }
+
+    void *pData = mmap(0, m_size, PROT_READ, MAP_SHARED, shmFileDescriptor, 0);
+
+    // the mapping stays valid without the file descriptor
+    close(shmFileDescriptor);
+
+    if (pData == MAP_FAILED)
+    {
+        throw std::runtime_error("Could not map the shared memory segment read-only: " + getErrnoAsString());
+    }
+    m_data = static_cast<char *>(pData);
+}
+
+SharedMemorySegment::ReadOnlyMapping::~ReadOnlyMapping()
+{
+    munmap(m_data, m_size);
+}
+
+const char *SharedMemorySegment::ReadOnlyMapping::getData() const
+{
+    return m_data;
+}
+
+size_t SharedMemorySegment::ReadOnlyMapping::getSize() const
+{
+    return m_size;
+}
+
+SharedMemorySegment::SharedMemorySegment(const std::string &name,
+                                         size_t size,
+                                         BufferType bufferType,
+                                         size_t sizeOfSingleBuffer,
+                                         const std::string &semaphoreKey,
+                                         SystemVSemaphoreBaseClass::CreationType creationType)
+    : m_name(name),
+      m_size(size),
+      m_bufferType(bufferType),
+      m_sizeOfSingleBuffer(sizeOfSingleBuffer),
+      m_mapping(SharedMemoryMappingPool::acquire(name, size)),
+      m_buffer(m_mapping->getData()),
+      m_readTimeoutUs(defaultReadTimeout.count()),
+      m_lockTimeoutUs(defaultLockTimeout.count()),
+      m_semaphoreLock(semaphoreKey, creationType)
+{
+    #ifdef DEBUG
+    std::cout << "(native) buffer " << static_cast<void *>(m_buffer) << " of " << name << std::endl;
+    #endif
+}
+
+const std::string &SharedMemorySegment::getName() const
+{
+    return m_name;
+}
+
+size_t SharedMemorySegment::getSize() const
+{
+    return m_size;
+}
+
+SharedMemorySegment::BufferType SharedMemorySegment::getBufferType() const
+{
+    return m_bufferType;
+}
+
+size_t SharedMemorySegment::getSizeOfSingleBuffer() const
+{
+    return m_sizeOfSingleBuffer;
+}
+
+size_t SharedMemorySegment::getSizeOfManagementBuffer() const
+{
+    switch (m_bufferType)
+    {
+    case BufferType::singleBufferSequenceLock:
+        return sizeof(SequenceLockManagementBuffer);
+    case BufferType::doubleBuffer:
+        return sizeof(ManagementBuffer);
+    default:
+        return 0;
+    }
+}
+
+size_t SharedMemorySegment::getSizeOfCurrentBuffer() const
+{
+    if (m_bufferType == BufferType::doubleBuffer && m_sizeOfSingleBuffer == 0)
+    {
+        return 0;
+    }
+
+    // the range has to fit into the segment, regardless of which half of a double buffer is active
+    const size_t maxStartAddress = getSizeOfManagementBuffer() + (m_bufferType == BufferType::doubleBuffer ? m_sizeOfSingleBuffer : 0);
+    return (m_size > maxStartAddress) ? m_size - maxStartAddress : 0;
+}
+
+size_t SharedMemorySegment::getCurrentBufferStartAddress() const
+{
+    size_t startAddress = getSizeOfManagementBuffer();
+
+    if (m_bufferType == BufferType::doubleBuffer)
+    {
+        const ManagementBuffer *pManagmentBuffer = (ManagementBuffer *)m_buffer;
+        if (pManagmentBuffer->activeReadBuffer == ActiveBuffer::buffer2)
+        {
+            startAddress += m_sizeOfSingleBuffer;
+        }
+    }
+    return startAddress;
+}
+
+void SharedMemorySegment::setReadTimeout(std::chrono::microseconds timeout)
+{
+    m_readTimeoutUs = timeout.count();
+}
+
+std::chrono::microseconds SharedMemorySegment::getReadTimeout() const
+{
+    return std::chrono::microseconds(m_readTimeoutUs.load());
+}
+
+void SharedMemorySegment::setLockTimeout(std::chrono::microseconds timeout)
+{
+    m_lockTimeoutUs = timeout.count();
+}
+
+std::chrono::microseconds SharedMemorySegment::getLockTimeout() const
+{
+    return std::chrono::microseconds(m_lockTimeoutUs.load());
+}
+
+SharedMemorySegment::LockStatistics SharedMemorySegment::getLockStatistics() const
+{
+    LockStatistics statistics;
+    statistics.locks = m_lockCounters.locks.load(std::memory_order_relaxed);
+    statistics.contendedLocks = m_lockCounters.contendedLocks.load(std::memory_order_relaxed);
+    statistics.timeouts = m_lockCounters.timeouts.load(std::memory_order_relaxed);
+    statistics.failures = m_lockCounters.failures.load(std::memory_order_relaxed);
+    statistics.totalWaitUs = m_lockCounters.totalWaitUs.load(std::memory_order_relaxed);
+    statistics.maxWaitUs = m_lockCounters.maxWaitUs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < numberOfLockWaitBuckets; i++)
+    {
+        statistics.waitHistogram[i] = m_lockCounters.waitHistogram[i].load(std::memory_order_relaxed);
+    }
+    return statistics;
+}
+
+SharedMemorySegment::ReadStatistics SharedMemorySegment::getReadStatistics() const
+{
+    ReadStatistics statistics;
+    statistics.reads = m_readCounters.reads.load(std::memory_order_relaxed);
+    statistics.bytes = m_readCounters.bytes.load(std::memory_order_relaxed);
+    statistics.retries = m_readCounters.retries.load(std::memory_order_relaxed);
+    statistics.timeouts = m_readCounters.timeouts.load(std::memory_order_relaxed);
+    statistics.failures = m_readCounters.failures.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+SharedMemorySegment::Statistics SharedMemorySegment::getStatistics() const
+{
+    Statistics statistics;
+    statistics.reads = getReadStatistics();
+    statistics.writes.writes = m_writeCounters.writes.load(std::memory_order_relaxed);
+    statistics.writes.bytes = m_writeCounters.bytes.load(std::memory_order_relaxed);
+    statistics.writes.failures = m_writeCounters.failures.load(std::memory_order_relaxed);
+    statistics.locks = getLockStatistics();
+    statistics.readLatency = m_readLatency.getSnapshot();
+    statistics.writeLatency = m_writeLatency.getSnapshot();
+    return statistics;
+}
+
+void SharedMemorySegment::resetStatistics()
+{
+    for (auto *pCounter : {&m_readCounters.reads, &m_readCounters.bytes, &m_readCounters.retries, &m_readCounters.timeouts, &m_readCounters.failures,
+                           &m_writeCounters.writes, &m_writeCounters.bytes, &m_writeCounters.failures,
+                           &m_lockCounters.locks, &m_lockCounters.contendedLocks, &m_lockCounters.timeouts, &m_lockCounters.failures,
+                           &m_lockCounters.totalWaitUs, &m_lockCounters.maxWaitUs})
+    {
+        pCounter->store(0, std::memory_order_relaxed);
+    }
+    for (auto &bucket : m_lockCounters.waitHistogram)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_readLatency.reset();
+    m_writeLatency.reset();
+}
+
+bool SharedMemorySegment::lockSemaphore() const
+{
+    // a free semaphore is taken without reading the clock
+    if (m_semaphoreLock.tryLock())
+    {
+        countLock(true, false, 0);
+        return true;
+    }
+    if (m_semaphoreLock.getLastError() != EAGAIN)
+    {
+        countLock(false, false, 0);
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool locked = m_semaphoreLock.lock(getLockTimeout());
+    const int error = errno;
+    const auto waitUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    countLock(locked, error == EAGAIN, static_cast<uint64_t>(waitUs));
+
+    // the caller reports a timeout by errno
+    errno = locked ? 0 : error;
+    return locked;
+}
+
+bool SharedMemorySegment::unlockSemaphore() const
+{
+    if (m_semaphoreLock.unlock())
+    {
+        return true;
+    }
+    m_lockCounters.failures.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void SharedMemorySegment::countLock(bool locked, bool timedOut, uint64_t waitUs) const
+{
+    if (!locked)
+    {
+        (timedOut ? m_lockCounters.timeouts : m_lockCounters.failures).fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_lockCounters.locks.fetch_add(1, std::memory_order_relaxed);
+    if (waitUs > 0)
+    {
+        m_lockCounters.contendedLocks.fetch_add(1, std::memory_order_relaxed);
+        m_lockCounters.totalWaitUs.fetch_add(waitUs, std::memory_order_relaxed);
+
+        uint64_t maxWaitUs = m_lockCounters.maxWaitUs.load(std::memory_order_relaxed);
+        while (waitUs > maxWaitUs && !m_lockCounters.maxWaitUs.compare_exchange_weak(maxWaitUs, waitUs, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    const auto bucket = std::lower_bound(lockWaitBucketBoundsUs.begin(), lockWaitBucketBoundsUs.end(), waitUs) - lockWaitBucketBoundsUs.begin();
+    m_lockCounters.waitHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SharedMemorySegment::countRead(bool read, size_t bytes, std::chrono::steady_clock::time_point start) const
+{
+    m_readLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    if (read)
+    {
+        m_readCounters.reads.fetch_add(1, std::memory_order_relaxed);
+        m_readCounters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_readCounters.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SharedMemorySegment::countWrite(bool written, size_t bytes, std::chrono::steady_clock::time_point start)
+{
+    m_writeLatency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    if (written)
+    {
+        m_writeCounters.writes.fetch_add(1, std::memory_order_relaxed);
+        m_writeCounters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_writeCounters.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::shared_ptr<const SharedMemorySegment::ReadOnlyMapping> SharedMemorySegment::getReadOnlyMapping()
+{
+    if (!m_readOnlyMapping)
+    {
+        m_readOnlyMapping = std::make_shared<const ReadOnlyMapping>(m_name, m_size);
+    }
+    return m_readOnlyMapping;
+}
+
+const unsigned int *SharedMemorySegment::getSequence() const
+{
+    switch (m_bufferType)
+    {
+    case BufferType::doubleBuffer:
+        // same protocol as ck_sequence_read_begin/ck_sequence_read_retry, but bounded by the read timeout
+        return &((ManagementBuffer *)m_buffer)->seqlock.sequence;
+    case BufferType::singleBufferSequenceLock:
+        return &((SequenceLockManagementBuffer *)m_buffer)->sequence;
+    default:
+        return nullptr;
+    }
+}
+
+bool SharedMemorySegment::beginRead(unsigned int &version) const
+{
+    const unsigned int *pSequence = getSequence();
+    if (pSequence == nullptr)
+    {
+        return false;
+    }
+
+    ReadRetry retry(getReadTimeout());
+    do
+    {
+        // an odd sequence number means the producer is writing right now
+        version = ck_pr_load_uint(pSequence);
+        ck_pr_fence_load();
+        if ((version & 1) == 0)
+        {
+            return true;
+        }
+    } while (retry.backoff());
+
+    return false;
+}
+
+bool SharedMemorySegment::validateRead(unsigned int version) const
+{
+    const unsigned int *pSequence = getSequence();
+    if (pSequence == nullptr)
+    {
+        return false;
+    }
+
+    ck_pr_fence_load();
+    return ck_pr_load_uint(pSequence) == version;
+}
+
+bool SharedMemorySegment::copyConsistent(char *destination, size_t offset, size_t length, bool relativeToCurrentBuffer) const
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const unsigned int *pSequence = getSequence();
+    if (pSequence != nullptr)
+    {
+        const bool read = copyWithSequenceLock(pSequence, destination, offset, length, relativeToCurrentBuffer);
+        countRead(read, length, start);
+        return read;
+    }
+
+    if (!lockSemaphore())
+    {
+        #ifdef DEBUG
+        std::cout << "read semaphore lock failed" << std::endl;
+        #endif
+        countRead(false, length, start);
+        return false;
+    }
+
+    // read Value
+    size_t startAddress = relativeToCurrentBuffer ? getCurrentBufferStartAddress() : 0;
+    memcpy(destination, this->m_buffer + startAddress + offset, length);
+
+    const bool unlocked = unlockSemaphore();
+    countRead(unlocked, length, start);
+    return unlocked;
+}
+
+bool SharedMemorySegment::copyWithSequenceLock(const unsigned int *pSequence, char *destination, size_t offset, size_t length, bool relativeToCurrentBuffer) const
+{
+    ReadRetry retry(getReadTimeout());
+    uint64_t retries = 0;
+    do
+    {
+        // an odd sequence number means the producer is writing right now
+        const unsigned int version = ck_pr_load_uint(pSequence);
+        ck_pr_fence_load();
+
+        if ((version & 1) == 0)
+        {
+            // the active read buffer is only valid inside of the sequence lock
+            const size_t startAddress = relativeToCurrentBuffer ? getCurrentBufferStartAddress() : 0;
+            memcpy(destination, this->m_buffer + startAddress + offset, length);
+
+            // the copy is consistent if the sequence number has not changed during the copy
+            if (validateRead(version))
+            {
+                if (retries > 0)
+                {
+                    m_readCounters.retries.fetch_add(retries, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+        retries++;
+    } while (retry.backoff());
+
+    m_readCounters.retries.fetch_add(retries, std::memory_order_relaxed);
+    m_readCounters.timeouts.fetch_add(1, std::memory_order_relaxed);
+
+    #ifdef DEBUG
+    std::cout << "read timeout of the sequence lock reached" << std::endl;
+    #endif
+    return false;
+}
+
+bool SharedMemorySegment::readVersion(unsigned int &version) const
+{
+    const unsigned int *pSequence = getSequence();
+    if (pSequence == nullptr)
+    {
+        return false;
+    }
+    version = ck_pr_load_uint(pSequence);
+    return true;
+}
+
+template <typename Operation>
+bool SharedMemorySegment::writeLocked(size_t bytes, Operation operation)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // the lock timeout bounds the latency of a write, a hanging producer lets it fail instead of blocking
+    if (!lockSemaphore())
+    {
+        #ifdef DEBUG
+        std::cout << "C++: unable to lock semaphore for writing" << std::endl;
+        #endif
+        countWrite(false, bytes, start);
+        return false;
+    }
+
+    operation();
+
+    if (!unlockSemaphore())
+    {
+        #ifdef DEBUG
+        std::cout << "C++: unable to unlock semaphore for writing" << std::endl;
+        #endif
+        countWrite(false, bytes, start);
+        return false;
+    }
+    countWrite(true, bytes, start);
+    return true;
+}
+
+void SharedMemorySegment::apply(const WriteOperation &operation)
+{
+    if (operation.pData == nullptr)
+    {
+        uint8_t currentValue = this->m_buffer[operation.offset];
+        uint8_t newValue = operation.bitValue ? (currentValue | operation.bitMask) : (currentValue & ~operation.bitMask);
+        this->m_buffer[operation.offset] = static_cast<char>(newValue);
+    }
+    else
+    {
+        memcpy(this->m_buffer + operation.offset, operation.pData, operation.length);
+    }
+}
+
+bool SharedMemorySegment::write(size_t offset, const char *data, size_t length)
+{
+    return writeLocked(length, [&]()
+                       { memcpy(this->m_buffer + offset, data, length); });
+}
+
+bool SharedMemorySegment::writeBits(size_t offset, uint8_t bitmask, bool bitValue)
+{
+    const WriteOperation operation = {offset, nullptr, 1, bitmask, bitValue};
+    return writeLocked(operation.length, [&]()
+                       { apply(operation); });
+}
+
+bool SharedMemorySegment::writeMany(const std::vector<WriteOperation> &operations)
+{
+    return writeMany(operations.data(), operations.size());
+}
+
+bool SharedMemorySegment::writeMany(const WriteOperation *pOperations, size_t numberOfOperations)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < numberOfOperations; i++)
+    {
+        bytes += pOperations[i].length;
+    }
+
+    return writeLocked(bytes, [&]()
+                       {
+                           for (size_t i = 0; i < numberOfOperations; i++)
+                           {
+                               apply(pOperations[i]);
+                           } });
+}
+
+void SharedMemorySegment::overwrite(const char *data, size_t length)
+{
+    memcpy(this->m_buffer, data, length);
+}
@@ -0,0 +1,347 @@
+/*!
+ * @file   SharedMemorySegment.hpp
+ *
+ * @brief  This class maps a shared memory segment and implements the read and write protocols of the different buffer types.
+ *         It does not depend on node, so it can be shared with native threads and used outside of the addon.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "SystemVSemaphore.hpp"
+#include "SharedMemoryMappingPool.hpp"
+
+class SharedMemorySegment
+{
+public:
+    enum class BufferType
+    {
+        singleBufferSemaphore,
+        singleBufferSequenceLock,
+        doubleBuffer
+    };
+
+    // a copy of bytes or, without data, an update of the bits of one byte
+    struct WriteOperation
+    {
+        size_t offset;
+        const char *pData;
+        size_t length;
+        uint8_t bitMask;
+        bool bitValue;
+    };
+
+    // upper bounds of the buckets of the wait time histogram of the semaphore, the last bucket has no upper bound
+    static constexpr std::array<uint64_t, 4> lockWaitBucketBoundsUs = {10, 100, 1000, 10000};
+    static const size_t numberOfLockWaitBuckets = lockWaitBucketBoundsUs.size() + 1;
+
+    // counters of the semaphore since the segment was attached
+    struct LockStatistics
+    {
+        uint64_t locks;
+        uint64_t contendedLocks;
+        uint64_t timeouts;
+        uint64_t failures;
+        uint64_t totalWaitUs;
+        uint64_t maxWaitUs;
+        std::array<uint64_t, numberOfLockWaitBuckets> waitHistogram;
+    };
+
+    // counters of the consistent reads since the segment was attached, retries and timeouts only happen in buffers
+    // with a sequence number
+    struct ReadStatistics
+    {
+        uint64_t reads;
+        uint64_t bytes;
+        uint64_t retries;
+        uint64_t timeouts;
+        uint64_t failures;
+    };
+
+    // counters of the writes since the segment was attached
+    struct WriteStatistics
+    {
+        uint64_t writes;
+        uint64_t bytes;
+        uint64_t failures;
+    };
+
+    // all counters and the latencies of the reads and writes including the wait for the semaphore or the producer
+    struct Statistics
+    {
+        ReadStatistics reads;
+        WriteStatistics writes;
+        LockStatistics locks;
+        LatencyHistogram::Snapshot readLatency;
+        LatencyHistogram::Snapshot writeLatency;
+    };
+
+    /**
+     * A read-only mapping of the whole segment, which is unmapped when the last owner releases it
+     */
+    class ReadOnlyMapping
+    {
+    public:
+        ReadOnlyMapping(const std::string &name, size_t size);
+        ReadOnlyMapping(const ReadOnlyMapping &other) = delete;
+        ~ReadOnlyMapping();
+
+        ReadOnlyMapping &operator=(const ReadOnlyMapping &other) = delete;
+
+        const char *getData() const;
+        size_t getSize() const;
+
+    private:
+        char *m_data;
+        size_t m_size;
+    };
+
+    /**
+     * Attach to a shared memory segment
+     *
+     * @param name the name of the POSIX shared memory
+     * @param size the size of the segment including offset and management buffer
+     * @param bufferType the type of the buffer
+     * @param sizeOfSingleBuffer the size of a single buffer, needed to locate the active half of a double buffer
+     * @param semaphoreKey the key string of the System V semaphore that protects the buffer
+     * @param creationType the creation type of the semaphore
+     * @throws std::runtime_error if the segment can't be attached
+     *
+     * The mapping of the shared memory is taken from the SharedMemoryMappingPool and released with the segment.
+     */
+    SharedMemorySegment(const std::string &name,
+                        size_t size,
+                        BufferType bufferType,
+                        size_t sizeOfSingleBuffer,
+                        const std::string &semaphoreKey,
+                        SystemVSemaphoreBaseClass::CreationType creationType);
+    SharedMemorySegment(const SharedMemorySegment &other) = delete;
+
+    SharedMemorySegment &operator=(const SharedMemorySegment &other) = delete;
+
+    const std::string &getName() const;
+    size_t getSize() const;
+    BufferType getBufferType() const;
+    size_t getSizeOfSingleBuffer() const;
+    size_t getSizeOfManagementBuffer() const;
+
+    /**
+     * Get the number of bytes of the current buffer that are inside of the segment for every active half
+     *
+     * @return the usable size of the current buffer, 0 if the size of a single buffer is unknown for a double buffer
+     */
+    size_t getSizeOfCurrentBuffer() const;
+
+    /**
+     * Set the deadline for a consistent read of a buffer with a sequence number. A reader that collides with the
+     * producer spins shortly, then yields and finally sleeps with an increasing backoff until the deadline is reached.
+     *
+     * @param timeout the deadline, 0 tries exactly once
+     */
+    void setReadTimeout(std::chrono::microseconds timeout);
+    std::chrono::microseconds getReadTimeout() const;
+
+    /**
+     * Set the deadline to lock the semaphore for a write or for a read of a singleBufferSemaphore. A lock that is
+     * not free is waited for with semtimedop, after the deadline the operation fails with errno EAGAIN.
+     *
+     * @param timeout the deadline, 0 only takes a free semaphore
+     */
+    void setLockTimeout(std::chrono::microseconds timeout);
+    std::chrono::microseconds getLockTimeout() const;
+
+    /**
+     * Get the counters of the semaphore: the locks, how many of them had to wait and for how long, the timeouts
+     * and the failures
+     *
+     * @return a snapshot of the counters
+     */
+    LockStatistics getLockStatistics() const;
+
+    /**
+     * Get the counters of the consistent reads: the successful reads and their bytes, how often a read of a buffer
+     * with a sequence number collided with the producer and had to be retried, how many reads reached the read
+     * timeout and how many reads failed at all
+     *
+     * @return a snapshot of the counters
+     */
+    ReadStatistics getReadStatistics() const;
+
+    /**
+     * Get all counters and the latency histograms of the reads and writes. Counting only uses relaxed atomics, so
+     * the counters of operations running meanwhile may be incomplete.
+     *
+     * @return a snapshot of the counters and histograms
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * Reset all counters and histograms to 0
+     */
+    void resetStatistics();
+
+    /**
+     * Get the read-only mapping of the segment. It is created on first use and shared by all callers.
+     *
+     * @return the mapping
+     * @throws std::runtime_error if the segment can't be mapped
+     */
+    std::shared_ptr<const ReadOnlyMapping> getReadOnlyMapping();
+
+    /**
+     * Wait until the producer is not writing and return the sequence number for a later validateRead()
+     *
+     * @param version the sequence number at the begin of the read
+     * @return false if the buffer type has no sequence number or the read timeout has been reached
+     */
+    bool beginRead(unsigned int &version) const;
+
+    /**
+     * Check that the producer has not written since beginRead()
+     *
+     * @param version the sequence number returned by beginRead()
+     * @return true if everything read since beginRead() is consistent
+     */
+    bool validateRead(unsigned int version) const;
+
+    /**
+     * Get the offset of the current buffer relative to the segment. For a double buffer it is only valid between
+     * beginRead() and a successful validateRead().
+     *
+     * @return the offset of the current buffer
+     */
+    size_t getCurrentBufferStartAddress() const;
+
+    /**
+     * Copy a range out of the segment, consistent with the protocol of the buffer type
+     *
+     * @param destination the destination of the copy
+     * @param offset the offset of the range
+     * @param length the length of the range
+     * @param relativeToCurrentBuffer true if the offset is relative to the current buffer, false if it is relative to the segment
+     * @return true if a consistent copy could be made, false if the semaphore could not be locked or the read timeout of
+     *         a buffer with a sequence number has been reached
+     */
+    bool copyConsistent(char *destination, size_t offset, size_t length, bool relativeToCurrentBuffer) const;
+
+    /**
+     * Read the sequence number of the buffer, which increments on every write of the producer
+     *
+     * @param version the sequence number
+     * @return false if the buffer type has no sequence number
+     */
+    bool readVersion(unsigned int &version) const;
+
+    /**
+     * Copy data into the segment while holding the semaphore
+     *
+     * @param offset the offset relative to the segment
+     * @param data the data to copy
+     * @param length the length of the data
+     * @return true if the data could be written, errno is EAGAIN if the semaphore could not be locked until the lock timeout
+     */
+    bool write(size_t offset, const char *data, size_t length);
+
+    /**
+     * Set or clear the bits of a byte while holding the semaphore
+     *
+     * @param offset the offset relative to the segment
+     * @param bitmask the bits to change
+     * @param bitValue true to set the bits, false to clear them
+     * @return true if the byte could be written
+     */
+    bool writeBits(size_t offset, uint8_t bitmask, bool bitValue);
+
+    /**
+     * Apply many write operations while holding the semaphore once, so readers that use the semaphore see all
+     * or none of them. The operations must have been validated against the size of the segment.
+     *
+     * @param operations the write operations with offsets relative to the segment
+     * @return true if the operations could be applied
+     */
+    bool writeMany(const std::vector<WriteOperation> &operations);
+    bool writeMany(const WriteOperation *pOperations, size_t numberOfOperations);
+
+    /**
+     * Copy data to the beginning of the segment without any protocol
+     *
+     * @param data the data to copy
+     * @param length the length of the data
+     */
+    void overwrite(const char *data, size_t length);
+
+private:
+    const unsigned int *getSequence() const;
+    bool copyWithSequenceLock(const unsigned int *pSequence, char *destination, size_t offset, size_t length, bool relativeToCurrentBuffer) const;
+    void apply(const WriteOperation &operation);
+    bool lockSemaphore() const;
+    bool unlockSemaphore() const;
+    void countLock(bool locked, bool timedOut, uint64_t waitUs) const;
+    void countRead(bool read, size_t bytes, std::chrono::steady_clock::time_point start) const;
+    void countWrite(bool written, size_t bytes, std::chrono::steady_clock::time_point start);
+
+    template <typename Operation>
+    bool writeLocked(size_t bytes, Operation operation);
+
+    std::string m_name;
+    size_t m_size;
+    BufferType m_bufferType;
+    size_t m_sizeOfSingleBuffer;
+    // the mapping is shared with all segments of the same shared memory
+    std::shared_ptr<SharedMemoryMappingPool::Mapping> m_mapping;
+    char *m_buffer;
+
+    // read by the watcher thread as well
+    std::atomic<int64_t> m_readTimeoutUs;
+
+    std::shared_ptr<const ReadOnlyMapping> m_readOnlyMapping;
+
+    // read by the watcher thread as well
+    std::atomic<int64_t> m_lockTimeoutUs;
+
+    // counted by all threads that use the segment, only relaxed because they are only statistics
+    struct LockCounters
+    {
+        std::atomic<uint64_t> locks{0};
+        std::atomic<uint64_t> contendedLocks{0};
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> totalWaitUs{0};
+        std::atomic<uint64_t> maxWaitUs{0};
+        std::array<std::atomic<uint64_t>, numberOfLockWaitBuckets> waitHistogram{};
+    };
+    mutable LockCounters m_lockCounters;
+
+    // counted by all threads that read or write the segment, only relaxed because they are only statistics
+    struct ReadCounters
+    {
+        std::atomic<uint64_t> reads{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> retries{0};
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> failures{0};
+    };
+    mutable ReadCounters m_readCounters;
+    mutable LatencyHistogram m_readLatency;
+
+    struct WriteCounters
+    {
+        std::atomic<uint64_t> writes{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> failures{0};
+    };
+    WriteCounters m_writeCounters;
+    LatencyHistogram m_writeLatency;
+
+    SystemVSemaphore m_semaphoreLock;
+};
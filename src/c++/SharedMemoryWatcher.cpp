@@ -0,0 +1,322 @@
+/*!
+ * @file   SharedMemoryWatcher.cpp
+ *
+ * @brief  This class runs a thread per shared memory segment, which detects changes of subscribed process values
+ *         and delivers only the changed values to JS.
+ *
+ */
+
+#include "SharedMemoryWatcher.hpp"
+#include "SharedMemory.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // the shortest period between two checks
+    const std::chrono::milliseconds minimalPeriod(1);
+
+    // the period without subscriptions
+    const std::chrono::seconds noSubscriptionPeriod(1);
+}
+
+SharedMemoryWatcher::SharedMemoryWatcher(std::shared_ptr<SharedMemorySegment> segment)
+    : m_segment(std::move(segment)),
+      m_running(true),
+      m_subscribed(false),
+      m_nextId(1)
+{
+    m_thread = std::thread(&SharedMemoryWatcher::run, this);
+}
+
+SharedMemoryWatcher::~SharedMemoryWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+
+    for (auto &subscription : m_subscriptions)
+    {
+        release(*subscription);
+    }
+}
+
+uint32_t SharedMemoryWatcher::subscribe(std::vector<ProcessValueDecoder::Descriptor> descriptors, std::chrono::milliseconds minInterval, Napi::ThreadSafeFunction callback)
+{
+    return subscribe(std::move(descriptors), minInterval, callback, nullptr);
+}
+
+uint32_t SharedMemoryWatcher::subscribe(std::vector<ProcessValueDecoder::Descriptor> descriptors, std::chrono::milliseconds minInterval, Napi::ThreadSafeFunction callback,
+                                        std::shared_ptr<SampleRing> ring)
+{
+    auto subscription = std::make_shared<Subscription>();
+    subscription->descriptors = std::move(descriptors);
+    subscription->minInterval = minInterval;
+    subscription->callback = callback;
+    subscription->ring = std::move(ring);
+    if (subscription->ring)
+    {
+        subscription->record.resize(subscription->ring->getRecordSize());
+    }
+    subscription->released = false;
+    subscription->initialized = false;
+    subscription->lastVersion = 0;
+
+    // the snapshot covers all values and their metadata
+    subscription->snapshot.resize(ProcessValueDecoder::getSnapshotRange(subscription->descriptors, subscription->snapshotStart));
+    subscription->lastValues.resize(subscription->descriptors.size());
+    subscription->currentValues.resize(subscription->descriptors.size());
+
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = m_nextId++;
+        subscription->id = id;
+        m_subscriptions.push_back(std::move(subscription));
+        m_subscribed = true;
+    }
+
+    // deliver the initial values without waiting for the next sample
+    m_condition.notify_all();
+    return id;
+}
+
+bool SharedMemoryWatcher::unsubscribe(uint32_t id)
+{
+    std::shared_ptr<Subscription> subscription;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(), [id](const std::shared_ptr<Subscription> &candidate)
+                               { return candidate->id == id; });
+        if (it == m_subscriptions.end())
+        {
+            return false;
+        }
+        subscription = *it;
+        m_subscriptions.erase(it);
+    }
+
+    // a running check may still hold the subscription, it doesn't deliver anymore after the release
+    release(*subscription);
+    return true;
+}
+
+void SharedMemoryWatcher::release(Subscription &subscription)
+{
+    std::lock_guard<std::mutex> lock(subscription.deliveryMutex);
+    if (!subscription.released)
+    {
+        subscription.released = true;
+        subscription.callback.Release();
+    }
+}
+
+size_t SharedMemoryWatcher::getChangeRecordSize(const std::vector<ProcessValueDecoder::Descriptor> &descriptors)
+{
+    size_t sizeOfValues = 0;
+    for (const auto &descriptor : descriptors)
+    {
+        sizeOfValues = std::max(sizeOfValues, ProcessValueDecoder::getSizeOfValue(descriptor));
+    }
+    // records of a multiple of 8 bytes keep 64 bit values aligned
+    return changeRecordHeaderSize + (sizeOfValues + 7) / 8 * 8;
+}
+
+size_t SharedMemoryWatcher::getNumberOfSubscriptions() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_subscriptions.size();
+}
+
+void SharedMemoryWatcher::run()
+{
+    std::vector<std::shared_ptr<Subscription>> subscriptions;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_running)
+    {
+        // the snapshots are taken without the lock, copying a segment protected by a semaphore can block until the lock timeout
+        subscriptions = m_subscriptions;
+        m_subscribed = false;
+        lock.unlock();
+
+        const auto wakeUp = checkSubscriptions(subscriptions);
+        subscriptions.clear();
+
+        lock.lock();
+        m_condition.wait_until(lock, wakeUp, [this]()
+                               { return !m_running || m_subscribed; });
+    }
+}
+
+std::chrono::steady_clock::time_point SharedMemoryWatcher::checkSubscriptions(const std::vector<std::shared_ptr<Subscription>> &subscriptions)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (subscriptions.empty())
+    {
+        return now + noSubscriptionPeriod;
+    }
+
+    // buffers without a sequence number have to be compared on every check
+    unsigned int version = 0;
+    const bool hasVersion = m_segment->readVersion(version);
+
+    auto wakeUp = now + noSubscriptionPeriod;
+    auto minInterval = std::chrono::milliseconds(noSubscriptionPeriod);
+    for (const auto &subscription : subscriptions)
+    {
+        const bool changed = !hasVersion || !subscription->initialized || (version != subscription->lastVersion);
+        const bool due = !subscription->initialized || (now >= subscription->lastCheck + subscription->minInterval);
+
+        if (changed && due)
+        {
+            check(*subscription, hasVersion, version);
+            subscription->lastCheck = now;
+        }
+
+        const auto interval = std::max(subscription->minInterval, minimalPeriod);
+        minInterval = std::min(minInterval, interval);
+        if (!hasVersion || changed)
+        {
+            // compared with the minimal interval, a pending change is checked as soon as it is due
+            wakeUp = std::min(wakeUp, subscription->lastCheck + interval);
+        }
+    }
+
+    if (hasVersion)
+    {
+        // the sequence number is sampled with the shortest minimal interval, so no subscription sees a change late
+        wakeUp = std::min(wakeUp, now + minInterval);
+    }
+    return wakeUp;
+}
+
+void SharedMemoryWatcher::check(Subscription &subscription, bool hasVersion, unsigned int version)
+{
+    if (!m_segment->copyConsistent(subscription.snapshot.data(), subscription.snapshotStart, subscription.snapshot.size(), true))
+    {
+        // try again with the next sample
+        return;
+    }
+
+    if (subscription.ring)
+    {
+        push(subscription);
+        subscription.lastVersion = hasVersion ? version : 0;
+        return;
+    }
+
+    subscription.changedIndices.clear();
+    for (size_t i = 0; i < subscription.descriptors.size(); i++)
+    {
+        ProcessValueDecoder::decode(subscription.snapshot.data(), subscription.snapshotStart, subscription.descriptors[i], subscription.currentValues[i]);
+        if (!subscription.initialized || !ProcessValueDecoder::isSameValue(subscription.currentValues[i], subscription.lastValues[i]))
+        {
+            subscription.changedIndices.push_back(i);
+        }
+    }
+
+    // undelivered changes stay changed, they are delivered again with the next check
+    if (subscription.changedIndices.empty() || deliverChanges(subscription))
+    {
+        for (size_t i : subscription.changedIndices)
+        {
+            std::swap(subscription.lastValues[i], subscription.currentValues[i]);
+        }
+        subscription.initialized = true;
+        subscription.lastVersion = hasVersion ? version : 0;
+    }
+}
+
+bool SharedMemoryWatcher::deliverChanges(Subscription &subscription)
+{
+    std::unique_ptr<std::vector<Change>> pChanges(new std::vector<Change>());
+    pChanges->reserve(subscription.changedIndices.size());
+    for (size_t i : subscription.changedIndices)
+    {
+        pChanges->push_back(Change{static_cast<uint32_t>(i), subscription.currentValues[i]});
+    }
+
+    std::lock_guard<std::mutex> lock(subscription.deliveryMutex);
+    if (subscription.released || subscription.callback.NonBlockingCall(pChanges.get(), &SharedMemoryWatcher::deliver) != napi_ok)
+    {
+        return false;
+    }
+    // the changes are deleted after the delivery
+    pChanges.release();
+    return true;
+}
+
+void SharedMemoryWatcher::push(Subscription &subscription)
+{
+    SampleRing &ring = *subscription.ring;
+    char *pRecord = subscription.record.data();
+    bool pushed = false;
+    bool complete = true;
+
+    ProcessValueDecoder::DecodedValue value;
+    for (size_t i = 0; i < subscription.descriptors.size(); i++)
+    {
+        const ProcessValueDecoder::Descriptor &descriptor = subscription.descriptors[i];
+        ProcessValueDecoder::decode(subscription.snapshot.data(), subscription.snapshotStart, descriptor, value);
+        if (subscription.initialized && ProcessValueDecoder::isSameValue(value, subscription.lastValues[i]))
+        {
+            continue;
+        }
+        subscription.lastValues[i] = value;
+
+        const uint32_t index = static_cast<uint32_t>(i) | (value.hasErrorCode ? changeRecordHasErrorCode : 0);
+        const uint32_t errorCode = value.errorCode;
+        memcpy(pRecord, &index, sizeof(index));
+        memcpy(pRecord + sizeof(index), &errorCode, sizeof(errorCode));
+        memcpy(pRecord + changeRecordHeaderSize, subscription.snapshot.data() + (descriptor.offset - subscription.snapshotStart), ProcessValueDecoder::getSizeOfValue(descriptor));
+        if (!ring.tryPush(pRecord))
+        {
+            complete = false;
+            break;
+        }
+        pushed = true;
+    }
+
+    // JS missed changes of a full ring buffer, all values are pushed again with the next check
+    subscription.initialized = complete;
+
+    // a single wakeup for all records that are pushed until JS drains the ring buffer
+    if (pushed && ring.requestWakeup())
+    {
+        std::lock_guard<std::mutex> lock(subscription.deliveryMutex);
+        if (subscription.released || subscription.callback.NonBlockingCall() != napi_ok)
+        {
+            ring.cancelWakeup();
+        }
+    }
+}
+
+void SharedMemoryWatcher::deliver(Napi::Env env, Napi::Function callback, std::vector<Change> *pChanges)
+{
+    std::unique_ptr<std::vector<Change>> changes(pChanges);
+
+    // the environment is gone if the callback is released while changes are pending
+    if (env == nullptr || callback == nullptr)
+    {
+        return;
+    }
+
+    Napi::Array result = Napi::Array::New(env, changes->size());
+    for (size_t i = 0; i < changes->size(); i++)
+    {
+        const Change &change = (*changes)[i];
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("index", Napi::Number::New(env, change.index));
+        entry.Set("value", SharedMemory::toNapiValue(env, change.value));
+        entry.Set("errorCode", Napi::Number::New(env, change.value.errorCode));
+        entry.Set("hasErrorCode", Napi::Boolean::New(env, change.value.hasErrorCode));
+        result.Set(i, entry);
+    }
+    callback.Call({result});
+}
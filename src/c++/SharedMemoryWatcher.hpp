@@ -0,0 +1,132 @@
+/*!
+ * @file   SharedMemoryWatcher.hpp
+ *
+ * @brief  This class runs a thread per shared memory segment, which detects changes of subscribed process values
+ *         and delivers only the changed values to JS.
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <napi.h>
+
+#include "ProcessValueDecoder.hpp"
+#include "SampleRing.hpp"
+#include "SharedMemorySegment.hpp"
+
+class SharedMemoryWatcher
+{
+public:
+    explicit SharedMemoryWatcher(std::shared_ptr<SharedMemorySegment> segment);
+    SharedMemoryWatcher(const SharedMemoryWatcher &other) = delete;
+    ~SharedMemoryWatcher();
+
+    SharedMemoryWatcher &operator=(const SharedMemoryWatcher &other) = delete;
+
+    /**
+     * Subscribe process values. The initial values are delivered with the next check.
+     *
+     * @param descriptors the descriptions of the process values
+     * @param minInterval the minimal interval between two calls of the callback
+     * @param callback the callback, which is called with the changed values
+     * @return the id of the subscription
+     */
+    uint32_t subscribe(std::vector<ProcessValueDecoder::Descriptor> descriptors, std::chrono::milliseconds minInterval, Napi::ThreadSafeFunction callback);
+
+    /**
+     * Subscribe process values and push the changes into a ring buffer instead of passing them to the callback.
+     * The callback is called without arguments when the ring buffer has to be drained, so a batch of changes needs
+     * one wakeup of JS. A change record contains the index of the value as uint32, with changeRecordHasErrorCode set
+     * if the value has an error code, the error code as uint32 and the raw bytes of the value. If the ring buffer is
+     * full, all values are pushed again with a later check.
+     *
+     * @param descriptors the descriptions of the process values
+     * @param minInterval the minimal interval between two checks
+     * @param callback the callback, which is called to drain the ring buffer
+     * @param ring the ring buffer with records of getChangeRecordSize bytes
+     * @return the id of the subscription
+     */
+    uint32_t subscribe(std::vector<ProcessValueDecoder::Descriptor> descriptors, std::chrono::milliseconds minInterval, Napi::ThreadSafeFunction callback,
+                       std::shared_ptr<SampleRing> ring);
+
+    /**
+     * Get the size of a change record in a ring buffer, the raw value is at offset changeRecordHeaderSize
+     *
+     * @param descriptors the descriptions of the process values
+     * @return the size that fits the largest value, a multiple of 8
+     */
+    static size_t getChangeRecordSize(const std::vector<ProcessValueDecoder::Descriptor> &descriptors);
+
+    static const size_t changeRecordHeaderSize = 8;
+    static const uint32_t changeRecordHasErrorCode = 0x80000000;
+
+    /**
+     * Remove a subscription and release its callback
+     *
+     * @param id the id of the subscription
+     * @return true if the subscription existed
+     */
+    bool unsubscribe(uint32_t id);
+
+    size_t getNumberOfSubscriptions() const;
+
+private:
+    struct Change
+    {
+        uint32_t index;
+        ProcessValueDecoder::DecodedValue value;
+    };
+
+    struct Subscription
+    {
+        uint32_t id;
+        std::vector<ProcessValueDecoder::Descriptor> descriptors;
+        std::chrono::milliseconds minInterval;
+        Napi::ThreadSafeFunction callback;
+        // the changes are passed to the callback without a ring buffer
+        std::shared_ptr<SampleRing> ring;
+        std::vector<char> record;
+
+        // locked to deliver changes, so unsubscribe never releases the callback during a call
+        std::mutex deliveryMutex;
+        bool released;
+
+        // only used by the thread of the watcher, the snapshot is taken without holding a lock
+        size_t snapshotStart;
+        std::vector<char> snapshot;
+        std::vector<ProcessValueDecoder::DecodedValue> lastValues;
+        std::vector<ProcessValueDecoder::DecodedValue> currentValues;
+        std::vector<size_t> changedIndices;
+        bool initialized;
+        unsigned int lastVersion;
+        std::chrono::steady_clock::time_point lastCheck;
+    };
+
+    void run();
+    std::chrono::steady_clock::time_point checkSubscriptions(const std::vector<std::shared_ptr<Subscription>> &subscriptions);
+    void check(Subscription &subscription, bool hasVersion, unsigned int version);
+    bool deliverChanges(Subscription &subscription);
+    void push(Subscription &subscription);
+    static void release(Subscription &subscription);
+    static void deliver(Napi::Env env, Napi::Function callback, std::vector<Change> *pChanges);
+
+    std::shared_ptr<SharedMemorySegment> m_segment;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_running;
+    // set by subscribe, so a new subscription is checked without waiting for the next sample
+    bool m_subscribed;
+    std::thread m_thread;
+
+    // the thread of the watcher checks a copy of the list, so subscribe and unsubscribe never wait for a check
+    std::vector<std::shared_ptr<Subscription>> m_subscriptions;
+    uint32_t m_nextId;
+};
@@ -0,0 +1,51 @@
+#include "SharedMemoryWriteWorker.hpp"
+#include "SharedMemory.hpp"
+
+#include <cerrno>
+
+SharedMemoryWriteWorker::SharedMemoryWriteWorker(Napi::Env env, std::shared_ptr<SharedMemorySegment> segment, size_t numberOfEntries, size_t maxSizeOfValue)
+    : Napi::AsyncWorker(env, "SharedMemoryWriteWorker"),
+      m_segment(std::move(segment)),
+      m_operations(numberOfEntries),
+      // sized once, the operations point into the encoded values
+      m_encodedValues(numberOfEntries * maxSizeOfValue),
+      m_maxSizeOfValue(maxSizeOfValue),
+      m_deferred(Napi::Promise::Deferred::New(env)),
+      m_errno(0)
+{
+}
+
+char *SharedMemoryWriteWorker::getEncodedValue(size_t index)
+{
+    return m_encodedValues.data() + index * m_maxSizeOfValue;
+}
+
+SharedMemorySegment::WriteOperation &SharedMemoryWriteWorker::getOperation(size_t index)
+{
+    return m_operations[index];
+}
+
+Napi::Promise SharedMemoryWriteWorker::getPromise() const
+{
+    return m_deferred.Promise();
+}
+
+void SharedMemoryWriteWorker::Execute()
+{
+    if (!m_operations.empty() && !m_segment->writeMany(m_operations))
+    {
+        // the error is created on the main thread, errno of this thread is gone by then
+        m_errno = errno;
+        SetError("Unable to write values");
+    }
+}
+
+void SharedMemoryWriteWorker::OnOK()
+{
+    m_deferred.Resolve(Env().Undefined());
+}
+
+void SharedMemoryWriteWorker::OnError(const Napi::Error &)
+{
+    m_deferred.Reject(SharedMemory::createLockError(Env(), "Unable to write values", m_errno).Value());
+}
@@ -0,0 +1,65 @@
+/*!
+ * @file   SharedMemoryWriteWorker.hpp
+ *
+ * @brief  This class writes many encoded values while holding the semaphore once on a thread of the libuv thread pool
+ *         and resolves a promise when the values are written.
+ *
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <napi.h>
+
+#include "SharedMemorySegment.hpp"
+
+class SharedMemoryWriteWorker : public Napi::AsyncWorker
+{
+public:
+    /**
+     * Create a worker for a number of entries, the worker deletes itself after the promise is settled
+     *
+     * @param env the environment
+     * @param segment the segment to write, kept alive until the worker is done
+     * @param numberOfEntries the number of entries to write
+     * @param maxSizeOfValue the maximal size of an encoded value
+     */
+    SharedMemoryWriteWorker(Napi::Env env, std::shared_ptr<SharedMemorySegment> segment, size_t numberOfEntries, size_t maxSizeOfValue);
+
+    /**
+     * Get the buffer for the encoded value of an entry, the operation of the entry may point into it
+     *
+     * @param index the index of the entry
+     * @return the buffer of maxSizeOfValue bytes
+     */
+    char *getEncodedValue(size_t index);
+
+    /**
+     * Get the operation of an entry, which is filled in before the worker is queued
+     *
+     * @param index the index of the entry
+     * @return the operation
+     */
+    SharedMemorySegment::WriteOperation &getOperation(size_t index);
+
+    /**
+     * Get the promise, which resolves when all values are written
+     *
+     * @return the promise
+     */
+    Napi::Promise getPromise() const;
+
+protected:
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error &error) override;
+
+private:
+    std::shared_ptr<SharedMemorySegment> m_segment;
+    std::vector<SharedMemorySegment::WriteOperation> m_operations;
+    std::vector<char> m_encodedValues;
+    size_t m_maxSizeOfValue;
+    Napi::Promise::Deferred m_deferred;
+    int m_errno;
+};
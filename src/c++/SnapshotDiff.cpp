@@ -0,0 +1,237 @@
+/*!
+ * @file   SnapshotDiff.cpp
+ *
+ * @brief  This class compares two snapshots of a shared memory buffer and finds the changed byte ranges with SIMD
+ *         instructions (AVX2 or SSE2 on x86, NEON on ARM, a scalar fallback otherwise).
+ *
+ */
+
+#include "SnapshotDiff.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SNAPSHOT_DIFF_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SNAPSHOT_DIFF_NEON
+#endif
+
+namespace
+{
+    /**
+     * Collects the changed bytes into ranges. Blocks without a change are skipped as a whole, only the bytes of a
+     * block with a change are compared one by one.
+     */
+    class RangeBuilder
+    {
+    public:
+        explicit RangeBuilder(std::vector<SnapshotDiff::Range> &ranges)
+            : m_ranges(ranges),
+              m_open(false),
+              m_start(0)
+        {
+            m_ranges.clear();
+        }
+
+        void addBytes(const uint8_t *pPrevious, const uint8_t *pCurrent, size_t from, size_t to)
+        {
+            for (size_t i = from; i < to; i++)
+            {
+                if (pPrevious[i] != pCurrent[i])
+                {
+                    open(i);
+                }
+                else
+                {
+                    close(i);
+                }
+            }
+        }
+
+        void close(size_t end)
+        {
+            if (m_open)
+            {
+                m_ranges.push_back({m_start, end - m_start});
+                m_open = false;
+            }
+        }
+
+    private:
+        void open(size_t start)
+        {
+            if (!m_open)
+            {
+                m_start = start;
+                m_open = true;
+            }
+        }
+
+        std::vector<SnapshotDiff::Range> &m_ranges;
+        bool m_open;
+        size_t m_start;
+    };
+
+    using FindChangedRanges = void (*)(const uint8_t *, const uint8_t *, size_t, std::vector<SnapshotDiff::Range> &);
+
+    void findChangedRangesScalar(const uint8_t *pPrevious, const uint8_t *pCurrent, size_t length, std::vector<SnapshotDiff::Range> &ranges)
+    {
+        const size_t blockSize = sizeof(uint64_t);
+        RangeBuilder builder(ranges);
+
+        size_t i = 0;
+        for (; i + blockSize <= length; i += blockSize)
+        {
+            uint64_t previous;
+            uint64_t current;
+            memcpy(&previous, pPrevious + i, blockSize);
+            memcpy(&current, pCurrent + i, blockSize);
+            if (previous == current)
+            {
+                builder.close(i);
+            }
+            else
+            {
+                builder.addBytes(pPrevious, pCurrent, i, i + blockSize);
+            }
+        }
+        builder.addBytes(pPrevious, pCurrent, i, length);
+        builder.close(length);
+    }
+
+#ifdef SNAPSHOT_DIFF_X86
+    // SSE2 is part of every x86-64 CPU
+    __attribute__((target("sse2"))) void findChangedRangesSse2(const uint8_t *pPrevious, const uint8_t *pCurrent, size_t length, std::vector<SnapshotDiff::Range> &ranges)
+    {
+        const size_t blockSize = sizeof(__m128i);
+        RangeBuilder builder(ranges);
+
+        size_t i = 0;
+        for (; i + blockSize <= length; i += blockSize)
+        {
+            const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pPrevious + i));
+            const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pCurrent + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(previous, current)) == 0xFFFF)
+            {
+                builder.close(i);
+            }
+            else
+            {
+                builder.addBytes(pPrevious, pCurrent, i, i + blockSize);
+            }
+        }
+        builder.addBytes(pPrevious, pCurrent, i, length);
+        builder.close(length);
+    }
+
+    // compiled for AVX2 independent of the build flags, it is only called if the CPU supports AVX2
+    __attribute__((target("avx2"))) void findChangedRangesAvx2(const uint8_t *pPrevious, const uint8_t *pCurrent, size_t length, std::vector<SnapshotDiff::Range> &ranges)
+    {
+        const size_t blockSize = sizeof(__m256i);
+        RangeBuilder builder(ranges);
+
+        size_t i = 0;
+        for (; i + blockSize <= length; i += blockSize)
+        {
+            const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pPrevious + i));
+            const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pCurrent + i));
+            if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(previous, current))) == 0xFFFFFFFF)
+            {
+                builder.close(i);
+            }
+            else
+            {
+                builder.addBytes(pPrevious, pCurrent, i, i + blockSize);
+            }
+        }
+        builder.addBytes(pPrevious, pCurrent, i, length);
+        builder.close(length);
+    }
+#endif
+
+#ifdef SNAPSHOT_DIFF_NEON
+    void findChangedRangesNeon(const uint8_t *pPrevious, const uint8_t *pCurrent, size_t length, std::vector<SnapshotDiff::Range> &ranges)
+    {
+        const size_t blockSize = sizeof(uint8x16_t);
+        RangeBuilder builder(ranges);
+
+        size_t i = 0;
+        for (; i + blockSize <= length; i += blockSize)
+        {
+            // NEON has no movemask, both 64 bit halves of the comparison are all ones if the block is unchanged
+            const uint64x2_t equal = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(pPrevious + i), vld1q_u8(pCurrent + i)));
+            if ((vgetq_lane_u64(equal, 0) & vgetq_lane_u64(equal, 1)) == UINT64_MAX)
+            {
+                builder.close(i);
+            }
+            else
+            {
+                builder.addBytes(pPrevious, pCurrent, i, i + blockSize);
+            }
+        }
+        builder.addBytes(pPrevious, pCurrent, i, length);
+        builder.close(length);
+    }
+#endif
+
+    struct Implementation
+    {
+        FindChangedRanges findChangedRanges;
+        const char *name;
+    };
+
+    // selected once by the features of the CPU
+    const Implementation &getImplementation()
+    {
+        static const Implementation implementation = []() -> Implementation
+        {
+#if defined(SNAPSHOT_DIFF_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return {&findChangedRangesAvx2, "avx2"};
+            }
+            if (__builtin_cpu_supports("sse2"))
+            {
+                return {&findChangedRangesSse2, "sse2"};
+            }
+#elif defined(SNAPSHOT_DIFF_NEON)
+            return {&findChangedRangesNeon, "neon"};
+#endif
+            return {&findChangedRangesScalar, "scalar"};
+        }();
+        return implementation;
+    }
+}
+
+void SnapshotDiff::findChangedRanges(const char *pPrevious, const char *pCurrent, size_t length, std::vector<Range> &ranges)
+{
+    getImplementation().findChangedRanges(reinterpret_cast<const uint8_t *>(pPrevious), reinterpret_cast<const uint8_t *>(pCurrent), length, ranges);
+}
+
+bool SnapshotDiff::intersects(const std::vector<Range> &ranges, size_t offset, size_t length)
+{
+    if (length == 0)
+    {
+        return false;
+    }
+
+    // the first range that starts behind the checked range can't overlap, only the one before it can
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), offset + length - 1, [](size_t lastByte, const Range &range)
+                               { return lastByte < range.offset; });
+    if (it == ranges.begin())
+    {
+        return false;
+    }
+    --it;
+    return it->offset + it->length > offset;
+}
+
+const char *SnapshotDiff::getImplementationName()
+{
+    return getImplementation().name;
+}
@@ -0,0 +1,49 @@
+/*!
+ * @file   SnapshotDiff.hpp
+ *
+ * @brief  This class compares two snapshots of a shared memory buffer and finds the changed byte ranges with SIMD
+ *         instructions (AVX2 or SSE2 on x86, NEON on ARM, a scalar fallback otherwise).
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class SnapshotDiff
+{
+public:
+    struct Range
+    {
+        size_t offset;
+        size_t length;
+    };
+
+    /**
+     * Find the byte ranges in which two snapshots of the same length differ
+     *
+     * @param pPrevious the previous snapshot
+     * @param pCurrent the current snapshot
+     * @param length the length of both snapshots
+     * @param ranges the changed ranges relative to the start of the snapshots, sorted and not adjacent to each other
+     */
+    static void findChangedRanges(const char *pPrevious, const char *pCurrent, size_t length, std::vector<Range> &ranges);
+
+    /**
+     * Check if a range of bytes overlaps one of the changed ranges
+     *
+     * @param ranges the changed ranges found by findChangedRanges
+     * @param offset the offset of the range to check
+     * @param length the length of the range to check
+     * @return true if at least one byte of the range has changed
+     */
+    static bool intersects(const std::vector<Range> &ranges, size_t offset, size_t length);
+
+    /**
+     * Get the name of the instruction set used by findChangedRanges on this CPU
+     *
+     * @return avx2, sse2, neon or scalar
+     */
+    static const char *getImplementationName();
+};
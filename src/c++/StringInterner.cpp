@@ -0,0 +1,42 @@
+/*!
+ * @file   StringInterner.cpp
+ *
+ * @brief  This class keeps the last JS string of every text value of a shared memory, so reading a value with
+ *         unchanged bytes returns the same JS string instead of allocating a new one. It must only be used on the
+ *         thread of its environment.
+ *
+ */
+
+#include "StringInterner.hpp"
+
+Napi::String StringInterner::get(Napi::Env env, size_t offset, const std::string &text)
+{
+    if (m_strings.IsEmpty())
+    {
+        m_strings = Napi::Persistent(Napi::Array::New(env));
+    }
+
+    // try_emplace doesn't copy the text if the value is already known
+    auto inserted = m_entries.try_emplace(offset);
+    Entry &entry = inserted.first->second;
+    if (inserted.second)
+    {
+        entry.slot = static_cast<uint32_t>(m_entries.size() - 1);
+    }
+    else if (entry.text == text)
+    {
+        return m_strings.Value().Get(entry.slot).As<Napi::String>();
+    }
+
+    // assign reuses the capacity of the previous text
+    entry.text.assign(text);
+    Napi::String string = Napi::String::New(env, text);
+    m_strings.Value().Set(entry.slot, string);
+    return string;
+}
+
+void StringInterner::clear()
+{
+    m_entries.clear();
+    m_strings.Reset();
+}
@@ -0,0 +1,46 @@
+/*!
+ * @file   StringInterner.hpp
+ *
+ * @brief  This class keeps the last JS string of every text value of a shared memory, so reading a value with
+ *         unchanged bytes returns the same JS string instead of allocating a new one. It must only be used on the
+ *         thread of its environment.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <napi.h>
+
+class StringInterner
+{
+public:
+    /**
+     * Get the JS string of a text value, it is only created if the bytes of the value have changed
+     *
+     * @param env the environment
+     * @param offset the offset of the value, which identifies it
+     * @param text the decoded text of the value
+     * @return the JS string
+     */
+    Napi::String get(Napi::Env env, size_t offset, const std::string &text);
+
+    /**
+     * Release all strings, e.g. after the shared memory was closed
+     */
+    void clear();
+
+private:
+    struct Entry
+    {
+        std::string text;
+        uint32_t slot;
+    };
+
+    std::unordered_map<size_t, Entry> m_entries;
+    // references to strings aren't supported by all Node-API versions, so the strings are kept in an array
+    Napi::Reference<Napi::Array> m_strings;
+};
@@ -7,19 +7,54 @@
 
 #include "SystemVSemaphore.hpp"
 
+#include <algorithm>
+
+#include <errno.h>
 #include <sys/ipc.h>
 #include <sys/sem.h>
 
 bool SystemVSemaphore::lock(void) const
 {
-    const SemaphoreOptions semaphoreLock = { 0, -1, 0 };
+    const SemaphoreOptions semaphoreLock = { 0, -1, SEM_UNDO };
 
     return setSemaphoreOptions( semaphoreLock );
 }
 
+bool SystemVSemaphore::lock(std::chrono::microseconds timeout) const
+{
+    const SemaphoreOptions semaphoreLock = { 0, -1, SEM_UNDO };
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true)
+    {
+        // semtimedop takes a relative timeout, after an interrupt only the remaining time is waited
+        const auto remaining = std::max(std::chrono::steady_clock::duration::zero(), deadline - std::chrono::steady_clock::now());
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        const struct timespec relativeTimeout = { static_cast<time_t>(seconds.count()),
+                                                  static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count()) };
+
+        if (setSemaphoreOptions( semaphoreLock, relativeTimeout ))
+        {
+            return true;
+        }
+        if (getLastError() != EINTR)
+        {
+            return false;
+        }
+    }
+}
+
+bool SystemVSemaphore::tryLock(void) const
+{
+    const SemaphoreOptions semaphoreLock = { 0, -1, IPC_NOWAIT | SEM_UNDO };
+    const struct timespec noTimeout = { 0, 0 };
+
+    return setSemaphoreOptions( semaphoreLock, noTimeout );
+}
+
 bool SystemVSemaphore::unlock(void) const
 {
-    const SemaphoreOptions semaphoreUnlock = { 0, 1, 0 };
+    const SemaphoreOptions semaphoreUnlock = { 0, 1, SEM_UNDO };
 
     return setSemaphoreOptions( semaphoreUnlock );
 }
@@ -9,12 +9,34 @@
 
 #include "SystemVSemaphoreBaseClass.hpp"
 
+#include <chrono>
+
+/**
+ * All operations of the lock use SEM_UNDO, so the kernel releases a lock held by this process when it dies.
+ * Lock and unlock always come in pairs, so the undo adjustments of a living process are balanced.
+ */
 class SystemVSemaphore : public SystemVSemaphoreBaseClass
 {
 public:
     using SystemVSemaphoreBaseClass::SystemVSemaphoreBaseClass;
 
     bool lock(void) const;
+
+    /**
+     * Lock the semaphore, but wait at most for the timeout
+     *
+     * @param timeout the maximal time to wait, interrupts don't extend it
+     * @return false if the semaphore could not be locked, getLastError() is EAGAIN after the timeout
+     */
+    bool lock(std::chrono::microseconds timeout) const;
+
+    /**
+     * Lock the semaphore if it is free, without waiting
+     *
+     * @return false if the semaphore could not be locked, getLastError() is EAGAIN if it is held by another process
+     */
+    bool tryLock(void) const;
+
     bool unlock(void) const;
     int getValue(void) const;
 };
@@ -160,16 +160,10 @@ bool SystemVSemaphoreBaseClass::setSemaphoreOptions(const SemaphoreOptions semap
 
     if (isValid())
     {
+        // a failure is left in errno for the caller, the lock, read and write statistics of the segment count it
         if (semop(m_semaphoreId, (struct sembuf *)&semaphoreOptions, 1) == -1)
         {
-            if ((true == acceptTryAgain) && (EAGAIN == errno))
-            {
-                returnValue = true;
-            }
-            else
-            {
-                std::cerr << "Error: " << strerror(errno) << " id: " << m_semaphoreId << " num: " << semaphoreOptions.sem_num << " op: " << semaphoreOptions.sem_op << " value: " << semctl(m_semaphoreId, semaphoreOptions.sem_num, GETVAL, 0) << std::endl;
-            }
+            returnValue = (true == acceptTryAgain) && (EAGAIN == errno);
         }
         else
         {
@@ -178,7 +172,23 @@ bool SystemVSemaphoreBaseClass::setSemaphoreOptions(const SemaphoreOptions semap
     }
     else
     {
-        std::cerr << "Semaphore is not valid" << std::endl;
+        errno = EINVAL;
+    }
+    return returnValue;
+}
+
+bool SystemVSemaphoreBaseClass::setSemaphoreOptions(const SemaphoreOptions semaphoreOptions, const struct timespec &timeout) const
+{
+    bool returnValue = false;
+
+    if (isValid())
+    {
+        // a timeout, an interrupt or a failure is left in errno, the caller decides what to do with it
+        returnValue = semtimedop(m_semaphoreId, (struct sembuf *)&semaphoreOptions, 1, &timeout) != -1;
+    }
+    else
+    {
+        errno = EINVAL;
     }
     return returnValue;
 }
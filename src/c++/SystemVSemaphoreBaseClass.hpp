@@ -11,6 +11,7 @@
 
 #include <string>
 #include <sys/types.h>
+#include <time.h>
 
 class SystemVSemaphoreBaseClass
 {
@@ -54,6 +55,16 @@ protected:
     bool attachToExistingSemaphore(const key_t &key);
     key_t createKeyFromKeyString();
     bool setSemaphoreOptions(const SemaphoreOptions semaphoreOptions, const bool acceptTryAgain = false) const;
+
+    /**
+     * Apply the semaphore options, but wait at most for the timeout (semtimedop)
+     *
+     * @param semaphoreOptions the options to apply
+     * @param timeout the maximal time to wait
+     * @return false if the options could not be applied, errno is EAGAIN after the timeout or with IPC_NOWAIT and
+     *         EINTR after an interrupt, these cases are not logged
+     */
+    bool setSemaphoreOptions(const SemaphoreOptions semaphoreOptions, const struct timespec &timeout) const;
     void deleteSemaphoreSet();
     int getSemaphoreId() const;
 
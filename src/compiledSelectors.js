@@ -0,0 +1,136 @@
+import { groupByMemory, readGroup, resolveValue } from './readProcessValues.js';
+import { checkWriteable, getWriteBufferStartAddress, validateValue, writeTargets } from './writeProcessValues.js';
+
+/**
+ * Opaque handle for a list of selectors that are resolved once and read or written many times.
+ * The URL parsing, the lookup of the process description, the attach to the shared memory and the
+ * creation of the descriptor tables happen in compile(), the read and write functions only access the memory.
+ */
+class CompiledSelectors {
+    #entries;
+    #groups;
+    #isSingleSelector;
+
+    constructor(entries, groups, isSingleSelector) {
+        this.#entries = entries;
+        this.#groups = groups;
+        this.#isSingleSelector = isSingleSelector;
+    }
+
+    get selectors() {
+        return this.#entries.map(entry => entry.selector);
+    }
+
+    read() {
+        const results = new Array(this.#entries.length);
+        for (const group of this.#groups) {
+            readGroup(group, results);
+        }
+        return this.#isSingleSelector ? results[0] : results;
+    }
+
+    write(values) {
+        if (this.#isSingleSelector) {
+            values = [values];
+        }
+        if (!Array.isArray(values) || values.length !== this.#entries.length) {
+            throw new Error(`Expected ${this.#entries.length} values for ${this.#entries.length} compiled selectors`);
+        }
+
+        // validate all values before the first one is written
+        this.#entries.forEach((entry, index) => {
+            if (entry.writeError) {
+                throw new Error(`Can't write ${entry.selector}: ${entry.writeError.message}`);
+            }
+            validateValue(entry.valueDescription, values[index]);
+        });
+
+        // one semaphore acquisition per shared memory for all values and their metadata
+        for (const group of this.#groups) {
+            const targets = group.entries.map(({ resolvedValue, index }) =>
+                ({ valueDescription: resolvedValue.valueDescription, bufferStartAddress: resolvedValue.bufferStartAddress, value: values[index] }));
+            writeTargets(group.memory, targets);
+        }
+    }
+}
+
+/**
+ * Resolves selectors once into a handle for fast repeated reads and writes.
+ *
+ * @param {Array<string>|string} selectors - The selector as string or an array of selectors.
+ * @returns {Promise<CompiledSelectors>} - A promise that resolves with the opaque handle of the compiled selectors.
+ * @throws {Error} - Throws an error if a selector can't be resolved.
+ *
+ * @description
+ * Selectors that are not writeable can be compiled as well. The reason why they are not writeable is kept and
+ * reported by writeCompiled().
+ *
+ * @example
+ * // Example usage:
+ * const handle = await compile(['selector1', 'selector2']);
+ * setInterval(() => {
+ *     const results = readCompiled(handle);
+ *     // Process the read process values...
+ * }, 1);
+ */
+export async function compile(selectors) {
+    const isSingleSelector = !Array.isArray(selectors);
+    if (isSingleSelector) {
+        selectors = [selectors];
+    }
+
+    const entries = [];
+    for (const selector of selectors) {
+        try {
+            const resolvedValue = await resolveValue(selector);
+            entries.push(Object.assign(resolvedValue, getWriteTarget(resolvedValue)));
+        } catch (e) {
+            throw new Error(`Can't compile selector ${selector}: ${e.message}`, { cause: e });
+        }
+    }
+
+    return new CompiledSelectors(entries, groupByMemory(entries), isSingleSelector);
+}
+
+/**
+ * Evaluates once whether and where a resolved process value can be written.
+ *
+ * @param {Object} resolvedValue - The resolved process value.
+ * @returns {Object} - The start address of the current buffer or the reason why the value can't be written.
+ */
+function getWriteTarget(resolvedValue) {
+    try {
+        checkWriteable(resolvedValue.processDescription, resolvedValue.valueDescription);
+    } catch (e) {
+        return { writeError: e, bufferStartAddress: 0 };
+    }
+    return { writeError: null, bufferStartAddress: getWriteBufferStartAddress(resolvedValue.processDescription) };
+}
+
+/**
+ * Reads the process values of compiled selectors.
+ *
+ * @param {CompiledSelectors} handle - The handle returned by compile().
+ * @returns {Array<Object>|Object} - The read process values with the same properties as read(), a single object if a single selector was compiled.
+ * @throws {Error} - Throws an error if the shared memory can't be read.
+ */
+export function readCompiled(handle) {
+    if (!(handle instanceof CompiledSelectors)) {
+        throw new Error('readCompiled requires a handle created by compile()');
+    }
+    return handle.read();
+}
+
+/**
+ * Writes values to the process values of compiled selectors.
+ *
+ * @param {CompiledSelectors} handle - The handle returned by compile().
+ * @param {Array<string|number|boolean>|string|number|boolean} values - The values in the order of the compiled selectors, a single value if a single selector was compiled.
+ * @throws {Error} - Throws an error if a value can't be written. No value is written if the validation of one value fails.
+ */
+export function writeCompiled(handle, values) {
+    if (!(handle instanceof CompiledSelectors)) {
+        throw new Error('writeCompiled requires a handle created by compile()');
+    }
+    handle.write(values);
+}
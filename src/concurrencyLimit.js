@@ -0,0 +1,35 @@
+/**
+ * Creates a limit for the number of asynchronous tasks running at the same time.
+ *
+ * @param {number} limit - The maximal number of running tasks, at least 1.
+ * @returns {Function} - Runs a task as soon as less than limit tasks are running and returns a promise with its result.
+ *
+ * @example
+ * // Example usage:
+ * const run = createConcurrencyLimit(4);
+ * const results = await Promise.all(requests.map(request => run(() => dbusGateway(request))));
+ */
+export function createConcurrencyLimit(limit) {
+    const queue = [];
+    let running = 0;
+
+    const next = () => {
+        if (running >= limit || queue.length === 0) {
+            return;
+        }
+        running++;
+        const { task, resolve, reject } = queue.shift();
+        Promise.resolve()
+            .then(task)
+            .then(resolve, reject)
+            .finally(() => {
+                running--;
+                next();
+            });
+    };
+
+    return task => new Promise((resolve, reject) => {
+        queue.push({ task, resolve, reject });
+        next();
+    });
+}
@@ -4,6 +4,8 @@ import { parse } from './dbusReply.js';
 const dBusServicePrefix = 'de.jupiter.';
 
 let staticDBusReference;
+// number of calls using the static D-Bus reference, the connection is closed when the last of them is finished
+let pendingCalls = 0;
 /**
  * Retrieves and returns a reference to the D-Bus instance (system or session bus) based on the current platform.
  *
@@ -30,9 +32,25 @@ function getBus() {
         }
     }
     // Return the cached D-Bus instance reference.
+    pendingCalls++;
     return staticDBusReference;
 }
 
+/**
+ * Releases the D-Bus instance reference of a finished call.
+ *
+ * @description
+ * Calls may run in parallel on the same connection, so it is closed only when the last pending call is finished.
+ * The next call connects again, so no idle connection stays open.
+ */
+function releaseBus() {
+    pendingCalls--;
+    if (pendingCalls === 0 && staticDBusReference) {
+        staticDBusReference.connection.end();
+        staticDBusReference = null;
+    }
+}
+
 const defaultServiceDescription = Object.freeze({
     servicePrefix: dBusServicePrefix,
     serviceName: '',
@@ -51,7 +69,7 @@ const defaultServiceDescription = Object.freeze({
  * @description
  * This function acts as a gateway for invoking D-Bus methods. It constructs a D-Bus proxy object based on the provided
  * service description, validates the existence of the specified method, invokes the method with the provided parameters,
- * disconnects from the D-Bus, and returns the parsed response. If any issues occur during this process, appropriate error
+ * disconnects from the D-Bus after the last pending call, and returns the parsed response. If any issues occur during this process, appropriate error
  * messages are generated and thrown.
  *
  * @example
@@ -119,14 +137,14 @@ export async function dbusGateway(serviceDescription) {
             });
         });
 
-        bus.connection.end();
-        staticDBusReference = null;
         return parse(response);
     } catch (err) {
         throw new Error(
             `Selector not found. ${err.message} @ ${description.servicePrefix + description.serviceName}, ${description.objectPath}, ${description.interfaceName}, ${description.method}(${description.params})`,
             { cause: err }
         );
+    } finally {
+        releaseBus();
     }
 }
 
@@ -25,7 +25,7 @@ export function formatData(data) {
     // Handle cases where data is a string representing a JSON object or array.
     if (typeof data === 'string') {
         // return a string as a parsed object or array if it starts with { or [
-        if (data.match(/^\s*(\{.*\}|\[.*\])\s*$/gs)) {
+        if (isJsonObjectOrArray(data)) {
             try {
                 const parsedData = JSON.parse(data);
                 return parsedData;
@@ -42,6 +42,104 @@ export function formatData(data) {
     return [data];
 }
 
+const whitespace = /\s/;
+
+/**
+ * Checks if a string is enclosed in {} or [], ignoring leading and trailing whitespace.
+ *
+ * @param {string} data - The string to check.
+ * @returns {boolean} - True if the string may contain a JSON object or array.
+ *
+ * @description
+ * Only the characters at both ends are checked, process descriptions are hundreds of KB long and a regular
+ * expression over the whole string costs as much as parsing it.
+ */
+function isJsonObjectOrArray(data) {
+    let first = 0;
+    let last = data.length - 1;
+    while (first < last && whitespace.test(data[first])) {
+        first++;
+    }
+    while (last > first && whitespace.test(data[last])) {
+        last--;
+    }
+    return first < last && ((data[first] === '{' && data[last] === '}') || (data[first] === '[' && data[last] === ']'));
+}
+
+// fields of a process value that are used to read, write and browse it
+const processValueFields = ['offsetSharedMemory', 'type', 'sizeValue', 'relativeOffsetMetadata', 'sizeMetadata', 'bitMask', 'readOnly', 'labelText'];
+
+/**
+ * Reduces a process description to the data needed to read, write and browse its process values.
+ *
+ * @param {Object} description - The process description as parsed from the D-Bus reply.
+ * @returns {Object} - The compact process description.
+ *
+ * @description
+ * The root keeps all of its properties, like the key and size of the shared memory, the buffer type and the cpveVersion.
+ * The tree below keeps only TreeNodes and process values, each process value only its layout, type, access,
+ * label and the POSIX unit of its first measurement range. Descriptions of EtherCatGateway instances shrink to a
+ * fraction of their size, which is kept in memory and in the persistent cache. The compaction costs about a third of
+ * the time of JSON.parse, it also runs without the persistent cache, so the fingerprints of refreshList don't depend on
+ * where a description was loaded from.
+ */
+export function compactProcessDescription(description) {
+    if (description === null || typeof description !== 'object' || description.type !== 'TreeNode') {
+        return description;
+    }
+    return { ...description, value: compactTreeNodeValue(description.value) };
+}
+
+/**
+ * Compacts the children of a TreeNode.
+ *
+ * @param {Object} value - The children of the TreeNode by name.
+ * @returns {Object} - The compacted children, children that are neither TreeNodes nor process values are removed.
+ */
+function compactTreeNodeValue(value) {
+    const compact = {};
+    for (const [key, child] of Object.entries(value)) {
+        if (child === null || typeof child !== 'object') {
+            continue;
+        }
+        if (child.type === 'TreeNode') {
+            compact[key] = { type: 'TreeNode', value: compactTreeNodeValue(child.value) };
+        } else if (Object.hasOwn(child, 'offsetSharedMemory')) {
+            compact[key] = compactProcessValue(child);
+        }
+    }
+    return compact;
+}
+
+/**
+ * Compacts the description of a process value.
+ *
+ * @param {Object} source - The description of the process value.
+ * @returns {Object} - The description with only the used fields.
+ */
+function compactProcessValue(source) {
+    const compact = {};
+    for (const field of processValueFields) {
+        if (Object.hasOwn(source, field)) {
+            compact[field] = source[field];
+        }
+    }
+    // until now only one measurement range is supported, its POSIX unit is always available
+    const unit = source.measurementRangeAttributes?.[0]?.unitText?.POSIX;
+    if (unit !== undefined) {
+        compact.measurementRangeAttributes = [{ unitText: { POSIX: unit } }];
+    }
+    return compact;
+}
+
+
+// the dbus types of the inner items and the names of their types
+const innerItemTypes = Object.freeze({
+    s: 'string',
+    b: 'boolean',
+    i: 'integer',
+    a: 'array',
+});
 
 /**
  * Parses a D-Bus inner item and extracts its type and value.
@@ -58,19 +156,10 @@ const parseInnerItem = (item) => {
         const value = item[1];
 
         if (Array.isArray(dbusDescription) && dbusDescription.length === 1 && typeof dbusDescription[0] === 'object' && Array.isArray(value)) {
-            const type = dbusDescription[0].type; // the type of the value, e.g. 's' for string, 'b' for boolean, etc.
-            if (type === 's') {
-                // string
-                return { type: 'string', value: value[0] };
-            } else if (type === 'b') {
-                // boolean
-                return { type: 'boolean', value: value[0] };
-            } else if (type === 'i') {
-                // integer
-                return { type: 'integer', value: value[0] };
-            } else if (type === 'a') {
-                // array
-                return { type: 'array', value: value[0] };
+            // the type of the value, e.g. 's' for string, 'b' for boolean, etc.
+            const type = Object.hasOwn(innerItemTypes, dbusDescription[0].type) ? innerItemTypes[dbusDescription[0].type] : undefined;
+            if (type !== undefined) {
+                return { type, value: value[0] };
             }
         }
     }
@@ -0,0 +1,223 @@
+import fs from 'fs';
+import path from 'path';
+
+// the format of the cache file, a file with another format is ignored
+const cacheFormat = 1;
+
+// delay to collect the descriptions fetched by a browse into one write of the cache file
+const saveDelayMs = 1000;
+
+// directory of the POSIX shared memories, a persisted description is only used if its shared memory exists
+const sharedMemoryDirectory = '/dev/shm';
+
+let cacheFile = null;
+let loadedCache = null;
+
+/**
+ * Sets the file in which the process descriptions are persisted between restarts of the process.
+ *
+ * @param {string|null} file - The path of the cache file, null disables the persistent cache.
+ * @throws {Error} - Throws an error if file is neither a string nor null.
+ *
+ * @description
+ * The file is read on the next request of a process description. The persisted descriptions of a module are only
+ * used after the first description of the module fetched from the device equals its persisted copy. A module
+ * reconfigured without a firmware update, e.g. its EtherCAT configuration, discards its persisted descriptions, another
+ * cpveVersion discards the whole file. A persisted description is also only used if its shared memory exists with at
+ * least the described size.
+ */
+export function setDescriptionCacheFile(file) {
+    if (file !== null && typeof file !== 'string') {
+        throw new Error('file is neither a string nor null');
+    }
+    cacheFile = file;
+    loadedCache = null;
+}
+
+/**
+ * Loads a process description from the persistent cache or fetches it from the device.
+ *
+ * @param {string} key - The key of the process description, containing module, instance, object and language separated by '#'.
+ * @param {Function} fetchDescription - Fetches the process description from the device.
+ * @returns {Promise<Object>} - A promise that resolves with the process description.
+ * @throws {Error} - Throws the error of fetchDescription.
+ */
+export async function loadDescription(key, fetchDescription) {
+    if (cacheFile === null) {
+        return fetchDescription();
+    }
+
+    const cache = await loadCache();
+    const moduleName = key.split('#')[0];
+
+    // the first description of a module is always fetched from the device and revalidates its persisted descriptions
+    if (!cache.validatedModules.has(moduleName)) {
+        const running = cache.validations.get(moduleName);
+        if (running === undefined) {
+            const validation = fetchDescription()
+                .then(description => revalidateModule(cache, moduleName, key, description))
+                .finally(() => cache.validations.delete(moduleName));
+            cache.validations.set(moduleName, validation);
+            return validation;
+        }
+        // wait for the running revalidation, if it fails or can't validate the module the next request revalidates again
+        await running.catch(() => { });
+        return loadDescription(key, fetchDescription);
+    }
+
+    const persisted = getDescription(cache, key);
+    if (persisted !== undefined && (cache.fetchedKeys.has(key) || await hasSharedMemory(persisted))) {
+        return persisted;
+    }
+    return storeDescription(cache, key, await fetchDescription());
+}
+
+/**
+ * Replaces a process description in the persistent cache with one that was fetched from the device.
+ *
+ * @param {string} key - The key of the process description, containing module, instance, object and language.
+ * @param {Object} description - The process description fetched from the device.
+ * @returns {Promise<void>} - A promise that resolves when the cache is updated, the file is written later.
+ */
+export async function updateDescription(key, description) {
+    if (cacheFile !== null) {
+        storeDescription(await loadCache(), key, description);
+    }
+}
+
+/**
+ * Reads the cache file once, a missing or unreadable file results in an empty cache.
+ *
+ * @returns {Promise<Object>} - A promise that resolves with the cache.
+ */
+function loadCache() {
+    if (loadedCache === null) {
+        const file = cacheFile;
+        loadedCache = fs.promises.readFile(file, 'utf8')
+            .then(content => JSON.parse(content))
+            .then(content => content.format === cacheFormat ? content : {})
+            .catch(() => ({}))
+            .then(content => ({
+                file,
+                cpveVersion: content.cpveVersion,
+                descriptions: content.descriptions || {},
+                // modules whose persisted descriptions are confirmed by a description fetched from the device
+                validatedModules: new Set(),
+                validations: new Map(),
+                // descriptions fetched by this process, they need no check
+                fetchedKeys: new Set(),
+                saveTimer: null,
+            }));
+    }
+    return loadedCache;
+}
+
+function getDescription(cache, key) {
+    return Object.hasOwn(cache.descriptions, key) ? cache.descriptions[key] : undefined;
+}
+
+/**
+ * Compares a description fetched from the device with its persisted copy and discards the persisted descriptions of
+ * the module if they differ.
+ *
+ * @param {Object} cache - The cache.
+ * @param {string} moduleName - The name of the module of the description.
+ * @param {string} key - The key of the process description.
+ * @param {Object} description - The process description fetched from the device.
+ * @returns {Object} - The process description.
+ */
+function revalidateModule(cache, moduleName, key, description) {
+    const persisted = description.cpveVersion === cache.cpveVersion ? getDescription(cache, key) : undefined;
+    if (persisted !== undefined && JSON.stringify(persisted) !== JSON.stringify(description)) {
+        // the module was reconfigured, the offsets of its other descriptions can be stale as well
+        getPersistedKeys(cache, moduleName).forEach(persistedKey => delete cache.descriptions[persistedKey]);
+    }
+
+    storeDescription(cache, key, description);
+
+    // without a persisted copy to compare, the next description of the module revalidates it
+    if (persisted !== undefined || getPersistedKeys(cache, moduleName).length === 0) {
+        cache.validatedModules.add(moduleName);
+    }
+    return description;
+}
+
+/**
+ * Gets the keys of the descriptions of a module that were read from the cache file and not fetched by this process.
+ *
+ * @param {Object} cache - The cache.
+ * @param {string} moduleName - The name of the module.
+ * @returns {Array<string>} - The keys of the persisted descriptions.
+ */
+function getPersistedKeys(cache, moduleName) {
+    return Object.keys(cache.descriptions).filter(key => key.startsWith(`${moduleName}#`) && !cache.fetchedKeys.has(key));
+}
+
+/**
+ * Checks that the shared memory of a persisted description exists and is at least as large as described.
+ *
+ * @param {Object} description - The persisted process description.
+ * @returns {Promise<boolean>} - A promise that resolves with true if the description fits the shared memory.
+ */
+async function hasSharedMemory(description) {
+    if (typeof description.key !== 'string' || !Number.isInteger(description.sizeOfSharedMemory)) {
+        return false;
+    }
+    try {
+        const status = await fs.promises.stat(path.join(sharedMemoryDirectory, `${description.key}SharedMemory`));
+        return status.size >= description.sizeOfSharedMemory;
+    } catch {
+        return false;
+    }
+}
+
+/**
+ * Adds a fetched process description to the cache and schedules the write of the cache file.
+ *
+ * @param {Object} cache - The cache.
+ * @param {string} key - The key of the process description.
+ * @param {Object} description - The process description fetched from the device.
+ * @returns {Object} - The process description.
+ */
+function storeDescription(cache, key, description) {
+    // another cpveVersion means another firmware, none of the persisted descriptions can be trusted anymore
+    if (description.cpveVersion !== cache.cpveVersion) {
+        cache.cpveVersion = description.cpveVersion;
+        cache.descriptions = {};
+    }
+    cache.descriptions[key] = description;
+    cache.fetchedKeys.add(key);
+    scheduleSave(cache);
+    return description;
+}
+
+/**
+ * Writes the cache file after the save delay, so a browse results in a single write.
+ *
+ * @param {Object} cache - The cache.
+ */
+function scheduleSave(cache) {
+    if (cache.saveTimer !== null) {
+        return;
+    }
+    cache.saveTimer = setTimeout(() => {
+        cache.saveTimer = null;
+        saveCache(cache).catch(error => console.log(`Can't write process description cache ${cache.file}: ${error}`));
+    }, saveDelayMs);
+    // a pending write must not keep the process alive
+    cache.saveTimer.unref();
+}
+
+/**
+ * Writes the cache to a temporary file and renames it, so a crash never leaves a partially written cache file.
+ *
+ * @param {Object} cache - The cache.
+ * @returns {Promise<void>} - A promise that resolves when the cache file is written.
+ */
+async function saveCache(cache) {
+    const content = JSON.stringify({ format: cacheFormat, cpveVersion: cache.cpveVersion, descriptions: cache.descriptions });
+    const temporaryFile = `${cache.file}.${process.pid}.tmp`;
+    await fs.promises.mkdir(path.dirname(cache.file), { recursive: true });
+    await fs.promises.writeFile(temporaryFile, content);
+    await fs.promises.rename(temporaryFile, cache.file);
+}
@@ -0,0 +1,39 @@
+import { native } from './importShm.js';
+
+/**
+ * Creates the descriptor table for the native batch read of process values.
+ *
+ * @param {Array<Object>} resolvedValues - The resolved process values with the index of their process description and their entry in it.
+ * @returns {Int32Array} - The descriptor table with the entries (offset, type, size, bitMask, metadataOffset, metadataSize) for each value.
+ * @throws {Error} - Throws an error if a value type or a metadata size is not supported.
+ *
+ * @description
+ * All offsets in the descriptor table are relative to the start of the current buffer, like the offsets in the process description.
+ * The layout is copied out of the index, the table can be created once and reused for every read of the same process values.
+ */
+export function createDescriptorTable(resolvedValues) {
+    const stride = native.descriptorTableStride;
+    const table = new Int32Array(resolvedValues.length * stride);
+
+    resolvedValues.forEach(({ index, entry }, i) => {
+        const type = native.valueTypes[index.types[entry]];
+        if (type === undefined) {
+            throw new Error(`Unknown value type: ${index.types[entry]}`);
+        }
+
+        const sizeMetadata = index.metadataSizes[entry];
+        if (![0, 3, 4, 8].includes(sizeMetadata)) {
+            throw new Error(`READ: Unsupported metadata size: ${sizeMetadata}. Only sizes of 8, 3, 4 and 0 are supported.`);
+        }
+
+        const row = i * stride;
+        table[row] = index.offsets[entry];
+        table[row + 1] = type;
+        table[row + 2] = index.sizes[entry];
+        table[row + 3] = index.bitMasks[entry];
+        table[row + 4] = index.metadataOffsets[entry];
+        table[row + 5] = sizeMetadata;
+    });
+
+    return table;
+}
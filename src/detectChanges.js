@@ -0,0 +1,76 @@
+import { createDescriptorTable } from './descriptorTable.js';
+import { native } from './importShm.js';
+import { createDecodedResult, groupByMemory, resolveValue } from './readProcessValues.js';
+
+/**
+ * Creates a detector for changes of process values, which is polled by the caller, e.g. in its own control cycle.
+ * Each poll copies the range of each shared memory that covers the process values into a snapshot and compares it
+ * with the snapshot of the previous poll natively with SIMD instructions. Only the process values whose value or
+ * metadata overlaps a changed byte range are decoded.
+ *
+ * @param {Array|String} selectors - The selector as string or an array of strings to detect changes of.
+ * @returns {Promise<Object>} - A promise that resolves with the detector. Its poll() returns the changed process values
+ *                              like read, the first poll returns all of them.
+ * @throws {Error} - If a selector can't be resolved.
+ *
+ * @example
+ *     const detector = await createChangeDetector(['selector1', 'selector2']);
+ *     setInterval(() => {
+ *         for (const change of detector.poll()) {
+ *             console.log(change.selector, change.value);
+ *         }
+ *     }, 100);
+ */
+export async function createChangeDetector(selectors) {
+    const resolvedValues = [];
+    for (const selector of Array.isArray(selectors) ? selectors : [selectors]) {
+        try {
+            resolvedValues.push(await resolveValue(selector));
+        } catch (e) {
+            throw new Error(`Can't detect changes of process value of ${selector}: ${e}`);
+        }
+    }
+
+    const snapshots = groupByMemory(resolvedValues).map(createSnapshotPair);
+    return {
+        poll: () => snapshots.flatMap(pollChanges),
+    };
+}
+
+/**
+ * Creates the two snapshots of a group, which are swapped on each poll.
+ *
+ * @param {Object} group - The shared memory and the resolved process values with their index.
+ * @returns {Object} - The group, its descriptor table, the range of the current buffer and the snapshots.
+ */
+function createSnapshotPair(group) {
+    const descriptorTable = createDescriptorTable(group.entries.map(entry => entry.resolvedValue));
+    const { offset, length } = group.memory.snapshotRange(descriptorTable);
+    return {
+        group,
+        descriptorTable,
+        offset,
+        previous: null,
+        current: Buffer.alloc(length),
+        spare: Buffer.alloc(length),
+    };
+}
+
+/**
+ * Takes a new snapshot of a group and decodes the process values that changed since the previous one.
+ *
+ * @param {Object} pair - The snapshots of a group created by createSnapshotPair.
+ * @returns {Array<Object>} - The changed process values like the results of read.
+ */
+function pollChanges(pair) {
+    const { group, descriptorTable, offset, current } = pair;
+    group.memory.readRange(offset, current.length, current);
+
+    const { indices, values, errorCodes, hasErrorCodes } = native.diffSnapshots(pair.previous, current, descriptorTable, offset);
+
+    // the current snapshot becomes the previous one, the previous one is overwritten by the next poll
+    pair.current = pair.previous ?? pair.spare;
+    pair.previous = current;
+
+    return Array.from(indices, (entry, i) => createDecodedResult(group.entries[entry].resolvedValue, values[i], errorCodes[i], hasErrorCodes[i] !== 0));
+}
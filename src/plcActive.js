@@ -1,4 +1,5 @@
 import { versionFileExists } from './deviceVersion.js';
+import { getProcessDescriptionIndex } from './processDescriptionIndex.js';
 import { getProcessDataDescription } from './providerHandler.js';
 import { write } from './writeProcessValues.js';
 
@@ -30,17 +31,6 @@ const setPlcActiveFlags = async () => {
     await write(writeList);
 };
 
-/**
- * Checks if an object has a property.
- *
- * @param {object} obj - The object.
- * @param {string} prop - The property name.
- * @returns {boolean} - True if the object has the property, false otherwise.
- */
-function hasProperty(obj, prop) {
-    return Object.prototype.hasOwnProperty.call(obj, prop);
-}
-
 /**
  * Retrieves all selectors corresponding to the 'PlcActive' process value within the EtherCatGateway module.
  *
@@ -66,7 +56,7 @@ const getPlcActiveFlagSelectors = async () => {
             'us_EN');
 
         // Find all selectors corresponding to the 'PlcActive' process value
-        const plcActiveSelectors = findAllMatchingSelectors(processDescription, { moduleName, instanceName, objectName }, []);
+        const plcActiveSelectors = findAllMatchingSelectors(getProcessDescriptionIndex(processDescription), { moduleName, instanceName, objectName });
         return plcActiveSelectors;
     } catch (error) {
         console.log(`Error while fetching PlcActive selectors (fine for v9): ${error.message}`);
@@ -76,32 +66,16 @@ const getPlcActiveFlagSelectors = async () => {
 };
 
 /**
- * Recursively finds leaf objects with 'PlcActive' in the name and returns their selectors.
+ * Finds the process values with 'PlcActive' in the name and returns their selectors.
  *
- * @param {object} source - The source object to search for leaf objects.
+ * @param {ProcessDescriptionIndex} index - The index of the process description.
  * @param {object} description - The description of the leaf objects with the module name, instance name, and object name.
- * @param {Array} objectPath - The current path in the object hierarchy.
+ * @returns {Array<string>} - The selectors of all process values with 'PlcActive' as last path element.
  */
-function findAllMatchingSelectors(source, description, objectPath) {
-    const selectorList = [];
-
-    // if a source is of type TreeNode, there are structures one stage deeper in the value property
-    if (hasProperty(source, 'type') && source.type === 'TreeNode') {
-        // recursive call this function with all structures
-        for (const [key, value] of Object.entries(source.value)) {
-            const nextPath = objectPath.concat(key);
-            const matchingSelector = findAllMatchingSelectors(value, description, nextPath);
-            if (matchingSelector.length > 0) selectorList.push(...matchingSelector);
-        }
-    }
-
-    // collect all leafs with 'PlcActive' as last path element
-    if (objectPath[objectPath.length - 1] == 'PlcActive') {
-        const pathName = objectPath.join('/');
-        selectorList.push(`ProcessData#${description.moduleName}#${description.objectName}#${description.instanceName}#${pathName}`);
-    }
-
-    return selectorList;
+function findAllMatchingSelectors(index, description) {
+    return index.paths
+        .filter(pathName => pathName.split('/').pop() === 'PlcActive')
+        .map(pathName => `ProcessData#${description.moduleName}#${description.objectName}#${description.instanceName}#${pathName}`);
 }
 
 export {
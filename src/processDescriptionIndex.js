@@ -0,0 +1,103 @@
+/**
+ * Flat index of the process values of one instance, built once from its process description tree.
+ * The layout of the process values is kept as struct of arrays, the position of a process value in the arrays is its entry.
+ */
+export class ProcessDescriptionIndex {
+    #entryByPath = new Map();
+
+    /**
+     * Builds the index of a process description.
+     *
+     * @param {Object} processDescription - The process description tree of an instance.
+     */
+    constructor(processDescription) {
+        const leafs = [];
+        collectLeafs(processDescription, [], leafs);
+        const count = leafs.length;
+
+        this.processDescription = processDescription;
+        this.paths = new Array(count);
+        this.valueDescriptions = new Array(count);
+        this.types = new Array(count);
+        this.offsets = new Int32Array(count);
+        this.sizes = new Int32Array(count);
+        this.bitMasks = new Uint8Array(count);
+        this.metadataOffsets = new Int32Array(count);
+        this.metadataSizes = new Int32Array(count);
+
+        leafs.forEach(({ path, valueDescription }, entry) => {
+            const sizeMetadata = valueDescription.sizeMetadata || 0;
+            this.paths[entry] = path;
+            this.valueDescriptions[entry] = valueDescription;
+            this.types[entry] = valueDescription.type;
+            this.offsets[entry] = valueDescription.offsetSharedMemory;
+            this.sizes[entry] = valueDescription.sizeValue || 0;
+            this.bitMasks[entry] = valueDescription.bitMask || 0;
+            this.metadataOffsets[entry] = sizeMetadata > 0 ? valueDescription.offsetSharedMemory + valueDescription.relativeOffsetMetadata : 0;
+            this.metadataSizes[entry] = sizeMetadata;
+            this.#entryByPath.set(path, entry);
+        });
+    }
+
+    /**
+     * The number of process values in the index.
+     */
+    get length() {
+        return this.paths.length;
+    }
+
+    /**
+     * Gets the entry of a process value.
+     *
+     * @param {string} path - The path of the process value inside of the instance, divided by '/' like in the selector.
+     * @returns {number} - The entry of the process value in the arrays of the index.
+     * @throws {Error} - Throws an error if the path is not a process value of the instance.
+     */
+    getEntry(path) {
+        const entry = this.#entryByPath.get(path);
+        if (entry === undefined) {
+            throw new Error(`Parameter ${path} not found in process description`);
+        }
+        return entry;
+    }
+}
+
+// the index is built once per process description and released together with it
+const indexCache = new WeakMap();
+
+/**
+ * Gets the index of a process description, it is built on first use.
+ *
+ * @param {Object} processDescription - The process description tree of an instance.
+ * @returns {ProcessDescriptionIndex} - The index of the process description.
+ */
+export function getProcessDescriptionIndex(processDescription) {
+    let index = indexCache.get(processDescription);
+    if (index === undefined) {
+        index = new ProcessDescriptionIndex(processDescription);
+        indexCache.set(processDescription, index);
+    }
+    return index;
+}
+
+/**
+ * Collects all process values of a process description tree in the order of the tree.
+ *
+ * @param {Object} source - The current node of the process description tree.
+ * @param {Array<string>} objectPath - The path to the current node.
+ * @param {Array<Object>} leafs - The collected process values with their path.
+ */
+function collectLeafs(source, objectPath, leafs) {
+    // if a source is of type TreeNode, there are structures one stage deeper in the value property
+    if (source.type === 'TreeNode') {
+        for (const [key, value] of Object.entries(source.value)) {
+            collectLeafs(value, objectPath.concat(key), leafs);
+        }
+        return;
+    }
+
+    // leafs with 'offsetSharedMemory' property are process values
+    if (Object.prototype.hasOwnProperty.call(source, 'offsetSharedMemory')) {
+        leafs.push({ path: objectPath.join('/'), valueDescription: source });
+    }
+}
@@ -18,48 +18,16 @@ export function getObjectFromUrl(processValueUrl) {
     const moduleName = parts[1];
     const objectName = parts[2];
     const instanceName = parts[3];
-    let parameterUrl = parts[4];
-
-    // Replace all '/' with '.value.' to use the URL in the process description tree.
-    parameterUrl = parameterUrl.replace(/\//g, '.value.');
-    parameterUrl = 'value.' + parameterUrl;
+    // the path divided by '/' is the key of the process value in the index of the process description
+    const parameterPath = parts[4];
 
     // Construct and return the object representation of the parsed components.
     const obj = {
         moduleName,
         objectName,
         instanceName,
-        parameterUrl
+        parameterPath
     };
 
     return obj;
 }
-
-/**
- * Searches for a parameter URL in the process description tree and retrieves the corresponding process value description.
- *
- * @param {Object} processDescription - The process description tree to search within.
- * @param {string} parameterUrl - The URL representing the parameter's location in the process description tree.
- * @returns {Object} - The process value description found at the specified parameter URL.
- * @throws {Error} - Throws an error if the parameter URL is not found in the process description tree.
- */
-export function getNestedProcessValueDescription(processDescription, parameterUrl) {
-    // If array indices are used in the path, replace them with '.$index'.
-    // parameterUrl = parameterUrl.replace(/\[(\w+)\]/g, '.$1');
-
-    // Split the parameter URL into individual parts.
-    const urlPartList = parameterUrl.split('.');
-
-    // Build the path to the parameter inside the process description tree.
-    for (const urlPart of urlPartList) {
-        // Check if the current URL part exists in the process description.
-        if (urlPart in processDescription) {
-            processDescription = processDescription[urlPart];
-        } else {
-            // Throw an error if the parameter URL is not found in the process description.
-            throw new Error(`Parameter ${parameterUrl} not found in process description`);
-        }
-    }
-    // Return the process value description found at the specified parameter URL.
-    return processDescription;
-}
@@ -0,0 +1,79 @@
+import { getStats } from './bufferHandler.js';
+
+// upper bounds in seconds of the buckets of the exported latency histograms
+const latencyBucketBounds = [1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 1e-2, 1e-1, 1];
+
+// the counters of getStats exported per shared memory
+const counters = [
+    ['varitron_shm_reads_total', 'Consistent reads of the shared memory.', stats => stats.reads.count],
+    ['varitron_shm_read_bytes_total', 'Bytes copied by consistent reads.', stats => stats.reads.bytes],
+    ['varitron_shm_read_retries_total', 'Reads repeated after a collision with the producer.', stats => stats.reads.retries],
+    ['varitron_shm_read_timeouts_total', 'Reads that reached the read timeout.', stats => stats.reads.timeouts],
+    ['varitron_shm_read_failures_total', 'Reads that failed.', stats => stats.reads.failures],
+    ['varitron_shm_writes_total', 'Writes into the shared memory.', stats => stats.writes.count],
+    ['varitron_shm_write_bytes_total', 'Bytes written.', stats => stats.writes.bytes],
+    ['varitron_shm_write_failures_total', 'Writes that failed.', stats => stats.writes.failures],
+    ['varitron_shm_semaphore_locks_total', 'Locks of the semaphore.', stats => stats.locks.locks],
+    ['varitron_shm_semaphore_contended_locks_total', 'Locks of the semaphore that had to wait.', stats => stats.locks.contendedLocks],
+    ['varitron_shm_semaphore_timeouts_total', 'Locks of the semaphore that reached the lock timeout.', stats => stats.locks.timeouts],
+    ['varitron_shm_semaphore_failures_total', 'Locks and unlocks of the semaphore that failed.', stats => stats.locks.failures],
+    ['varitron_shm_semaphore_wait_seconds_total', 'Time spent waiting for the semaphore.', stats => stats.locks.totalWaitUs / 1e6],
+];
+
+const histograms = [
+    ['varitron_shm_read_duration_seconds', 'Duration of consistent reads including the wait for the producer.', stats => stats.reads.latency],
+    ['varitron_shm_write_duration_seconds', 'Duration of writes including the wait for the semaphore.', stats => stats.writes.latency],
+];
+
+/**
+ * Gets the counters and latency histograms of all attached shared memories in the Prometheus text format, e.g. to
+ * serve them on a /metrics endpoint. Each shared memory is labeled with its key.
+ *
+ * @returns {string} - The metrics in the Prometheus text exposition format.
+ *
+ * @description
+ * The native histograms have 8 log-linear buckets per power of two. They are summed up into the fixed buckets of the
+ * exported histograms, a native bucket counts into the first exported bucket whose bound is not below its upper bound.
+ * So the exported buckets are at most 12.5 % too pessimistic.
+ *
+ * @example
+ *     http.createServer((request, response) => response.end(getPrometheusMetrics())).listen(9100);
+ */
+export function getPrometheusMetrics() {
+    const stats = getStats();
+    const lines = [];
+
+    for (const [name, help, get] of counters) {
+        lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} counter`);
+        stats.forEach(memoryStats => lines.push(`${name}{key="${escapeLabel(memoryStats.key)}"} ${get(memoryStats)}`));
+    }
+    for (const [name, help, get] of histograms) {
+        lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} histogram`);
+        stats.forEach(memoryStats => lines.push(...formatHistogram(name, memoryStats.key, get(memoryStats))));
+    }
+    return lines.join('\n') + '\n';
+}
+
+/**
+ * Formats a native latency histogram as cumulative Prometheus buckets.
+ *
+ * @param {string} name - The name of the metric.
+ * @param {string} key - The key of the shared memory.
+ * @param {Object} latency - The latency histogram of getStats with the non-empty buckets in ns.
+ * @returns {Array<string>} - The lines of the buckets, the sum and the count.
+ */
+function formatHistogram(name, key, latency) {
+    const label = `key="${escapeLabel(key)}"`;
+    const lines = latencyBucketBounds.map(bound => {
+        const count = latency.buckets.filter(bucket => bucket.upperBoundNs <= bound * 1e9).reduce((sum, bucket) => sum + bucket.count, 0);
+        return `${name}_bucket{${label},le="${bound}"} ${count}`;
+    });
+    lines.push(`${name}_bucket{${label},le="+Inf"} ${latency.count}`);
+    lines.push(`${name}_sum{${label}} ${latency.sumNs / 1e9}`);
+    lines.push(`${name}_count{${label}} ${latency.count}`);
+    return lines;
+}
+
+function escapeLabel(value) {
+    return value.replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n');
+}
@@ -1,9 +1,42 @@
 import { dbusGateway } from './dbusGateway.js';
-import { getProcessDataDescriptionBuffer } from './bufferHandler.js';
+import { compactProcessDescription } from './dbusReply.js';
+import { loadDescription, updateDescription } from './descriptionCache.js';
+import { getProcessDescriptionIndex } from './processDescriptionIndex.js';
 import { getObjectFromUrl } from './processValueUrl.js';
+import { loadSharedDescription, updateSharedDescription } from './sharedDescriptions.js';
 
-//buffer for ProcessDataDescription
-const ProcessDataDescriptionBuffer = [];
+// cache of the process descriptions, keyed by module, instance, object and language
+const processDataDescriptionCache = new Map();
+
+// process descriptions that are currently requested, parallel requests of the same description share one D-Bus call
+const pendingProcessDataDescriptions = new Map();
+
+// counts the refreshed process descriptions, so users of values resolved from a description can tell they are outdated
+let processDataDescriptionGeneration = 0;
+
+function getCacheKey(moduleName, instanceName, objectName, language) {
+    return `${moduleName}#${instanceName}#${objectName}#${language}`;
+}
+
+/**
+ * Fetches the process data description of an instance via D-Bus.
+ *
+ * @param {string} moduleName - The name of the D-Bus service representing the module.
+ * @param {string} instanceName - The name of the instance associated with the process data.
+ * @param {string} objectName - The name of the D-Bus object path representing the object.
+ * @param {string} language - The language code specifying the desired language for the process description.
+ * @returns {Promise<Object>} - A promise that resolves with the compact process data description.
+ */
+async function fetchProcessDataDescription(moduleName, instanceName, objectName, language) {
+    const serviceDescription = {
+        serviceName: moduleName,
+        objectPath: '/' + objectName,
+        interfaceName: 'Interface.ProcessDecription',
+        method: 'getProcessDataDescription',
+        params: [instanceName, language],
+    };
+    return compactProcessDescription(await dbusGateway(serviceDescription));
+}
 
 /**
  * Retrieves the process data description for a specified module, instance, and object.
@@ -14,54 +47,78 @@ const ProcessDataDescriptionBuffer = [];
  * @param {string} language - The language code specifying the desired language for the process description.
  * @returns {Promise<Object>} - A promise that resolves with the process data description.
  * @throws {Error} - Throws an error if there's an issue with D-Bus communication or if the request fails.
+ *
+ * @description
+ * The description is taken from the memory cache, then from the descriptions shared by all worker threads,
+ * then from the persistent cache (see setDescriptionCacheFile) and only then fetched via D-Bus.
  */
 export async function getProcessDataDescription(moduleName, instanceName, objectName, language) {
-    // Receive processDescription from Buffer, if available.
-    const processDescriptionBuffer = getProcessDataDescriptionBuffer(moduleName, instanceName, objectName, ProcessDataDescriptionBuffer);
-
-    // If the processDescriptionBuffer is undefined, fetch it from D-Bus and update the Buffer.
-    if (processDescriptionBuffer == undefined) {
-        const method = 'getProcessDataDescription';
-        const params = [instanceName, language];
-        const serviceDescription = {
-            serviceName: moduleName,
-            objectPath: '/' + objectName,
-            interfaceName: 'Interface.ProcessDecription',
-            method,
-            params,
-        };
+    // Receive processDescription from the cache, if available.
+    const cacheKey = getCacheKey(moduleName, instanceName, objectName, language);
+    const cachedProcessDescription = processDataDescriptionCache.get(cacheKey);
+    if (cachedProcessDescription !== undefined) {
+        return cachedProcessDescription;
+    }
 
-        // Invoke the D-Bus gateway to get the process description.
-        const processDescription = await dbusGateway(serviceDescription);
+    // If the process description is not cached, load it and update the cache.
+    let pending = pendingProcessDataDescriptions.get(cacheKey);
+    if (pending === undefined) {
+        pending = loadSharedDescription(cacheKey, () => loadDescription(cacheKey, () => fetchProcessDataDescription(moduleName, instanceName, objectName, language)))
+            .then(processDescription => {
+                processDataDescriptionCache.set(cacheKey, processDescription);
+                return processDescription;
+            })
+            .finally(() => pendingProcessDataDescriptions.delete(cacheKey));
+        pendingProcessDataDescriptions.set(cacheKey, pending);
+    }
+    return pending;
+}
 
-        // Push the received process description to the buffer.
-        ProcessDataDescriptionBuffer.push({
-            moduleName,
-            instanceName,
-            objectName,
-            processDescription
-        });
+/**
+ * Fetches the process data description of an instance via D-Bus again and replaces the cached one.
+ *
+ * @param {string} moduleName - The name of the D-Bus service representing the module.
+ * @param {string} instanceName - The name of the instance associated with the process data.
+ * @param {string} objectName - The name of the D-Bus object path representing the object.
+ * @param {string} language - The language code specifying the desired language for the process description.
+ * @returns {Promise<Object>} - A promise that resolves with the fetched process data description.
+ * @throws {Error} - Throws an error if there's an issue with D-Bus communication or if the request fails.
+ */
+export async function refreshProcessDataDescription(moduleName, instanceName, objectName, language) {
+    const cacheKey = getCacheKey(moduleName, instanceName, objectName, language);
+    const processDescription = await fetchProcessDataDescription(moduleName, instanceName, objectName, language);
+    processDataDescriptionCache.set(cacheKey, processDescription);
+    processDataDescriptionGeneration++;
+    updateSharedDescription(cacheKey, processDescription);
+    await updateDescription(cacheKey, processDescription);
+    return processDescription;
+}
 
-        // Return the fetched process description.
-        return processDescription;
-    } else {
-        // Return the cached process description from the buffer.
-        return processDescriptionBuffer;
-    }
+/**
+ * Gets the generation of the cached process descriptions, it changes whenever a description is fetched again.
+ *
+ * @returns {number} - The generation of the cached process descriptions.
+ */
+export function getProcessDataDescriptionGeneration() {
+    return processDataDescriptionGeneration;
 }
 
 /**
- * Retrieves the process data description based on the given selector.
+ * Retrieves the process data description and the index of its process values based on the given selector.
+ * The index is built once per process description.
  *
  * @param {string} selector - The selector used to retrieve the process data description.
- * @returns {Promise<Object>} - A promise that resolves to the process data description.
+ * @returns {Promise<Object>} - A promise that resolves to the process data description, its index and the entry of the selected process value.
+ * @throws {Error} - Throws an error if the selector is invalid or the process value is not found in the process description.
  */
-export async function getProcessDataDescriptionBySelector(selector) {
+export async function getProcessValueEntryBySelector(selector) {
     const selectorDescription = getObjectFromUrl(selector);
-    return await getProcessDataDescription(
+    const processDescription = await getProcessDataDescription(
         selectorDescription.moduleName,
         selectorDescription.instanceName,
         selectorDescription.objectName,
         'us_EN'
     );
+    const index = getProcessDescriptionIndex(processDescription);
+    return { processDescription, index, entry: index.getEntry(selectorDescription.parameterPath) };
 }
@@ -0,0 +1,43 @@
+// String, Selection and Selector are NUL terminated inside of their size
+function decodeText(buf, offset, size) {
+    let end = offset;
+    while (end < offset + size && buf[end] !== 0) {
+        end++;
+    }
+    return buf.toString('utf8', offset, end);
+}
+
+// the raw bytes of a value are decoded like the native decoder of readMany does
+const rawValueDecoders = new Map([
+    ['Char', (buf, offset) => buf.readInt8(offset)],
+    ['UnsignedChar', (buf, offset) => buf.readUInt8(offset)],
+    ['ShortInteger', (buf, offset) => buf.readInt16LE(offset)],
+    ['UnsignedShortInteger', (buf, offset) => buf.readUInt16LE(offset)],
+    ['Integer', (buf, offset) => buf.readInt32LE(offset)],
+    ['UnsignedInteger', (buf, offset) => buf.readUInt32LE(offset)],
+    ['LongLong', (buf, offset) => buf.readBigInt64LE(offset)],
+    ['UnsignedLongLong', (buf, offset) => buf.readBigUInt64LE(offset)],
+    ['Double', (buf, offset) => buf.readDoubleLE(offset)],
+    ['Float', (buf, offset) => buf.readFloatLE(offset)],
+    ['Boolean', (buf, offset, size) => (size === 1 ? buf.readUInt8(offset) : buf.readUInt32LE(offset)) !== 0],
+    ['Bit', (buf, offset, size, bitMask) => (buf.readUInt8(offset) & bitMask) !== 0],
+    ['String', decodeText],
+    ['Selection', decodeText],
+    ['Selector', decodeText],
+]);
+
+/**
+ * Creates a function that decodes the raw bytes of a process value, e.g. out of a recording or a ring buffer.
+ *
+ * @param {string} type - The type of the process value.
+ * @param {number} size - The size of the value in bytes, used for Boolean and the string types.
+ * @param {number} bitMask - The bit mask of a value of the type Bit.
+ * @returns {Function} - Decodes the value at an offset of a Buffer, unknown types return the raw bytes.
+ */
+export function createRawValueDecoder(type, size, bitMask) {
+    const decode = rawValueDecoders.get(type);
+    if (decode === undefined) {
+        return (buf, offset) => buf.subarray(offset, offset + size);
+    }
+    return (buf, offset) => decode(buf, offset, size, bitMask);
+}
@@ -0,0 +1,86 @@
+import { createDescriptorTable } from './descriptorTable.js';
+import { groupByMemory, resolveValue } from './readProcessValues.js';
+
+// the native sampler needs at least 100 µs per sample
+const maxRateHz = 10000;
+
+/**
+ * Records process values with a fixed rate into a binary file, which can be read with readRecording.
+ * A native thread samples the values out of one consistent snapshot per period and a second native thread appends
+ * them to the file, so neither the event loop nor the garbage collector delays the sampling.
+ *
+ * @param {Array|String} selectors - The selector as string or an array of strings to record.
+ * @param {Object} options - The options of the recording.
+ * @param {string} options.file - The path of the file, an existing file is overwritten.
+ * @param {number} [options.rateHz=100] - The number of samples per second.
+ * @param {boolean} [options.deltaEncoding=false] - True to store the timestamps and the integer values as differences
+ *                                                  to their previous sample, which makes slowly changing values compact.
+ * @returns {Promise<Object>} - A promise that resolves with the recording, which can be stopped with stop() and
+ *                              queried with getStatistics().
+ * @throws {Error} - If a selector can't be resolved, the selectors are in different shared memories or the file can't be created.
+ *
+ * @example
+ *     const recording = await startRecording(['selector1', 'selector2'], { file: '/tmp/commissioning.rec', rateHz: 1000 });
+ *     // ...
+ *     console.log(recording.stop());
+ */
+export async function startRecording(selectors, { file, rateHz = 100, deltaEncoding = false } = {}) {
+    if (typeof file !== 'string') {
+        throw new Error('file is not a string');
+    }
+    if (typeof rateHz !== 'number' || !(rateHz > 0 && rateHz <= maxRateHz)) {
+        throw new Error(`rateHz is not a number between 0 and ${maxRateHz}`);
+    }
+
+    const resolvedValues = await resolveSelectors(Array.isArray(selectors) ? selectors : [selectors]);
+
+    // all values of a sample are taken out of one consistent snapshot
+    const groups = groupByMemory(resolvedValues);
+    if (groups.length !== 1) {
+        throw new Error('All process values of a recording have to be in the same shared memory');
+    }
+
+    const { memory } = groups[0];
+    const id = memory.startRecording(createDescriptorTable(resolvedValues), Math.round(1e6 / rateHz), file, deltaEncoding, createInfo(resolvedValues));
+
+    return {
+        file,
+        getStatistics: () => memory.getRecordingStatistics(id),
+        stop: () => memory.stopRecording(id),
+    };
+}
+
+/**
+ * Resolves the selectors of a recording.
+ *
+ * @param {Array<string>} selectors - The selectors to record.
+ * @returns {Promise<Array<Object>>} - A promise that resolves with the resolved process values.
+ * @throws {Error} - If a selector can't be resolved.
+ */
+async function resolveSelectors(selectors) {
+    const resolvedValues = [];
+    for (const selector of selectors) {
+        try {
+            resolvedValues.push(await resolveValue(selector));
+        } catch (e) {
+            throw new Error(`Can't record process value of ${selector}: ${e}`);
+        }
+    }
+    return resolvedValues;
+}
+
+/**
+ * Creates the info that is stored in the header of the recording, it describes the columns for the reader.
+ *
+ * @param {Array<Object>} resolvedValues - The resolved process values in the order of the columns.
+ * @returns {string} - The info as JSON.
+ */
+function createInfo(resolvedValues) {
+    const columns = resolvedValues.map(({ selector, valueDescription }) => ({
+        selector,
+        type: valueDescription.type,
+        // use POSIX language for unit because this is always available
+        unit: valueDescription.measurementRangeAttributes?.[0]?.unitText?.POSIX || '',
+    }));
+    return JSON.stringify({ columns });
+}
@@ -0,0 +1,157 @@
+import fs from 'fs';
+import { createRawValueDecoder } from './rawValue.js';
+
+// layout of the files written by the native recorder, see SharedMemoryRecorder.hpp
+const fileMagic = 'VTRNREC1';
+const blockMagic = 'VBLK';
+const deltaEncodingFlag = 1;
+const fixedHeaderSize = 24;
+const columnHeaderSize = 4;
+const blockHeaderSize = 12;
+const timestampSize = 8;
+
+const deltaEncoding = 1;
+
+/**
+ * Reads a file written by startRecording.
+ *
+ * @param {string} file - The path of the recording.
+ * @returns {Promise<Object>} - A promise that resolves with the period in ns, the info of the recording, the timestamps
+ *                              in ns since the epoch as BigInt64Array and the columns with the selector, type, unit and values.
+ * @throws {Error} - Throws an error if the file can't be read or is no recording.
+ *
+ * @description
+ * The reader has no dependency on the native module, so recordings can be analyzed on another machine.
+ * A block that was cut off, because the recording process was killed while writing it, is ignored.
+ */
+export async function readRecording(file) {
+    const buffer = await fs.promises.readFile(file);
+    const header = parseHeader(buffer);
+
+    const timestamps = [];
+    const columnValues = header.columns.map(() => []);
+    let position = header.size;
+    while (position + blockHeaderSize <= buffer.length) {
+        const block = parseBlock(buffer, position, header);
+        if (block === null) {
+            break;
+        }
+        timestamps.push(...block.timestamps);
+        block.columnValues.forEach((values, i) => columnValues[i].push(...values));
+        position = block.end;
+    }
+
+    return {
+        periodNs: header.periodNs,
+        deltaEncoding: header.deltaEncoding,
+        info: header.info,
+        timestamps: BigInt64Array.from(timestamps),
+        columns: header.columns.map((column, i) => ({ ...column.description, values: columnValues[i] })),
+    };
+}
+
+/**
+ * Parses the header of a recording.
+ *
+ * @param {Buffer} buffer - The content of the file.
+ * @returns {Object} - The size of the header, the flags, the period, the info and the columns.
+ * @throws {Error} - Throws an error if the file is no recording.
+ */
+function parseHeader(buffer) {
+    if (buffer.length < fixedHeaderSize || buffer.toString('latin1', 0, fileMagic.length) !== fileMagic) {
+        throw new Error('File is no recording of process values');
+    }
+    const flags = buffer.readUInt32LE(8);
+    const numberOfColumns = buffer.readUInt32LE(12);
+    const periodNs = Number(buffer.readBigUInt64LE(16));
+
+    let position = fixedHeaderSize;
+    const columns = [];
+    for (let i = 0; i < numberOfColumns; i++) {
+        columns.push({ encoding: buffer.readUInt8(position), bitMask: buffer.readUInt8(position + 1), width: buffer.readUInt16LE(position + 2) });
+        position += columnHeaderSize;
+    }
+
+    const infoLength = buffer.readUInt32LE(position);
+    const info = JSON.parse(buffer.toString('utf8', position + 4, position + 4 + infoLength));
+    columns.forEach((column, i) => {
+        column.description = info.columns?.[i] || {};
+        column.decode = createRawValueDecoder(column.description.type, column.width, column.bitMask);
+    });
+
+    return { size: position + 4 + infoLength, deltaEncoding: (flags & deltaEncodingFlag) !== 0, periodNs, info, columns };
+}
+
+/**
+ * Parses a block of records.
+ *
+ * @param {Buffer} buffer - The content of the file.
+ * @param {number} position - The position of the block in the file.
+ * @param {Object} header - The parsed header of the file.
+ * @returns {Object|null} - The end of the block, the timestamps and the values of each column or null if the block is cut off.
+ * @throws {Error} - Throws an error if there is no block at the position.
+ */
+function parseBlock(buffer, position, header) {
+    if (buffer.toString('latin1', position, position + blockMagic.length) !== blockMagic) {
+        throw new Error(`Invalid block at offset ${position} of recording`);
+    }
+    const numberOfRecords = buffer.readUInt32LE(position + 4);
+    const payloadLength = buffer.readUInt32LE(position + 8);
+    const end = position + blockHeaderSize + payloadLength;
+    if (end > buffer.length) {
+        return null;
+    }
+
+    const cursor = { buffer: buffer.subarray(position + blockHeaderSize, end), position: 0 };
+    const timestampColumn = { encoding: header.deltaEncoding ? deltaEncoding : 0, width: timestampSize, decode: (buf, offset) => buf.readBigInt64LE(offset) };
+    const timestamps = decodeColumn(cursor, timestampColumn, numberOfRecords);
+    const columnValues = header.columns.map(column => decodeColumn(cursor, column, numberOfRecords));
+    return { end, timestamps, columnValues };
+}
+
+/**
+ * Decodes the values of a column of a block.
+ *
+ * @param {Object} cursor - The payload of the block and the position of the column in it, the position is advanced.
+ * @param {Object} column - The encoding, width and decode function of the column.
+ * @param {number} numberOfRecords - The number of records in the block.
+ * @returns {Array} - The values of the column.
+ */
+function decodeColumn(cursor, column, numberOfRecords) {
+    const values = new Array(numberOfRecords);
+    if (column.encoding !== deltaEncoding) {
+        for (let i = 0; i < numberOfRecords; i++) {
+            values[i] = column.decode(cursor.buffer, cursor.position);
+            cursor.position += column.width;
+        }
+        return values;
+    }
+
+    // the differences are computed on the raw bytes, the sum is converted back into raw bytes to decode the value
+    const raw = Buffer.alloc(8);
+    let previous = 0n;
+    for (let i = 0; i < numberOfRecords; i++) {
+        previous = BigInt.asUintN(64, previous + readZigZagVarint(cursor));
+        raw.writeBigUInt64LE(previous);
+        values[i] = column.decode(raw, 0);
+    }
+    return values;
+}
+
+/**
+ * Reads a zigzag encoded varint.
+ *
+ * @param {Object} cursor - The buffer and the position of the varint, the position is advanced.
+ * @returns {bigint} - The signed value.
+ */
+function readZigZagVarint(cursor) {
+    let result = 0n;
+    let shift = 0n;
+    let byte;
+    do {
+        byte = cursor.buffer.readUInt8(cursor.position++);
+        result |= BigInt(byte & 0x7F) << shift;
+        shift += 7n;
+    } while (byte & 0x80);
+    return (result >> 1n) ^ -(result & 1n);
+}
@@ -0,0 +1,53 @@
+import { native } from './importShm.js';
+
+const { headOffset, tailOffset, wakeupOffset, droppedRecordsOffset, recordSizeOffset, capacityOffset, recordsOffset } = native.sampleRingLayout;
+const wordSize = Int32Array.BYTES_PER_ELEMENT;
+
+/**
+ * Creates the JS consumer of a native ring buffer, e.g. of the ring buffer of watchBatched.
+ *
+ * @param {ArrayBuffer} ring - The ring buffer, which is written by a native producer thread.
+ * @returns {Object} - The consumer with drain(onRecord) and getDroppedRecords().
+ *
+ * @description
+ * The indices are accessed with Atomics. N-API can't create a SharedArrayBuffer, so the ring buffer is an external
+ * ArrayBuffer backed by native memory, on which Atomics.load and Atomics.store work as well.
+ */
+export function createRingConsumer(ring) {
+    const words = new Int32Array(ring, 0, recordsOffset / wordSize);
+    const records = Buffer.from(ring);
+    const recordSize = Atomics.load(words, recordSizeOffset / wordSize);
+    const mask = Atomics.load(words, capacityOffset / wordSize) - 1;
+
+    return {
+        /**
+         * Passes all records of the ring buffer to onRecord and releases them afterwards.
+         *
+         * @param {Function} onRecord - Called with the Buffer of the ring buffer and the offset of a record, the
+         *                              record is only valid during the call.
+         * @returns {number} - The number of drained records.
+         */
+        drain(onRecord) {
+            // cleared before head is read, so records pushed after the read request a new wakeup
+            Atomics.store(words, wakeupOffset / wordSize, 0);
+
+            const head = Atomics.load(words, headOffset / wordSize);
+            let tail = Atomics.load(words, tailOffset / wordSize);
+            let numberOfRecords = 0;
+            while (tail !== head) {
+                onRecord(records, recordsOffset + (tail & mask) * recordSize);
+                // the indices are 32 bit counters that wrap around
+                tail = (tail + 1) | 0;
+                numberOfRecords++;
+            }
+
+            // the slots are released after all records have been passed on
+            Atomics.store(words, tailOffset / wordSize, tail);
+            return numberOfRecords;
+        },
+
+        getDroppedRecords() {
+            return Atomics.load(words, droppedRecordsOffset / wordSize) >>> 0;
+        },
+    };
+}
@@ -0,0 +1,88 @@
+import { native } from './importShm.js';
+
+// time after which a thread stops waiting for the description of another thread and fetches it itself
+const claimTimeoutMs = 30000;
+
+// threads waiting for a description claimed by another thread, by key
+const waiters = new Map();
+
+// notifies this thread when a description it waits for is published or released
+native.setSharedDescriptionListener(key => {
+    const resolvers = waiters.get(key);
+    waiters.delete(key);
+    resolvers?.forEach(resolve => resolve());
+});
+
+/**
+ * Waits until the claim on a description is published or released, or the timeout has passed.
+ *
+ * @param {string} key - The key of the process description.
+ * @param {number} timeoutMs - The time to wait at most.
+ * @returns {Promise<void>} - A promise that resolves when the thread should look up the description again.
+ */
+function waitForDescription(key, timeoutMs) {
+    return new Promise(resolve => {
+        // the timer keeps the event loop alive, the native listener doesn't
+        const timer = setTimeout(resolve, timeoutMs);
+        if (!waiters.has(key)) {
+            waiters.set(key, []);
+        }
+        waiters.get(key).push(() => {
+            clearTimeout(timer);
+            resolve();
+        });
+    });
+}
+
+/**
+ * Loads a process description once per process, shared by the main thread and all worker threads.
+ *
+ * @param {string} key - The key of the process description, containing module, instance, object and language.
+ * @param {Function} load - Loads the process description, if no other thread has it already.
+ * @returns {Promise<Object>} - A promise that resolves with the process description.
+ * @throws {Error} - Throws the error of load.
+ *
+ * @description
+ * The first thread that requests a description claims it and loads it, the other threads are notified when it is
+ * published. It is published even without worker threads, so workers started later don't fetch it again. The claim of
+ * a thread that fails or exits is released, so another thread takes over. Only the compact description is shared as
+ * JSON, every thread parses it and builds its own index.
+ */
+export async function loadSharedDescription(key, load) {
+    const deadline = Date.now() + claimTimeoutMs;
+    for (;;) {
+        // a claim that fails because another thread has it registers this thread for the notification, so it can't
+        // be missed between the claim and the wait
+        if (native.claimSharedDescription(key)) {
+            break;
+        }
+        const shared = native.getSharedDescription(key);
+        if (shared !== undefined) {
+            return JSON.parse(shared);
+        }
+        if (Date.now() >= deadline) {
+            // the claiming thread hangs, load it without sharing
+            return load();
+        }
+        await waitForDescription(key, deadline - Date.now());
+    }
+
+    try {
+        const description = await load();
+        native.publishSharedDescription(key, JSON.stringify(description));
+        return description;
+    } catch (error) {
+        native.releaseSharedDescription(key);
+        throw error;
+    }
+}
+
+/**
+ * Replaces a shared process description after it was fetched again, the other threads get it on their next load.
+ *
+ * @param {string} key - The key of the process description, containing module, instance, object and language.
+ * @param {Object} description - The process description fetched from the device.
+ */
+export function updateSharedDescription(key, description) {
+    native.publishSharedDescription(key, JSON.stringify(description));
+}
@@ -0,0 +1,95 @@
+import { getBufferType } from './bufferHandler.js';
+import { resolveValue } from './readProcessValues.js';
+
+// a decode that collides with the producer this often is not retried anymore
+const maxValidationRetries = 100;
+
+const textDecoder = new TextDecoder();
+
+/**
+ * Creates the read-only accessor of a mapping. The mapping is read-only, a write to its ArrayBuffer would terminate the
+ * process, so the ArrayBuffer and the DataView are never handed out. All numbers are little endian like the device.
+ *
+ * @param {DataView} dataView - The DataView over the mapping.
+ * @returns {Object} - The typed getters, they throw a RangeError outside of the shared memory.
+ */
+function createReader(dataView) {
+    return Object.freeze({
+        size: dataView.byteLength,
+        getInt8: offset => dataView.getInt8(offset),
+        getUint8: offset => dataView.getUint8(offset),
+        getInt16: offset => dataView.getInt16(offset, true),
+        getUint16: offset => dataView.getUint16(offset, true),
+        getInt32: offset => dataView.getInt32(offset, true),
+        getUint32: offset => dataView.getUint32(offset, true),
+        getBigInt64: offset => dataView.getBigInt64(offset, true),
+        getBigUint64: offset => dataView.getBigUint64(offset, true),
+        getFloat32: offset => dataView.getFloat32(offset, true),
+        getFloat64: offset => dataView.getFloat64(offset, true),
+        getString(offset, size) {
+            if (offset < 0 || size < 0 || offset + size > dataView.byteLength) {
+                throw new RangeError('Offset is outside the bounds of the shared memory');
+            }
+            // the text ends at the first NUL inside of its size
+            const bytes = new Uint8Array(dataView.buffer, offset, size);
+            const end = bytes.indexOf(0);
+            return textDecoder.decode(end === -1 ? bytes : bytes.subarray(0, end));
+        },
+    });
+}
+
+/**
+ * Zero-copy view of the shared memory containing a process value. The reader is backed directly by a read-only
+ * mapping of the shared memory, so decoding from it copies nothing.
+ */
+class SharedMemoryView {
+    #memory;
+    #reader;
+
+    constructor(memory, valueDescription) {
+        this.#memory = memory;
+        this.#reader = createReader(new DataView(memory.mapView()));
+        this.valueDescription = valueDescription;
+    }
+
+    /**
+     * Decodes data from the view and repeats the decode until it is consistent with the writes of the producer.
+     *
+     * @param {Function} decode - Called with the reader and the offset of the current buffer, returns the decoded data.
+     * @returns {*} - The result of the consistent decode.
+     * @throws {Error} - Throws an error with the code ERR_READ_TIMEOUT if no consistent decode was possible.
+     */
+    read(decode) {
+        for (let retry = 0; retry < maxValidationRetries; retry++) {
+            const version = this.#memory.snapshotVersion();
+            // the offset of the current buffer changes with the active half of a double buffer
+            const result = decode(this.#reader, this.#memory.currentBufferOffset());
+            if (this.#memory.validate(version)) {
+                return result;
+            }
+        }
+        throw Object.assign(new Error('The producer kept writing while decoding from the view'), { code: 'ERR_READ_TIMEOUT' });
+    }
+}
+
+/**
+ * Maps the shared memory containing a process value for zero-copy reads.
+ *
+ * @param {string} selector - The selector of a process value inside of the shared memory.
+ * @returns {Promise<SharedMemoryView>} - A promise that resolves with the view and the description of the process value.
+ * @throws {Error} - Throws an error if the selector can't be resolved, the shared memory is protected by a semaphore
+ *                   or can't be mapped.
+ *
+ * @example
+ * // Example usage:
+ * const view = await mapView('selector1');
+ * const value = view.read((reader, offset) => reader.getFloat32(offset + view.valueDescription.offsetSharedMemory));
+ */
+export async function mapView(selector) {
+    const { processDescription, valueDescription, memory } = await resolveValue(selector);
+    // without a sequence number a decode can't be validated against the writes of the producer
+    if (getBufferType(processDescription) === 'singleBufferSemaphore') {
+        throw new Error(`Can't map ${selector}: a singleBufferSemaphore can only be read with read() or compile()`);
+    }
+    return new SharedMemoryView(memory, valueDescription);
+}
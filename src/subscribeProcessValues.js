@@ -0,0 +1,100 @@
+import { createDescriptorTable } from './descriptorTable.js';
+import { native } from './importShm.js';
+import { createRawValueDecoder } from './rawValue.js';
+import { createDecodedResult, groupByMemory, resolveValue } from './readProcessValues.js';
+import { createRingConsumer } from './sampleRing.js';
+
+/**
+ * Subscribes to changes of process values.
+ * A native thread per shared memory compares the subscribed values and calls the callback only with the values that have changed.
+ * Buffers with a sequence number are only compared after the producer has written them, buffers protected by a
+ * semaphore are compared every minIntervalMs.
+ * The native thread pushes the changes into a ring buffer and wakes up JS once per batch, so a busy event loop gets
+ * all changes since its last wakeup in one call of the callback, in the order they were detected.
+ *
+ * @param {Array|String} selectors - The selector as string or an array of strings to subscribe to.
+ * @param {Function} callback - Called with an array of the changed process values, which have the same properties as the results of read.
+ * @param {Object} [options] - The options of the subscription.
+ * @param {number} [options.minIntervalMs=100] - The minimal interval between two checks of the values per shared memory.
+ * @param {number} [options.ringCapacity=1024] - The number of changes the ring buffer takes until JS drains it. If it
+ *                                               overflows, all values are delivered again.
+ * @param {Function} [options.onError] - Called with an exception thrown by the callback. Without it, the exception is
+ *                                       emitted as process warning. Further changes are delivered in both cases.
+ * @returns {Promise<Object>} - A promise that resolves with the subscription, which can be stopped with unsubscribe().
+ * @throws {Error} - If a selector can't be resolved.
+ *
+ * @example
+ *     const subscription = await subscribe(['selector1', 'selector2'], changes => console.log(changes));
+ *     subscription.unsubscribe();
+ */
+export async function subscribe(selectors, callback, { minIntervalMs = 100, ringCapacity = 1024, onError = null } = {}) {
+    if (!Array.isArray(selectors)) {
+        selectors = [selectors];
+    }
+    if (typeof callback !== 'function') {
+        throw new Error('callback is not a function');
+    }
+    if (onError !== null && typeof onError !== 'function') {
+        throw new Error('onError is not a function');
+    }
+
+    const resolvedValues = [];
+    for (const selector of selectors) {
+        try {
+            resolvedValues.push(await resolveValue(selector));
+        } catch (e) {
+            throw new Error(`Can't subscribe process value of ${selector}: ${e}`);
+        }
+    }
+
+    const watches = groupByMemory(resolvedValues).map(group => {
+        const descriptorTable = createDescriptorTable(group.entries.map(entry => entry.resolvedValue));
+        const decoders = group.entries.map(({ resolvedValue: { index, entry } }) => createRawValueDecoder(index.types[entry], index.sizes[entry], index.bitMasks[entry]));
+        let consumer = null;
+        const { id, ring } = group.memory.watchBatched(descriptorTable, minIntervalMs, ringCapacity, () => drainChanges(group, decoders, consumer, callback, onError));
+        consumer = createRingConsumer(ring);
+        return { memory: group.memory, id };
+    });
+
+    return {
+        unsubscribe() {
+            watches.forEach(({ memory, id }) => memory.unwatch(id));
+            watches.length = 0;
+        }
+    };
+}
+
+/**
+ * Drains the natively detected changes of a group out of its ring buffer, maps them to results and calls the callback.
+ *
+ * @param {Object} group - The shared memory and the resolved process values with their index.
+ * @param {Array<Function>} decoders - The decoders of the raw values of the group.
+ * @param {Object} consumer - The consumer of the ring buffer of the group.
+ * @param {Function} callback - The callback of the subscription.
+ * @param {Function|null} onError - Called with an exception of the callback.
+ */
+function drainChanges(group, decoders, consumer, callback, onError) {
+    const results = [];
+    consumer.drain((records, offset) => {
+        // a change record contains the index in the group with the flag for an error code, the error code and the raw value
+        const { changeRecordHeaderSize, changeRecordHasErrorCode } = native.sampleRingLayout;
+        const indexAndFlag = records.readUInt32LE(offset);
+        const index = (indexAndFlag & ~changeRecordHasErrorCode) >>> 0;
+        const value = decoders[index](records, offset + changeRecordHeaderSize);
+        const hasErrorCode = (indexAndFlag & changeRecordHasErrorCode) !== 0;
+        results.push(createDecodedResult(group.entries[index].resolvedValue, value, records.readUInt32LE(offset + 4), hasErrorCode));
+    });
+    if (results.length === 0) {
+        return;
+    }
+    try {
+        callback(results);
+    } catch (e) {
+        // an exception of the callback must not stop the delivery of further changes
+        if (onError !== null) {
+            onError(e);
+        } else {
+            process.emitWarning(`Subscription callback failed: ${e}`, { type: 'SubscriptionWarning', detail: e?.stack });
+        }
+    }
+}
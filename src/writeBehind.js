@@ -0,0 +1,187 @@
+import { getProcessDataDescriptionGeneration } from './providerHandler.js';
+import { resolveWriteTarget, validateValue, writeTargets, writeTargetsAsync } from './writeProcessValues.js';
+
+function createWriteError(selector, value, e) {
+    // keep the code of the native error, e.g. ERR_LOCK_TIMEOUT, like write() does
+    return Object.assign(new Error(`Can't write ${JSON.stringify({ selector, value })}: ${e}`, { cause: e }), { code: e.code });
+}
+
+/**
+ * Queue that coalesces high-frequency writes, e.g. of a slider, and writes them behind the caller.
+ * Only the last valid value of a selector within the window is written, all values of a shared memory are written
+ * with one semaphore acquisition.
+ */
+class WriteBehindQueue {
+    #windowMs;
+    #offThread;
+    // writes by selector, in the order of the calls, with the callbacks of each write
+    #pending = new Map();
+    // write targets by selector, so a repeated write doesn't look up the process description again
+    #targets = new Map();
+    // the write targets that are resolved already, to validate a value when it is written
+    #resolvedTargets = new Map();
+    // the generation of the process descriptions the targets were resolved from
+    #generation = getProcessDataDescriptionGeneration();
+    #timer = null;
+    #flushing = Promise.resolve();
+
+    constructor(windowMs, offThread) {
+        this.#windowMs = windowMs;
+        this.#offThread = offThread;
+    }
+
+    write(selector, value) {
+        this.#dropOutdatedTargets();
+        const target = this.#resolvedTargets.get(selector);
+        if (target !== undefined) {
+            // an invalid value is rejected right away and doesn't replace the queued value of the selector
+            try {
+                validateValue(target.valueDescription, value);
+            } catch (e) {
+                return Promise.reject(createWriteError(selector, value, e));
+            }
+        }
+
+        return new Promise((resolve, reject) => {
+            if (!this.#pending.has(selector)) {
+                this.#pending.set(selector, []);
+            }
+            this.#pending.get(selector).push({ value, resolve, reject });
+
+            if (this.#timer === null) {
+                this.#timer = setTimeout(() => this.flush(), this.#windowMs);
+            }
+        });
+    }
+
+    flush() {
+        clearTimeout(this.#timer);
+        this.#timer = null;
+        const batch = this.#pending;
+        this.#pending = new Map();
+
+        // flushes run one after another, so an older value never overwrites a newer one
+        this.#flushing = this.#flushing.then(() => this.#writeBatch(batch));
+        return this.#flushing;
+    }
+
+    async #writeBatch(batch) {
+        this.#dropOutdatedTargets();
+        const groups = new Map();
+        for (const [selector, writes] of batch) {
+            let target;
+            try {
+                target = await this.#getTarget(selector);
+            } catch (e) {
+                writes.forEach(({ value, reject }) => reject(createWriteError(selector, value, e)));
+                continue;
+            }
+
+            // values written before the target was resolved are validated here, each invalid one rejects only its caller
+            const validWrites = writes.filter(write => this.#validate(selector, target, write));
+            if (validWrites.length > 0) {
+                if (!groups.has(target.memory)) {
+                    groups.set(target.memory, []);
+                }
+                groups.get(target.memory).push({ selector, target, writes: validWrites, value: validWrites.at(-1).value });
+            }
+        }
+        await Promise.all([...groups].map(([memory, items]) => this.#writeGroup(memory, items)));
+    }
+
+    #validate(selector, target, { value, reject }) {
+        try {
+            validateValue(target.valueDescription, value);
+            return true;
+        } catch (e) {
+            reject(createWriteError(selector, value, e));
+            return false;
+        }
+    }
+
+    async #writeGroup(memory, items) {
+        const targets = items.map(({ target, value }) => ({ ...target, value }));
+        try {
+            await (this.#offThread ? writeTargetsAsync(memory, targets) : writeTargets(memory, targets));
+        } catch (e) {
+            for (const { selector, writes } of items) {
+                // resolve the selector again on the next write, e.g. after detachAll() closed the shared memory
+                this.#forgetTarget(selector);
+                writes.forEach(({ value, reject }) => reject(createWriteError(selector, value, e)));
+            }
+            return;
+        }
+        items.forEach(({ writes }) => writes.forEach(({ resolve }) => resolve({ done: true })));
+    }
+
+    #getTarget(selector) {
+        let target = this.#targets.get(selector);
+        if (target === undefined) {
+            const resolving = resolveWriteTarget(selector);
+            this.#targets.set(selector, resolving);
+            resolving.then(resolved => {
+                if (this.#targets.get(selector) === resolving) {
+                    this.#resolvedTargets.set(selector, resolved);
+                }
+            }, () => {
+                if (this.#targets.get(selector) === resolving) {
+                    this.#forgetTarget(selector);
+                }
+            });
+            target = resolving;
+        }
+        return target;
+    }
+
+    #forgetTarget(selector) {
+        this.#targets.delete(selector);
+        this.#resolvedTargets.delete(selector);
+    }
+
+    // a refreshed process description can move a process value, e.g. after a reconfiguration of the module
+    #dropOutdatedTargets() {
+        const generation = getProcessDataDescriptionGeneration();
+        if (generation !== this.#generation) {
+            this.#generation = generation;
+            this.#targets.clear();
+            this.#resolvedTargets.clear();
+        }
+    }
+}
+
+/**
+ * Creates a queue that writes values behind the caller and coalesces repeated writes to the same selector.
+ *
+ * @param {Object} [options] - The options of the queue.
+ * @param {number} [options.windowMs=20] - The time in milliseconds that writes are collected before they are written.
+ * @param {boolean} [options.offThread=true] - True to lock the semaphore and write on a thread of the libuv thread pool,
+ *                                             false to write on the event loop thread.
+ * @returns {Object} - The queue with the functions write(selector, value) and flush().
+ * @throws {Error} - Throws an error if windowMs is not a non-negative number.
+ *
+ * @description
+ * write(selector, value) returns a promise that resolves with { done: true } when the value, or a newer value of the
+ * same selector that replaced it within the window, has been written to the shared memory. It rejects if the value
+ * can't be written. An invalid value only rejects its own call, immediately once the selector was resolved by an
+ * earlier write, and never replaces a valid value of the same selector. The window starts with the first write after
+ * a flush. flush() writes all queued values immediately and returns a promise that resolves when they are written, it
+ * never rejects. The resolved selectors are dropped when a process description is fetched again, e.g. by
+ * refreshList({ revalidate: true }).
+ *
+ * @example
+ * // Example usage:
+ * const queue = createWriteBehindQueue({ windowMs: 50 });
+ * slider.on('input', value => queue.write('selector1', value).catch(console.error));
+ * slider.on('change', () => queue.flush());
+ */
+export function createWriteBehindQueue({ windowMs = 20, offThread = true } = {}) {
+    if (typeof windowMs !== 'number' || !(windowMs >= 0)) {
+        throw new Error('windowMs is not a non-negative number');
+    }
+
+    const queue = new WriteBehindQueue(windowMs, offThread);
+    return {
+        write: (selector, value) => queue.write(selector, value),
+        flush: () => queue.flush(),
+    };
+}
@@ -1,18 +1,23 @@
-import { attachToSharedMemory, getBufferType, getCurrentBufferStartAddress } from './bufferHandler.js';
-import { getNestedProcessValueDescription, getObjectFromUrl } from './processValueUrl.js';
-import { getProcessDataDescriptionBySelector } from './providerHandler.js';
+import { attachToSharedMemory, getBufferType, getSizeOfManagementBuffer } from './bufferHandler.js';
+import { native } from './importShm.js';
+import { getProcessValueEntryBySelector } from './providerHandler.js';
 
 /**
- * Writes values for the specified selectors using the writeValue function.
+ * Writes values for the specified selectors.
  *
  * @param {Array<Object>|Object} input - An array or a single object containing selector and value information.
+ * @param {Object} [options] - The options of the write.
+ * @param {boolean} [options.offThread=false] - True to lock the semaphore and write on a thread of the libuv thread pool,
+ *                                              e.g. if a producer holds it for a long time. False writes on the event
+ *                                              loop thread without a thread switch.
  * @returns {Promise<Array<Object>|Object>} - A promise that resolves with an array or a single object indicating the write status.
  * @throws {Error} - Throws an error if there is an issue during the write operation.
  *
  * @description
- * This asynchronous function writes values for the specified selectors using the writeValue function. It accepts either
- * an array or a single object as input. The function iterates through the input, writing values for each selector, and
- * collects the write status. If any issues occur during the write operation, an error is thrown with a descriptive message.
+ * This asynchronous function writes values for the specified selectors. It accepts either an array or a single object
+ * as input. All items are resolved and validated before the first value is written, then the values and their metadata
+ * are written with one semaphore acquisition per shared memory. If any issues occur during the write operation, an error
+ * is thrown with a descriptive message.
  *
  * @example
  * // Example usage with an array of objects:
@@ -37,25 +42,38 @@ import { getProcessDataDescriptionBySelector } from './providerHandler.js';
  *     // Handle the error...
  * }
  */
-export async function write(input) {
+export async function write(input, { offThread = false } = {}) {
     // wrap a single object in an array to work with the same code underneath
     if (!Array.isArray(input)) {
         input = [input];
     }
 
-    const results = [];
-    // Iterate through each item in the input and perform the write operation.
+    // resolve and validate all items before the first value is written
+    const groups = new Map();
     for (const item of input) {
         try {
-            await writeValue(item.selector, item.value);
-            results.push({
-                done: true,
-            });
+            const target = await prepareWriteValue(item.selector, item.value);
+            if (!groups.has(target.memory)) {
+                groups.set(target.memory, { item, targets: [] });
+            }
+            groups.get(target.memory).targets.push(target);
         } catch (e) {
             return Promise.reject(new Error(`Can't write ${JSON.stringify(item)}: ${e}`));
         }
     }
 
+    // all values and metadata of a shared memory are written while holding its semaphore once
+    for (const [memory, { item, targets }] of groups) {
+        try {
+            await (offThread ? writeTargetsAsync(memory, targets) : writeTargets(memory, targets));
+        } catch (e) {
+            // keep the code of the native error, e.g. ERR_LOCK_TIMEOUT, so callers can fail fast on it
+            return Promise.reject(Object.assign(new Error(`Can't write ${JSON.stringify(item)}: ${e}`, { cause: e }), { code: e.code }));
+        }
+    }
+
+    const results = input.map(() => ({ done: true }));
+
     // Return a single object if the input was a single object.
     if (results.length === 1) {
         return Promise.resolve(results[0]);
@@ -88,128 +106,192 @@ function checkIfBufferIsWriteable(processDescription) {
     }
 }
 
-async function writeValue(selector, value) {
+async function prepareWriteValue(selector, value) {
     validateInput(selector, value);
+    const target = await resolveWriteTarget(selector);
+    checkInputValueType(value, target.valueDescription);
+    return { ...target, value };
+}
 
-    // get process description via dbus
-    const processDescription = await getProcessDataDescriptionBySelector(selector);
-    const selectorDescription = getObjectFromUrl(selector);
-    const valueDescription = getNestedProcessValueDescription(processDescription, selectorDescription.parameterUrl);
+/**
+ * Resolves where the process value of a selector is written, independent of the value to write.
+ *
+ * @param {string} selector - The selector of the process value.
+ * @returns {Promise<Object>} - A promise that resolves with the attached shared memory, the value description and the start address of the current buffer.
+ * @throws {Error} - Throws an error if the selector can't be resolved or the process value can't be written.
+ */
+export async function resolveWriteTarget(selector) {
+    if (typeof selector !== 'string') {
+        throw new Error('selector is not a string');
+    }
+
+    // get process description via dbus and look up the process value in its index
+    const { processDescription, index, entry } = await getProcessValueEntryBySelector(selector);
+    const valueDescription = index.valueDescriptions[entry];
 
     // check if writing is possible
+    checkWriteable(processDescription, valueDescription);
+
+    // @todo: handle write of different buffer types if not blocked by checkIfBufferIsWriteable()
+    return { memory: attachToSharedMemory(processDescription), valueDescription, bufferStartAddress: getWriteBufferStartAddress(processDescription) };
+}
+
+/**
+ * Gets the start address of the current buffer of a writeable process value.
+ *
+ * @param {Object} processDescription - The process description of the instance containing the process value.
+ * @returns {number} - The start address of the current buffer relative to the shared memory.
+ */
+export function getWriteBufferStartAddress(processDescription) {
+    // writeable buffers have no alternating halves, the current buffer starts behind the management buffer
+    return getSizeOfManagementBuffer(getBufferType(processDescription));
+}
+
+/**
+ * Checks if a process value can be written at all, independent of the value to write.
+ *
+ * @param {Object} processDescription - The process description of the instance containing the process value.
+ * @param {Object} valueDescription - The description of the process value.
+ * @throws {Error} - Throws an error if the process value is read-only or inside of a buffer that is not writeable.
+ */
+export function checkWriteable(processDescription, valueDescription) {
     checkReadOnly(valueDescription);
-    checkInputValueType(value, valueDescription);
     checkIfBufferIsWriteable(processDescription);
+}
 
-    // attach to shared memory and read the content
-    const memory = attachToSharedMemory(processDescription);
-    const dataBuffer = memory.buffer;
+/**
+ * Validates a value against the description of a process value before it is written.
+ *
+ * @param {Object} valueDescription - The description of the process value.
+ * @param {string|number|boolean} value - The value to be written.
+ * @throws {Error} - Throws an error if the value is not a string, number or boolean or does not match the type of the process value.
+ */
+export function validateValue(valueDescription, value) {
+    if (typeof value !== 'string' && typeof value !== 'number' && typeof value !== 'boolean') {
+        throw new Error('value is not a string, number or boolean');
+    }
+    checkInputValueType(value, valueDescription);
+}
 
-    // write the value based on type and description
-    const bufferStartAddress = getCurrentBufferStartAddress(processDescription, dataBuffer);
-    // @todo: handle write of different buffer types if not blocked by checkIfBufferIsWriteable()
-    writeProcessValue(valueDescription, value, memory, bufferStartAddress);
+/**
+ * Writes validated values of the same shared memory and resets the error codes in their metadata.
+ * A single value is encoded natively without temporary objects, many values are written with one semaphore acquisition.
+ *
+ * @param {Object} memory - The attached shared memory.
+ * @param {Array<Object>} targets - The value descriptions, the start addresses of the current buffer and the values to write.
+ * @throws {Error} - Throws an error if a value can't be written. No value is written in that case.
+ */
+export function writeTargets(memory, targets) {
+    if (targets.length === 1) {
+        const { valueDescription, bufferStartAddress, value } = targets[0];
+        writeResolvedValue(valueDescription, memory, bufferStartAddress, value);
+        return;
+    }
+    memory.writeMany(targets.flatMap(target => createWriteOperations(target.valueDescription, target.bufferStartAddress, target.value)));
+}
+
+/**
+ * Writes validated values of the same shared memory like writeTargets, but the semaphore is locked and the values are
+ * written on a thread of the libuv thread pool. The values are encoded before, so no value is written if one is invalid.
+ *
+ * @param {Object} memory - The attached shared memory.
+ * @param {Array<Object>} targets - The value descriptions, the start addresses of the current buffer and the values to write.
+ * @returns {Promise<void>} - A promise that resolves when the values are written.
+ * @throws {Error} - Throws an error if a value can't be written. No value is written in that case.
+ */
+export function writeTargetsAsync(memory, targets) {
+    return memory.writeManyAsync(targets.flatMap(target => createWriteOperations(target.valueDescription, target.bufferStartAddress, target.value)));
+}
+
+/**
+ * Writes a validated value of an already resolved process value and resets the error code in its metadata.
+ *
+ * @param {Object} valueDescription - The description of the process value.
+ * @param {Object} memory - The attached shared memory.
+ * @param {number} bufferStartAddress - The starting address within the shared memory buffer.
+ * @param {string|number|boolean} value - The value to be written.
+ */
+export function writeResolvedValue(valueDescription, memory, bufferStartAddress, value) {
+    const type = getWriteType(valueDescription);
+    const sizeMetadata = supportedMetadataSizes.includes(valueDescription.sizeMetadata) ? valueDescription.sizeMetadata : 0;
+    const offsetMetadata = bufferStartAddress + valueDescription.offsetSharedMemory + valueDescription.relativeOffsetMetadata;
+
+    // the native side resets the metadata to error code 0 and state 0 while it holds the semaphore for the value
+    memory.writeTyped(type, bufferStartAddress + valueDescription.offsetSharedMemory, value, valueDescription.sizeValue,
+        valueDescription.bitMask, sizeMetadata > 0 ? offsetMetadata : 0, sizeMetadata);
+}
+
+/**
+ * Creates the entries for the native writeMany to write a value and to reset the error code in its metadata.
+ *
+ * @param {Object} valueDescription - The description of the process value.
+ * @param {number} bufferStartAddress - The starting address within the shared memory buffer.
+ * @param {string|number|boolean} value - The value to be written.
+ * @returns {Array<Object>} - The entries with the offset relative to the shared memory, the type code, the size and the value.
+ * @throws {Error} - Throws an error if the type of the process value can't be written.
+ *
+ * @example
+ * // Example usage:
+ * const valueDescription = { type: 'Integer', offsetSharedMemory: 0, sizeValue: 4, sizeMetadata: 0 };
+ * memory.writeMany(createWriteOperations(valueDescription, 0, 42));
+ */
+export function createWriteOperations(valueDescription, bufferStartAddress, value) {
+    const operations = [{
+        offset: bufferStartAddress + valueDescription.offsetSharedMemory,
+        type: getWriteType(valueDescription),
+        size: valueDescription.sizeValue,
+        bitMask: valueDescription.bitMask,
+        value
+    }];
 
     // write error code 0 after successfull writing
     const errorCode = 0;
-    writeErrorCodeToMetaData(valueDescription, memory, errorCode);
+    operations.push(...createMetadataOperations(valueDescription, bufferStartAddress, errorCode));
+    return operations;
 }
 
-function writeErrorCodeToMetaData(valueDescription, memory, errorCode) {
-    const offsetMetadata = valueDescription.offsetSharedMemory + valueDescription.relativeOffsetMetadata;
+// types that are not written yet
+const unhandledTypes = ['String', 'Selection', 'Selector'];
+
+// 8: 32-bit error code and 32-bit state, 3: 1 byte error and 2 bytes state, 4: legacy 32-bit error code
+const supportedMetadataSizes = [8, 3, 4];
+
+function getWriteType(valueDescription) {
+    const type = native.valueTypes[valueDescription.type];
+    if (type === undefined) {
+        throw new Error(`Unknown value type: ${valueDescription.type}`);
+    }
+    if (unhandledTypes.includes(valueDescription.type)) {
+        throw new Error(`Unhandled value type: ${valueDescription.type}`);
+    }
+    return type;
+}
+
+function createMetadataOperations(valueDescription, bufferStartAddress, errorCode) {
+    const offsetMetadata = bufferStartAddress + valueDescription.offsetSharedMemory + valueDescription.relativeOffsetMetadata;
     const sizeMetadata = valueDescription.sizeMetadata;
     const supportedSizeMetaData = 8; // standard case: metadata containing a 32-bit error code and a 32-bit state
     const reducedSizeMetaData = 3; // reduced size of metadata containing 1 byte for error and 2 bytes for state
     const legacySizeMetaData = 4; // legacy case: Only Error code as 32-bit integer without state information (Jupiter Version < 9)
+    const { Integer, UnsignedChar, UnsignedShortInteger } = native.valueTypes;
 
     if (sizeMetadata === supportedSizeMetaData) {
         // For standard metadata, write the error code as a 32-bit integer and set state to 0 (ignoring state for now).
-        const metadataValue = Buffer.alloc(8); // 8 bytes for error code and state (ignoring state for now)
-        metadataValue.writeInt32LE(errorCode);
-        metadataValue.writeInt32LE(0, 4); // Write state (4 bytes) as 0, ignoring state for now
-        memory.write(metadataValue, offsetMetadata, sizeMetadata);
+        return [
+            { offset: offsetMetadata, type: Integer, value: errorCode },
+            { offset: offsetMetadata + 4, type: Integer, value: 0 }
+        ];
     } else if (sizeMetadata === reducedSizeMetaData) {
         // For reduced size metadata, write the error code as a single byte and set state to 0.
-        memory.writeUInt8(errorCode, offsetMetadata); // Write error code (1 byte)
-        memory.writeUInt16LE(0, offsetMetadata + 1); // Write state (2 bytes) as 0
+        return [
+            { offset: offsetMetadata, type: UnsignedChar, value: errorCode },
+            { offset: offsetMetadata + 1, type: UnsignedShortInteger, value: 0 }
+        ];
     } else if (sizeMetadata === legacySizeMetaData) {
         // For legacy size metadata, write the error code as a 32-bit integer without state information.
-        const metadataValue = Buffer.alloc(4);
-        metadataValue.writeInt32LE(errorCode);
-        memory.write(metadataValue, offsetMetadata, sizeMetadata);
-    }
-}
-
-/**
- * Writes the specified value to the shared memory based on the given value description.
- *
- * @param {Object} valueDescription - The description of the process value.
- * @param {string|number|boolean} value - The value to be written to the process value.
- * @param {Buffer} memory - The shared memory buffer.
- * @param {number} bufferStartAddress - The starting address within the shared memory buffer.
- * @returns {void}
- *
- * @description
- * This function writes the specified value to the shared memory based on the provided value description. It supports
- * various data types, including integers, floating-point numbers, boolean, and bit values. The function utilizes a
- * type map to determine the size and appropriate write function for each data type, and then performs the actual
- * writing to the shared memory buffer. If the value type is not recognized or handled, an error is thrown. The
- * function is typically called after validating input parameters and before updating metadata.
- *
- * @example
- * // Example usage:
- * const valueDescription = { type: 'Integer', offsetSharedMemory: 0, sizeValue: 4 };
- * const memory = // ... obtain shared memory buffer
- * const bufferStartAddress = 0;
- * const value = 42;
- * writeProcessValue(valueDescription, value, memory, bufferStartAddress);
- */
-function writeProcessValue(valueDescription, value, memory, bufferStartAddress) {
-    const offsetOfValue = valueDescription.offsetSharedMemory;
-
-    if (bufferStartAddress + offsetOfValue >= memory.length) {
-        throw new Error(`Offset ${bufferStartAddress + offsetOfValue} for value is out of range for buffer of size ${memory.length}`);
-    }
-
-    // Type map to determine size and write function for each data type.
-    const typeMap = {
-        'Char': { size: 1, writeFn: 'writeInt8' },
-        'UnsignedChar': { size: 1, writeFn: 'writeUInt8' },
-        'ShortInteger': { size: 2, writeFn: 'writeInt16LE' },
-        'UnsignedShortInteger': { size: 2, writeFn: 'writeUInt16LE' },
-        'Integer': { size: 4, writeFn: 'writeInt32LE' },
-        'UnsignedInteger': { size: 4, writeFn: 'writeUInt32LE' },
-        'LongLong': { size: 8, writeFn: 'writeBigInt64LE' },
-        'UnsignedLongLong': { size: 8, writeFn: 'writeUBigInt64LE' },
-        'Double': { size: 8, writeFn: 'writeDoubleLE' },
-        'Float': { size: 4, writeFn: 'writeFloatLE' },
-        'Boolean': { size: valueDescription.sizeValue, writeFn: valueDescription.sizeValue === 1 ? 'writeUInt8' : 'writeUInt32LE' },
-        'Bit': { size: 1, writeFn: 'writeByte' },
-        'String': { size: null, writeFn: null },
-        'Selection': { size: null, writeFn: null },
-        'Selector': { size: null, writeFn: null }
-    };
-
-    const typeInfo = typeMap[valueDescription.type];
-    if (typeInfo) {
-        if (typeInfo.size) {
-            if (typeInfo.writeFn === 'writeByte') {
-                //console.log(`WriteByte() ${value} startAddress: ${bufferStartAddress}, offset: ${offsetOfValue}, bitMask: ${valueDescription.bitMask}`);
-                // special handling for Bit
-                memory.writeByte(valueDescription.bitMask, value, bufferStartAddress + offsetOfValue);
-            } else {
-                // Allocate a buffer for the value and write it to the shared memory.
-                const buffer = Buffer.alloc(typeInfo.size);
-                buffer[typeInfo.writeFn](value);
-                //console.log(`Writing ${value} startAddress: ${bufferStartAddress}, offset ${offsetOfValue} with size ${typeInfo.size}`);
-                memory.write(buffer, bufferStartAddress + offsetOfValue, typeInfo.size);
-            }
-        } else {
-            throw new Error(`Unhandled value type: ${valueDescription.type}`);
-        }
-    } else {
-        throw new Error(`Unknown value type: ${valueDescription.type}`);
+        return [{ offset: offsetMetadata, type: Integer, value: errorCode }];
     }
+    return [];
 }
 
 /**
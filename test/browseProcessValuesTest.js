@@ -122,6 +122,106 @@ describe('getList function', async function () {
         expect(result2).to.deep.equal(expected);
     });
 
+    it('should keep the order of the instances and limit the requests when browsing in parallel', async function () {
+        const instanceNames = ['Instance1', 'Instance2', 'Instance3', 'Instance4', 'Instance5'];
+        let requestsInFlight = 0;
+        let maxRequestsInFlight = 0;
+
+        td.when(this.systemInformationManager.getRegisteredProvidersList('us_EN', 'ProcessData')).thenResolve([{ moduleName: 'Module1', objectName: 'Object1' }]);
+        td.when(this.systemInformationManager.getListOfInstances('Module1', 'Object1', 'us_EN')).thenResolve([
+            { moduleName: 'Module1', instanceName: 'Instance1', objectName: 'Object1' },
+            { substructure: instanceNames.slice(1, 4).map(instanceName => ({ moduleName: 'Module1', instanceName, objectName: 'Object1' })) },
+            { moduleName: 'Module1', instanceName: 'Instance5', objectName: 'Object1' },
+        ]);
+        for (const [index, instanceName] of instanceNames.entries()) {
+            td.when(this.providerHandler.getProcessDataDescription('Module1', instanceName, 'Object1', 'us_EN')).thenDo(async () => {
+                requestsInFlight++;
+                maxRequestsInFlight = Math.max(maxRequestsInFlight, requestsInFlight);
+                // the first instances answer last
+                await new Promise(resolve => setTimeout(resolve, (instanceNames.length - index) * 5));
+                requestsInFlight--;
+                return { type: 'TreeNode', value: { SomeThing: { offsetSharedMemory: 0, readOnly: false, type: 'Boolean', labelText: instanceName } } };
+            });
+        }
+
+        const result = await this.subject.getList({ concurrency: 2 });
+
+        expect(result[0].instances.map(instance => instance.name)).to.deep.equal(instanceNames);
+        expect(maxRequestsInFlight).to.equal(2);
+    });
+
+    it('should fetch only new instances and report the delta on refresh', async function () {
+        const createProcessData = labelText => ({
+            type: 'TreeNode',
+            value: { SomeThing: { offsetSharedMemory: 0, readOnly: false, type: 'Boolean', labelText } },
+        });
+        const instance1 = { moduleName: 'Module1', instanceName: 'Instance1', objectName: 'Object1' };
+        const instance2 = { moduleName: 'Module1', instanceName: 'Instance2', objectName: 'Object1' };
+
+        td.when(this.systemInformationManager.getRegisteredProvidersList('us_EN', 'ProcessData')).thenResolve([{ moduleName: 'Module1', objectName: 'Object1' }]);
+        td.when(this.systemInformationManager.getListOfInstances('Module1', 'Object1', 'us_EN')).thenResolve([instance1]);
+        td.when(this.providerHandler.getProcessDataDescription('Module1', 'Instance1', 'Object1', 'us_EN')).thenResolve(createProcessData('SomeThing'));
+        await this.subject.getList();
+
+        // a new instance appears, the known instance must not be fetched again
+        td.when(this.systemInformationManager.getListOfInstances('Module1', 'Object1', 'us_EN')).thenResolve([instance1, instance2]);
+        td.when(this.providerHandler.getProcessDataDescription('Module1', 'Instance1', 'Object1', 'us_EN')).thenDo(() => { assert.fail('the known instance should not be fetched again'); });
+        td.when(this.providerHandler.refreshProcessDataDescription('Module1', 'Instance2', 'Object1', 'us_EN')).thenResolve(createProcessData('Other'));
+        const refresh = await this.subject.refreshList();
+
+        expect(refresh.generation).to.equal(2);
+        expect(refresh.added).to.deep.equal(['ProcessData#Module1#Object1#Instance2#SomeThing']);
+        expect(refresh.removed).to.deep.equal([]);
+        expect(refresh.changed).to.deep.equal([]);
+        expect(refresh.list[0].instances.map(instance => instance.name)).to.deep.equal(['Instance1', 'Instance2']);
+        expect(await this.subject.getList()).to.equal(refresh.list);
+
+        // the first instance changes and the second is removed
+        td.when(this.systemInformationManager.getListOfInstances('Module1', 'Object1', 'us_EN')).thenResolve([instance1]);
+        td.when(this.providerHandler.refreshProcessDataDescription('Module1', 'Instance1', 'Object1', 'us_EN')).thenResolve(createProcessData('Renamed'));
+        const revalidation = await this.subject.refreshList({ revalidate: true });
+
+        expect(revalidation.added).to.deep.equal([]);
+        expect(revalidation.removed).to.deep.equal(['ProcessData#Module1#Object1#Instance2#SomeThing']);
+        expect(revalidation.changed).to.deep.equal(['ProcessData#Module1#Object1#Instance1#SomeThing']);
+    });
+
+    it('should stream the instances with the filtered process values', async function () {
+        const mockProcessData = {
+            type: 'TreeNode',
+            value: {
+                Input: { offsetSharedMemory: 0, readOnly: true, type: 'Float', labelText: 'Input' },
+                Output: { offsetSharedMemory: 4, readOnly: false, type: 'Float', labelText: 'Output' },
+                Flag: { offsetSharedMemory: 8, readOnly: false, type: 'Boolean', labelText: 'Flag' },
+            },
+        };
+
+        td.when(this.systemInformationManager.getRegisteredProvidersList('us_EN', 'ProcessData')).thenResolve([{ moduleName: 'Module1', objectName: 'Object1' }, { moduleName: 'Module2', objectName: 'Object2' }]);
+        td.when(this.systemInformationManager.getListOfInstances('Module1', 'Object1', 'us_EN')).thenResolve([{ moduleName: 'Module1', instanceName: 'Instance1', objectName: 'Object1' }]);
+        td.when(this.systemInformationManager.getListOfInstances('Module2', 'Object2', 'us_EN')).thenDo(() => { assert.fail('Module2 should not be browsed'); });
+        td.when(this.providerHandler.getProcessDataDescription('Module1', 'Instance1', 'Object1', 'us_EN')).thenResolve(mockProcessData);
+
+        const instances = [];
+        for await (const instance of this.subject.browse({ moduleName: 'Module1', type: 'Float', writable: true })) {
+            instances.push(instance);
+        }
+
+        expect(instances).to.deep.equal([{
+            moduleName: 'Module1',
+            objectName: 'Object1',
+            name: 'Instance1',
+            values: {
+                Output: {
+                    name: 'Output',
+                    readOnly: false,
+                    selector: 'ProcessData#Module1#Object1#Instance1#Output',
+                    type: 'Float',
+                    unit: '',
+                },
+            },
+        }]);
+    });
+
     it('should resolve with real test data', async function () {
         // Mocking the necessary functions from systemInformationManager
         const mockProvidersList = [
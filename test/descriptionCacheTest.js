@@ -0,0 +1,199 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import * as td from 'testdouble';
+import { expect } from 'chai';
+import { setDescriptionCacheFile, loadDescription } from '../src/descriptionCache.js';
+
+// shared memories created by the tests, named like the ones of the process value providers
+const sharedMemoryPrefix = `descriptionCacheTest${process.pid}`;
+
+function createDescription(key, { offsetSharedMemory = 0, sizeOfSharedMemory = 16, cpveVersion = '1.0' } = {}) {
+    return {
+        key: `${sharedMemoryPrefix}${key}`,
+        sizeOfSharedMemory,
+        offsetSharedMemory,
+        cpveVersion,
+        type: 'TreeNode',
+        value: {},
+    };
+}
+
+function createSharedMemory(description, size = description.sizeOfSharedMemory) {
+    fs.writeFileSync(path.join('/dev/shm', `${description.key}SharedMemory`), Buffer.alloc(size));
+}
+
+function writeCacheFile(file, descriptions, { cpveVersion = '1.0', format = 1 } = {}) {
+    fs.writeFileSync(file, JSON.stringify({ format, cpveVersion, descriptions }));
+}
+
+function callCount(fake) {
+    return td.explain(fake).callCount;
+}
+
+describe('descriptionCache', function () {
+    const key1 = 'Module1#Instance1#Object1#us_EN';
+    const key2 = 'Module1#Instance2#Object1#us_EN';
+    const key3 = 'Module2#Instance1#Object1#us_EN';
+
+    beforeEach(function () {
+        this.directory = fs.mkdtempSync(path.join(os.tmpdir(), 'descriptionCacheTest'));
+        this.file = path.join(this.directory, 'descriptions.json');
+        this.description1 = createDescription('Instance1');
+        this.description2 = createDescription('Instance2');
+        this.description3 = createDescription('Module2');
+        [this.description1, this.description2, this.description3].forEach(description => createSharedMemory(description));
+        this.fetch = td.func('fetchDescription');
+        setDescriptionCacheFile(this.file);
+    });
+
+    afterEach(function () {
+        td.reset();
+        setDescriptionCacheFile(null);
+        fs.readdirSync('/dev/shm')
+            .filter(name => name.startsWith(sharedMemoryPrefix))
+            .forEach(name => fs.rmSync(path.join('/dev/shm', name)));
+        fs.rmSync(this.directory, { recursive: true, force: true });
+    });
+
+    it('should fetch the description when no cache file is set', async function () {
+        setDescriptionCacheFile(null);
+        td.when(this.fetch()).thenResolve(this.description1);
+
+        const result = await loadDescription(key1, this.fetch);
+
+        expect(result).to.deep.equal(this.description1);
+        expect(fs.existsSync(this.file)).to.be.false;
+    });
+
+    it('should throw if the cache file is neither a string nor null', function () {
+        expect(() => setDescriptionCacheFile(42)).to.throw('file is neither a string nor null');
+    });
+
+    it('should load the persisted descriptions of a module after its first description was revalidated', async function () {
+        writeCacheFile(this.file, { [key1]: this.description1, [key2]: this.description2 });
+        td.when(this.fetch()).thenResolve(this.description1);
+
+        // the first description of the module is always fetched
+        expect(await loadDescription(key1, this.fetch)).to.deep.equal(this.description1);
+        expect(callCount(this.fetch)).to.equal(1);
+
+        // it equals its persisted copy, so the other description of the module is taken from the file
+        expect(await loadDescription(key2, this.fetch)).to.deep.equal(this.description2);
+        expect(callCount(this.fetch)).to.equal(1);
+    });
+
+    it('should discard the persisted descriptions of a reconfigured module', async function () {
+        writeCacheFile(this.file, { [key1]: this.description1, [key2]: this.description2, [key3]: this.description3 });
+        const reconfigured1 = createDescription('Instance1', { offsetSharedMemory: 8 });
+        const reconfigured2 = createDescription('Instance2', { offsetSharedMemory: 8 });
+        const fetch1 = td.func('fetchDescription1');
+        const fetch2 = td.func('fetchDescription2');
+        const fetch3 = td.func('fetchDescription3');
+        td.when(fetch1()).thenResolve(reconfigured1);
+        td.when(fetch2()).thenResolve(reconfigured2);
+        td.when(fetch3()).thenResolve(this.description3);
+
+        expect(await loadDescription(key1, fetch1)).to.deep.equal(reconfigured1);
+        // the persisted offset of the second instance is stale, it is fetched again
+        expect(await loadDescription(key2, fetch2)).to.deep.equal(reconfigured2);
+        expect(callCount(fetch2)).to.equal(1);
+
+        // the other module is revalidated on its own
+        expect(await loadDescription(key3, fetch3)).to.deep.equal(this.description3);
+        expect(callCount(fetch3)).to.equal(1);
+    });
+
+    it('should revalidate the module again while it has no persisted copy to compare', async function () {
+        writeCacheFile(this.file, { [key2]: this.description2 });
+        td.when(this.fetch()).thenResolve(this.description1);
+        const fetch2 = td.func('fetchDescription2');
+        td.when(fetch2()).thenResolve(this.description2);
+
+        await loadDescription(key1, this.fetch);
+        expect(await loadDescription(key2, fetch2)).to.deep.equal(this.description2);
+
+        // the description of the second instance revalidated the module
+        expect(callCount(fetch2)).to.equal(1);
+    });
+
+    it('should revalidate a module only once when its descriptions are loaded in parallel', async function () {
+        writeCacheFile(this.file, { [key1]: this.description1, [key2]: this.description2 });
+        td.when(this.fetch()).thenResolve(this.description1);
+        const fetch2 = td.func('fetchDescription2');
+        td.when(fetch2()).thenResolve(this.description2);
+
+        const results = await Promise.all([loadDescription(key1, this.fetch), loadDescription(key2, fetch2)]);
+
+        expect(results).to.deep.equal([this.description1, this.description2]);
+        expect(callCount(this.fetch)).to.equal(1);
+        expect(callCount(fetch2)).to.equal(0);
+    });
+
+    it('should discard all persisted descriptions on another cpveVersion', async function () {
+        writeCacheFile(this.file, { [key1]: this.description1, [key2]: this.description2 });
+        const updated1 = createDescription('Instance1', { cpveVersion: '2.0' });
+        const updated2 = createDescription('Instance2', { cpveVersion: '2.0' });
+        td.when(this.fetch()).thenResolve(updated1);
+        const fetch2 = td.func('fetchDescription2');
+        td.when(fetch2()).thenResolve(updated2);
+
+        await loadDescription(key1, this.fetch);
+        expect(await loadDescription(key2, fetch2)).to.deep.equal(updated2);
+
+        expect(callCount(fetch2)).to.equal(1);
+    });
+
+    it('should fetch a persisted description whose shared memory is missing or too small', async function () {
+        const description4 = createDescription('Instance4');
+        const key4 = 'Module1#Instance4#Object1#us_EN';
+        writeCacheFile(this.file, { [key1]: this.description1, [key2]: this.description2, [key4]: description4 });
+        fs.rmSync(path.join('/dev/shm', `${this.description2.key}SharedMemory`));
+        createSharedMemory(description4, description4.sizeOfSharedMemory - 1);
+        td.when(this.fetch()).thenResolve(this.description1);
+        const fetch2 = td.func('fetchDescription2');
+        td.when(fetch2()).thenResolve(this.description2);
+        const fetch4 = td.func('fetchDescription4');
+        td.when(fetch4()).thenResolve(description4);
+
+        await loadDescription(key1, this.fetch);
+        await loadDescription(key2, fetch2);
+        await loadDescription(key4, fetch4);
+
+        expect(callCount(fetch2)).to.equal(1);
+        expect(callCount(fetch4)).to.equal(1);
+    });
+
+    it('should ignore a cache file with another format', async function () {
+        writeCacheFile(this.file, { [key1]: this.description1, [key2]: this.description2 }, { format: 0 });
+        td.when(this.fetch()).thenResolve(this.description1);
+        const fetch2 = td.func('fetchDescription2');
+        td.when(fetch2()).thenResolve(this.description2);
+
+        await loadDescription(key1, this.fetch);
+        await loadDescription(key2, fetch2);
+
+        expect(callCount(fetch2)).to.equal(1);
+    });
+
+    it('should write the fetched descriptions to the cache file without leaving a temporary file', async function () {
+        this.timeout(5000);
+        writeCacheFile(this.file, { [key3]: this.description3 });
+        td.when(this.fetch()).thenResolve(this.description1);
+        const fetch2 = td.func('fetchDescription2');
+        td.when(fetch2()).thenResolve(this.description2);
+
+        await loadDescription(key1, this.fetch);
+        await loadDescription(key2, fetch2);
+        // the descriptions of a browse are collected into one write
+        await new Promise(resolve => setTimeout(resolve, 1500));
+
+        const content = JSON.parse(fs.readFileSync(this.file, 'utf8'));
+        expect(content).to.deep.equal({
+            format: 1,
+            cpveVersion: '1.0',
+            descriptions: { [key3]: this.description3, [key1]: this.description1, [key2]: this.description2 },
+        });
+        expect(fs.readdirSync(this.directory)).to.deep.equal(['descriptions.json']);
+    });
+});
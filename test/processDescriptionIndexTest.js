@@ -0,0 +1,85 @@
+import { expect } from 'chai';
+import { ProcessDescriptionIndex, getProcessDescriptionIndex } from '../src/processDescriptionIndex.js';
+
+describe('ProcessDescriptionIndex class', function () {
+    beforeEach(function () {
+        this.processDescription = {
+            type: 'TreeNode',
+            key: 'Module1Instance1',
+            sizeOfSharedMemory: 256,
+            value: {
+                Temperature: { offsetSharedMemory: 0, type: 'Double', sizeValue: 8, relativeOffsetMetadata: 8, sizeMetadata: 4, readOnly: true, labelText: 'Temperature' },
+                Outputs: {
+                    type: 'TreeNode',
+                    value: {
+                        Relay1: { offsetSharedMemory: 16, type: 'Bit', sizeValue: 1, bitMask: 1, readOnly: false, labelText: 'Relay 1' },
+                        Relay2: { offsetSharedMemory: 16, type: 'Bit', sizeValue: 1, bitMask: 2, readOnly: false, labelText: 'Relay 2' },
+                        Empty: { type: 'TreeNode', value: {} },
+                    },
+                },
+                // children without offsetSharedMemory are no process values
+                Info: { labelText: 'Info' },
+                Name: { offsetSharedMemory: 20, type: 'String', sizeValue: 32, readOnly: false, labelText: 'Name' },
+            },
+        };
+    });
+
+    it('should index the process values in the order of the tree', function () {
+        const index = new ProcessDescriptionIndex(this.processDescription);
+
+        expect(index.length).to.equal(4);
+        expect(index.paths).to.deep.equal(['Temperature', 'Outputs/Relay1', 'Outputs/Relay2', 'Name']);
+        expect(index.types).to.deep.equal(['Double', 'Bit', 'Bit', 'String']);
+        expect(index.processDescription).to.equal(this.processDescription);
+        expect(index.valueDescriptions[1]).to.equal(this.processDescription.value.Outputs.value.Relay1);
+    });
+
+    it('should keep the layout of the process values as struct of arrays', function () {
+        const index = new ProcessDescriptionIndex(this.processDescription);
+
+        expect([...index.offsets]).to.deep.equal([0, 16, 16, 20]);
+        expect([...index.sizes]).to.deep.equal([8, 1, 1, 32]);
+        expect([...index.bitMasks]).to.deep.equal([0, 1, 2, 0]);
+        // the metadata offset is absolute, 0 without metadata
+        expect([...index.metadataOffsets]).to.deep.equal([8, 0, 0, 0]);
+        expect([...index.metadataSizes]).to.deep.equal([4, 0, 0, 0]);
+    });
+
+    it('should look up the entry of a path', function () {
+        const index = new ProcessDescriptionIndex(this.processDescription);
+
+        expect(index.getEntry('Temperature')).to.equal(0);
+        expect(index.getEntry('Outputs/Relay2')).to.equal(2);
+        expect(index.getEntry('Name')).to.equal(3);
+    });
+
+    it('should throw if a path is not a process value', function () {
+        const index = new ProcessDescriptionIndex(this.processDescription);
+
+        expect(() => index.getEntry('Outputs')).to.throw('Parameter Outputs not found in process description');
+        expect(() => index.getEntry('Info')).to.throw('Parameter Info not found in process description');
+        expect(() => index.getEntry('Outputs/Relay3')).to.throw('Parameter Outputs/Relay3 not found in process description');
+        expect(() => index.getEntry('constructor')).to.throw('Parameter constructor not found in process description');
+    });
+
+    it('should index a description without process values', function () {
+        const index = new ProcessDescriptionIndex({ type: 'TreeNode', value: {} });
+
+        expect(index.length).to.equal(0);
+        expect(() => index.getEntry('')).to.throw();
+    });
+});
+
+describe('getProcessDescriptionIndex function', function () {
+    it('should build the index once per process description', function () {
+        const processDescription = { type: 'TreeNode', value: { Value: { offsetSharedMemory: 4, type: 'Integer', sizeValue: 4 } } };
+        const otherDescription = { type: 'TreeNode', value: { Value: { offsetSharedMemory: 8, type: 'Integer', sizeValue: 4 } } };
+
+        const index = getProcessDescriptionIndex(processDescription);
+
+        expect(index).to.be.instanceOf(ProcessDescriptionIndex);
+        expect(getProcessDescriptionIndex(processDescription)).to.equal(index);
+        expect(getProcessDescriptionIndex(otherDescription)).to.not.equal(index);
+        expect(getProcessDescriptionIndex(otherDescription).offsets[0]).to.equal(8);
+    });
+});
@@ -0,0 +1,207 @@
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { expect } from 'chai';
+import { readRecording } from '../src/recordingReader.js';
+
+// writes the raw bytes of a value like the process value providers do
+const rawValueWriters = {
+    UnsignedChar: (buf, value) => buf.writeUInt8(value),
+    Integer: (buf, value) => buf.writeInt32LE(value),
+    LongLong: (buf, value) => buf.writeBigInt64LE(value),
+    UnsignedLongLong: (buf, value) => buf.writeBigUInt64LE(value),
+    Double: (buf, value) => buf.writeDoubleLE(value),
+    Bit: (buf, value) => buf.writeUInt8(value),
+};
+
+function encodeZigZagVarint(difference) {
+    let value = BigInt.asUintN(64, (difference << 1n) ^ (difference >> 63n));
+    const bytes = [];
+    do {
+        const byte = Number(value & 0x7Fn);
+        value >>= 7n;
+        bytes.push(value > 0n ? byte | 0x80 : byte);
+    } while (value > 0n);
+    return Buffer.from(bytes);
+}
+
+// encodes a column like SharedMemoryRecorder::encodeColumn, the differences are taken of the zero extended raw bytes
+function encodeColumn(rawValues, deltaEncoded) {
+    if (!deltaEncoded) {
+        return Buffer.concat(rawValues);
+    }
+    let previous = 0n;
+    return Buffer.concat(rawValues.map(raw => {
+        const value = BigInt('0x' + (Buffer.from(raw).reverse().toString('hex') || '0'));
+        const difference = BigInt.asIntN(64, value - previous);
+        previous = value;
+        return encodeZigZagVarint(difference);
+    }));
+}
+
+function encodeRaw(type, width, value) {
+    const raw = Buffer.alloc(width);
+    rawValueWriters[type](raw, value);
+    return raw;
+}
+
+/**
+ * Encodes a recording with the layout of SharedMemoryRecorder.hpp.
+ */
+function encodeRecording({ periodNs = 1000000n, deltaEncoding = false, columns, blocks }) {
+    const fixedHeader = Buffer.alloc(24);
+    fixedHeader.write('VTRNREC1', 0, 'latin1');
+    fixedHeader.writeUInt32LE(deltaEncoding ? 1 : 0, 8);
+    fixedHeader.writeUInt32LE(columns.length, 12);
+    fixedHeader.writeBigUInt64LE(periodNs, 16);
+
+    const columnHeaders = columns.map(column => {
+        const columnHeader = Buffer.alloc(4);
+        columnHeader.writeUInt8(column.deltaEncoded ? 1 : 0, 0);
+        columnHeader.writeUInt8(column.bitMask || 0, 1);
+        columnHeader.writeUInt16LE(column.width, 2);
+        return columnHeader;
+    });
+
+    const info = Buffer.from(JSON.stringify({ columns: columns.map(({ selector, type, unit }) => ({ selector, type, unit })) }));
+    const infoLength = Buffer.alloc(4);
+    infoLength.writeUInt32LE(info.length);
+
+    const encodedBlocks = blocks.map(({ timestamps, values }) => {
+        const payload = Buffer.concat([
+            encodeColumn(timestamps.map(timestamp => encodeRaw('LongLong', 8, timestamp)), deltaEncoding),
+            ...columns.map((column, i) => encodeColumn(values[i].map(value => encodeRaw(column.type, column.width, value)), column.deltaEncoded)),
+        ]);
+        const blockHeader = Buffer.alloc(12);
+        blockHeader.write('VBLK', 0, 'latin1');
+        blockHeader.writeUInt32LE(timestamps.length, 4);
+        blockHeader.writeUInt32LE(payload.length, 8);
+        return Buffer.concat([blockHeader, payload]);
+    });
+
+    return Buffer.concat([fixedHeader, ...columnHeaders, infoLength, info, ...encodedBlocks]);
+}
+
+describe('readRecording function', function () {
+    beforeEach(function () {
+        this.directory = fs.mkdtempSync(path.join(os.tmpdir(), 'recordingReaderTest'));
+        this.file = path.join(this.directory, 'test.rec');
+    });
+
+    afterEach(function () {
+        fs.rmSync(this.directory, { recursive: true, force: true });
+    });
+
+    it('should read fixed-width columns', async function () {
+        fs.writeFileSync(this.file, encodeRecording({
+            columns: [
+                { selector: 'selector1', type: 'Integer', unit: '°C', width: 4 },
+                { selector: 'selector2', type: 'Double', unit: '', width: 8 },
+                { selector: 'selector3', type: 'Bit', unit: '', width: 1, bitMask: 0x04 },
+            ],
+            blocks: [{ timestamps: [1000n, 2000n, 3000n], values: [[1, -2, 2147483647], [0.5, -1.25, 1e300], [0x04, 0x03, 0xFF]] }],
+        }));
+
+        const recording = await readRecording(this.file);
+
+        expect(recording.periodNs).to.equal(1000000);
+        expect(recording.deltaEncoding).to.equal(false);
+        expect([...recording.timestamps]).to.deep.equal([1000n, 2000n, 3000n]);
+        expect(recording.columns).to.deep.equal([
+            { selector: 'selector1', type: 'Integer', unit: '°C', values: [1, -2, 2147483647] },
+            { selector: 'selector2', type: 'Double', unit: '', values: [0.5, -1.25, 1e300] },
+            { selector: 'selector3', type: 'Bit', unit: '', values: [true, false, true] },
+        ]);
+    });
+
+    it('should decode the zigzag varint differences of delta encoded columns', async function () {
+        const timestamps = [1700000000000000000n, 1700000000001000000n, 1700000000001999999n, 1700000000003000000n];
+        fs.writeFileSync(this.file, encodeRecording({
+            deltaEncoding: true,
+            columns: [
+                // negative values are sign extended by the decoder, their raw bytes are zero extended
+                { selector: 'selector1', type: 'Integer', unit: '', width: 4, deltaEncoded: true },
+                { selector: 'selector2', type: 'LongLong', unit: '', width: 8, deltaEncoded: true },
+                { selector: 'selector3', type: 'UnsignedLongLong', unit: '', width: 8, deltaEncoded: true },
+                { selector: 'selector4', type: 'UnsignedChar', unit: '', width: 1, deltaEncoded: true },
+                { selector: 'selector5', type: 'Double', unit: '', width: 8 },
+            ],
+            blocks: [{
+                timestamps,
+                values: [
+                    [10, -5, -2147483648, 2147483647],
+                    [-1n, 9223372036854775807n, -9223372036854775808n, 0n],
+                    [18446744073709551615n, 0n, 1n, 18446744073709551614n],
+                    [255, 0, 128, 127],
+                    [1.5, 2.5, 3.5, 4.5],
+                ],
+            }],
+        }));
+
+        const recording = await readRecording(this.file);
+
+        expect(recording.deltaEncoding).to.equal(true);
+        expect([...recording.timestamps]).to.deep.equal(timestamps);
+        expect(recording.columns.map(column => column.values)).to.deep.equal([
+            [10, -5, -2147483648, 2147483647],
+            [-1n, 9223372036854775807n, -9223372036854775808n, 0n],
+            [18446744073709551615n, 0n, 1n, 18446744073709551614n],
+            [255, 0, 128, 127],
+            [1.5, 2.5, 3.5, 4.5],
+        ]);
+    });
+
+    it('should restart the differences in each block', async function () {
+        fs.writeFileSync(this.file, encodeRecording({
+            deltaEncoding: true,
+            columns: [{ selector: 'selector1', type: 'Integer', unit: '', width: 4, deltaEncoded: true }],
+            blocks: [
+                { timestamps: [100n, 200n], values: [[1000, 1001]] },
+                { timestamps: [300n, 400n], values: [[-1000, 5]] },
+            ],
+        }));
+
+        const recording = await readRecording(this.file);
+
+        expect([...recording.timestamps]).to.deep.equal([100n, 200n, 300n, 400n]);
+        expect(recording.columns[0].values).to.deep.equal([1000, 1001, -1000, 5]);
+    });
+
+    it('should ignore a block that was cut off', async function () {
+        const content = encodeRecording({
+            columns: [{ selector: 'selector1', type: 'Integer', unit: '', width: 4 }],
+            blocks: [
+                { timestamps: [100n], values: [[1]] },
+                { timestamps: [200n, 300n], values: [[2, 3]] },
+            ],
+        });
+        fs.writeFileSync(this.file, content.subarray(0, content.length - 5));
+
+        const recording = await readRecording(this.file);
+
+        expect([...recording.timestamps]).to.deep.equal([100n]);
+        expect(recording.columns[0].values).to.deep.equal([1]);
+    });
+
+    it('should reject a file that is no recording', async function () {
+        fs.writeFileSync(this.file, 'no recording of process values');
+
+        const error = await readRecording(this.file).catch(e => e);
+
+        expect(error).to.be.instanceOf(Error);
+        expect(error.message).to.equal('File is no recording of process values');
+    });
+
+    it('should reject a recording with an invalid block', async function () {
+        const content = encodeRecording({
+            columns: [{ selector: 'selector1', type: 'Integer', unit: '', width: 4 }],
+            blocks: [{ timestamps: [100n], values: [[1]] }],
+        });
+        content.write('XBLK', content.length - 24, 'latin1');
+        fs.writeFileSync(this.file, content);
+
+        const error = await readRecording(this.file).catch(e => e);
+
+        expect(error.message).to.match(/^Invalid block at offset \d+ of recording$/);
+    });
+});
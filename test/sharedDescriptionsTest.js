@@ -0,0 +1,137 @@
+import * as td from 'testdouble';
+import { expect } from 'chai';
+
+/**
+ * Simulates the DescriptionRegistry of the process, every owner gets the native functions of its thread.
+ */
+function createRegistry() {
+    const entries = new Map();
+    const listeners = new Map();
+
+    const notify = (entry, key) => {
+        entry.waiters.forEach(owner => listeners.get(owner)?.(key));
+        entry.waiters.clear();
+    };
+    const getEntry = key => {
+        if (!entries.has(key)) {
+            entries.set(key, { description: undefined, claimedBy: undefined, waiters: new Set() });
+        }
+        return entries.get(key);
+    };
+
+    return {
+        createNative: owner => ({
+            setSharedDescriptionListener: listener => listeners.set(owner, listener),
+            getSharedDescription: key => entries.get(key)?.description,
+            claimSharedDescription: key => {
+                const entry = getEntry(key);
+                if (entry.description !== undefined) {
+                    return false;
+                }
+                if (entry.claimedBy !== undefined && entry.claimedBy !== owner) {
+                    entry.waiters.add(owner);
+                    return false;
+                }
+                entry.claimedBy = owner;
+                return true;
+            },
+            publishSharedDescription: (key, description) => {
+                const entry = getEntry(key);
+                entry.description = description;
+                entry.claimedBy = undefined;
+                notify(entry, key);
+            },
+            releaseSharedDescription: key => {
+                const entry = getEntry(key);
+                entry.claimedBy = undefined;
+                notify(entry, key);
+            },
+        }),
+    };
+}
+
+/**
+ * Imports the module for a thread, i.e. an owner of the registry.
+ */
+async function importThread(registry, owner) {
+    await td.replaceEsm('../src/importShm.js', { native: registry.createNative(owner) });
+    return import('../src/sharedDescriptions.js');
+}
+
+describe('loadSharedDescription function', function () {
+    const key = 'module1/instance1/object1/de';
+    const description = { type: 'TreeNode', key: 'Module1Instance1', value: { Value: { offsetSharedMemory: 0, type: 'Integer', sizeValue: 4 } } };
+
+    beforeEach(async function () {
+        this.registry = createRegistry();
+        this.mainThread = await importThread(this.registry, 'main');
+    });
+
+    afterEach(function () {
+        td.reset();
+    });
+
+    it('should publish a description loaded by the only thread, so a worker started later gets the shared copy', async function () {
+        const loadMain = td.func('loadMain');
+        td.when(loadMain()).thenResolve(description);
+
+        expect(await this.mainThread.loadSharedDescription(key, loadMain)).to.equal(description);
+
+        const worker = await importThread(this.registry, 'worker');
+        const loadWorker = td.func('loadWorker');
+        expect(await worker.loadSharedDescription(key, loadWorker)).to.deep.equal(description);
+        expect(td.explain(loadMain).callCount).to.equal(1);
+        expect(td.explain(loadWorker).callCount).to.equal(0);
+    });
+
+    it('should let a thread wait for the description claimed by another thread', async function () {
+        const worker = await importThread(this.registry, 'worker');
+        let finishLoad;
+        const loadMain = td.func('loadMain');
+        td.when(loadMain()).thenReturn(new Promise(resolve => { finishLoad = resolve; }));
+        const loadWorker = td.func('loadWorker');
+
+        const main = this.mainThread.loadSharedDescription(key, loadMain);
+        const waiting = worker.loadSharedDescription(key, loadWorker);
+        finishLoad(description);
+
+        expect(await main).to.equal(description);
+        expect(await waiting).to.deep.equal(description);
+        expect(td.explain(loadWorker).callCount).to.equal(0);
+    });
+
+    it('should release the claim if the load fails, so another thread takes over', async function () {
+        const worker = await importThread(this.registry, 'worker');
+        const loadMain = td.func('loadMain');
+        td.when(loadMain()).thenReject(new Error('D-Bus call failed'));
+        const loadWorker = td.func('loadWorker');
+        td.when(loadWorker()).thenResolve(description);
+
+        const error = await this.mainThread.loadSharedDescription(key, loadMain).catch(e => e);
+        expect(error.message).to.equal('D-Bus call failed');
+
+        expect(await worker.loadSharedDescription(key, loadWorker)).to.equal(description);
+        expect(td.explain(loadWorker).callCount).to.equal(1);
+    });
+});
+
+describe('updateSharedDescription function', function () {
+    beforeEach(async function () {
+        this.registry = createRegistry();
+        this.mainThread = await importThread(this.registry, 'main');
+    });
+
+    afterEach(function () {
+        td.reset();
+    });
+
+    it('should replace the shared description for the next load of another thread', async function () {
+        const updated = { type: 'TreeNode', value: {} };
+        await this.mainThread.loadSharedDescription('key1', () => Promise.resolve({ type: 'TreeNode', value: { Old: {} } }));
+
+        this.mainThread.updateSharedDescription('key1', updated);
+
+        const worker = await importThread(this.registry, 'worker');
+        expect(await worker.loadSharedDescription('key1', td.func('load'))).to.deep.equal(updated);
+    });
+});
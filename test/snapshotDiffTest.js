@@ -0,0 +1,120 @@
+import { expect } from 'chai';
+import { native } from '../src/importShm.js';
+
+// the block sizes of the implementations: scalar 8, SSE2 and NEON 16, AVX2 32 bytes
+const blockBoundaries = [8, 16, 32, 64];
+
+function createDescriptorTable(values) {
+    const stride = native.descriptorTableStride;
+    const table = new Int32Array(values.length * stride);
+    values.forEach(({ offset, type = 'UnsignedChar', size = 1, bitMask = 0, metadataOffset = 0, metadataSize = 0 }, i) => {
+        table.set([offset, native.valueTypes[type], size, bitMask, metadataOffset, metadataSize], i * stride);
+    });
+    return table;
+}
+
+function getRanges(previous, current) {
+    const { ranges } = native.diffSnapshots(previous, current, createDescriptorTable([]));
+    const pairs = [];
+    for (let i = 0; i < ranges.length; i += 2) {
+        pairs.push([ranges[i], ranges[i + 1]]);
+    }
+    return pairs;
+}
+
+function change(snapshot, ...positions) {
+    const changed = Buffer.from(snapshot);
+    positions.forEach(position => { changed[position] ^= 0xFF; });
+    return changed;
+}
+
+describe('diffSnapshots function', function () {
+    it('should report the whole snapshot and all values as changed without a previous snapshot', function () {
+        const current = Buffer.from([1, 2, 3, 4]);
+
+        const result = native.diffSnapshots(null, current, createDescriptorTable([{ offset: 0 }, { offset: 3 }]));
+
+        expect([...result.ranges]).to.deep.equal([0, 4]);
+        expect([...result.indices]).to.deep.equal([0, 1]);
+        expect(result.values).to.deep.equal([1, 4]);
+    });
+
+    it('should find no ranges in equal snapshots', function () {
+        const previous = Buffer.alloc(100, 7);
+
+        expect(getRanges(previous, Buffer.from(previous))).to.deep.equal([]);
+    });
+
+    it('should find a changed byte on both sides of every block boundary', function () {
+        const previous = Buffer.alloc(100);
+        for (const boundary of blockBoundaries) {
+            expect(getRanges(previous, change(previous, boundary - 1))).to.deep.equal([[boundary - 1, 1]]);
+            expect(getRanges(previous, change(previous, boundary))).to.deep.equal([[boundary, 1]]);
+        }
+    });
+
+    it('should merge the changed bytes across a block boundary into one range', function () {
+        const previous = Buffer.alloc(100);
+        for (const boundary of blockBoundaries) {
+            expect(getRanges(previous, change(previous, boundary - 2, boundary - 1, boundary, boundary + 1))).to.deep.equal([[boundary - 2, 4]]);
+        }
+        expect(getRanges(previous, Buffer.alloc(100, 1))).to.deep.equal([[0, 100]]);
+    });
+
+    it('should keep ranges apart that are separated by an unchanged byte', function () {
+        const previous = Buffer.alloc(100);
+
+        expect(getRanges(previous, change(previous, 0, 2, 31, 33, 99))).to.deep.equal([[0, 1], [2, 1], [31, 1], [33, 1], [99, 1]]);
+    });
+
+    it('should find the changes in the tail behind the last full block', function () {
+        // 37 bytes are one AVX2 block, two SSE2 blocks or four scalar blocks and a tail of 5 bytes
+        const previous = Buffer.alloc(37);
+        expect(getRanges(previous, change(previous, 32))).to.deep.equal([[32, 1]]);
+        expect(getRanges(previous, change(previous, 36))).to.deep.equal([[36, 1]]);
+        expect(getRanges(previous, change(previous, 31, 32, 33, 34, 35, 36))).to.deep.equal([[31, 6]]);
+
+        // shorter than any block
+        const short = Buffer.alloc(5);
+        expect(getRanges(short, change(short, 0, 4))).to.deep.equal([[0, 1], [4, 1]]);
+        expect(getRanges(Buffer.alloc(0), Buffer.alloc(0))).to.deep.equal([]);
+    });
+
+    it('should report only the values whose bytes or metadata intersect a changed range', function () {
+        const previous = Buffer.alloc(64);
+        const current = Buffer.from(previous);
+        current.set([1, 2, 3, 4], 16);
+        const values = [
+            { offset: 15 },
+            { offset: 16 },
+            { offset: 19 },
+            { offset: 20 },
+            { offset: 12, type: 'Integer', size: 4 },
+            { offset: 13, type: 'Integer', size: 4 },
+            { offset: 20, type: 'Integer', size: 4 },
+            { offset: 40, metadataOffset: 19, metadataSize: 4 },
+            { offset: 40, metadataOffset: 20, metadataSize: 4 },
+        ];
+
+        const result = native.diffSnapshots(previous, current, createDescriptorTable(values));
+
+        expect([...result.ranges]).to.deep.equal([16, 4]);
+        expect([...result.indices]).to.deep.equal([1, 2, 5, 7]);
+        expect(result.values.slice(0, 3)).to.deep.equal([1, 4, 0x01000000]);
+    });
+
+    it('should take the offsets of the values relative to the current buffer', function () {
+        const previous = Buffer.alloc(40);
+        const current = change(previous, 33);
+
+        const result = native.diffSnapshots(previous, current, createDescriptorTable([{ offset: 132 }, { offset: 133 }]), 100);
+
+        expect([...result.ranges]).to.deep.equal([33, 1]);
+        expect([...result.indices]).to.deep.equal([1]);
+        expect(result.values).to.deep.equal([0xFF]);
+    });
+
+    it('should throw if the snapshots have different lengths', function () {
+        expect(() => native.diffSnapshots(Buffer.alloc(8), Buffer.alloc(9), createDescriptorTable([]))).to.throw('The snapshots must have the same length');
+    });
+});
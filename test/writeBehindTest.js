@@ -0,0 +1,183 @@
+import * as td from 'testdouble';
+import { expect } from 'chai';
+
+describe('createWriteBehindQueue function', function () {
+    const memory1 = { name: 'memory1' };
+    const memory2 = { name: 'memory2' };
+    const target1 = { memory: memory1, valueDescription: { type: 'Int32' }, bufferStartAddress: 0 };
+    const target2 = { memory: memory1, valueDescription: { type: 'Double' }, bufferStartAddress: 0 };
+    const target3 = { memory: memory2, valueDescription: { type: 'Int32' }, bufferStartAddress: 8 };
+
+    beforeEach(async function () {
+        this.writeProcessValues = await td.replaceEsm('../src/writeProcessValues.js');
+        this.providerHandler = await td.replaceEsm('../src/providerHandler.js');
+
+        this.subject = await import('../src/writeBehind.js');
+
+        td.when(this.providerHandler.getProcessDataDescriptionGeneration()).thenReturn(1);
+        td.when(this.writeProcessValues.resolveWriteTarget('selector1')).thenResolve(target1);
+        td.when(this.writeProcessValues.resolveWriteTarget('selector2')).thenResolve(target2);
+        td.when(this.writeProcessValues.resolveWriteTarget('selector3')).thenResolve(target3);
+        td.when(this.writeProcessValues.validateValue(td.matchers.anything(), 'invalid')).thenThrow(new Error('value is not a number'));
+        td.when(this.writeProcessValues.writeTargetsAsync(td.matchers.anything(), td.matchers.anything())).thenResolve();
+    });
+
+    afterEach(function () {
+        td.reset();
+    });
+
+    it('should throw if windowMs is not a non-negative number', function () {
+        expect(() => this.subject.createWriteBehindQueue({ windowMs: -1 })).to.throw('windowMs is not a non-negative number');
+        expect(() => this.subject.createWriteBehindQueue({ windowMs: '20' })).to.throw('windowMs is not a non-negative number');
+    });
+
+    it('should coalesce the writes of a selector and write each shared memory once', async function () {
+        const queue = this.subject.createWriteBehindQueue();
+
+        const results = Promise.all([
+            queue.write('selector1', 1),
+            queue.write('selector1', 2),
+            queue.write('selector2', 3.5),
+            queue.write('selector3', 4),
+        ]);
+        await queue.flush();
+
+        expect(await results).to.deep.equal([{ done: true }, { done: true }, { done: true }, { done: true }]);
+        const calls = td.explain(this.writeProcessValues.writeTargetsAsync).calls.map(call => call.args);
+        expect(calls).to.deep.equal([
+            [memory1, [{ ...target1, value: 2 }, { ...target2, value: 3.5 }]],
+            [memory2, [{ ...target3, value: 4 }]],
+        ]);
+    });
+
+    it('should write after the window without a flush', async function () {
+        const queue = this.subject.createWriteBehindQueue({ windowMs: 5 });
+
+        expect(await queue.write('selector1', 1)).to.deep.equal({ done: true });
+        td.verify(this.writeProcessValues.writeTargetsAsync(memory1, [{ ...target1, value: 1 }]));
+    });
+
+    it('should write on the event loop thread if offThread is false', async function () {
+        const queue = this.subject.createWriteBehindQueue({ offThread: false });
+
+        const result = queue.write('selector1', 1);
+        await queue.flush();
+
+        expect(await result).to.deep.equal({ done: true });
+        td.verify(this.writeProcessValues.writeTargets(memory1, [{ ...target1, value: 1 }]));
+        expect(td.explain(this.writeProcessValues.writeTargetsAsync).callCount).to.equal(0);
+    });
+
+    it('should resolve a selector only once', async function () {
+        const queue = this.subject.createWriteBehindQueue();
+
+        const first = queue.write('selector1', 1);
+        await queue.flush();
+        const second = queue.write('selector1', 2);
+        await queue.flush();
+
+        await Promise.all([first, second]);
+        expect(td.explain(this.writeProcessValues.resolveWriteTarget).callCount).to.equal(1);
+    });
+
+    it('should serialize the flushes, so an older value never overwrites a newer one', async function () {
+        const queue = this.subject.createWriteBehindQueue();
+        const written = [];
+        let finishFirstWrite;
+        td.when(this.writeProcessValues.writeTargetsAsync(memory1, td.matchers.anything())).thenDo((memory, targets) => {
+            written.push(targets[0].value);
+            return written.length === 1 ? new Promise(resolve => { finishFirstWrite = resolve; }) : Promise.resolve();
+        });
+
+        const first = queue.write('selector1', 1);
+        const firstFlush = queue.flush();
+        await new Promise(resolve => setImmediate(resolve));
+        const second = queue.write('selector1', 2);
+        const secondFlush = queue.flush();
+        await new Promise(resolve => setImmediate(resolve));
+
+        // the second flush waits for the write of the first one
+        expect(written).to.deep.equal([1]);
+        finishFirstWrite();
+        await Promise.all([firstFlush, secondFlush, first, second]);
+        expect(written).to.deep.equal([1, 2]);
+    });
+
+    it('should reject only the caller of an invalid value of an unresolved selector', async function () {
+        const queue = this.subject.createWriteBehindQueue();
+
+        const valid = queue.write('selector1', 1);
+        const invalid = queue.write('selector1', 'invalid');
+        await queue.flush();
+
+        expect(await valid).to.deep.equal({ done: true });
+        const error = await invalid.catch(e => e);
+        expect(error).to.be.instanceOf(Error);
+        expect(error.message).to.include('value is not a number');
+        // the invalid value doesn't replace the valid one
+        td.verify(this.writeProcessValues.writeTargetsAsync(memory1, [{ ...target1, value: 1 }]));
+    });
+
+    it('should reject an invalid value of a resolved selector immediately', async function () {
+        const queue = this.subject.createWriteBehindQueue();
+        const first = queue.write('selector1', 1);
+        await queue.flush();
+        await first;
+
+        const queued = queue.write('selector1', 2);
+        const error = await queue.write('selector1', 'invalid').catch(e => e);
+
+        expect(error.message).to.include('value is not a number');
+        expect(td.explain(this.writeProcessValues.writeTargetsAsync).callCount).to.equal(1);
+        await queue.flush();
+        expect(await queued).to.deep.equal({ done: true });
+        td.verify(this.writeProcessValues.writeTargetsAsync(memory1, [{ ...target1, value: 2 }]));
+    });
+
+    it('should reject the writes of a selector that can\'t be resolved', async function () {
+        td.when(this.writeProcessValues.resolveWriteTarget('unknown')).thenReject(new Error('process value not found'));
+        const queue = this.subject.createWriteBehindQueue();
+
+        const unknown = queue.write('unknown', 1);
+        const known = queue.write('selector1', 1);
+        await queue.flush();
+
+        const error = await unknown.catch(e => e);
+        expect(error.message).to.include('process value not found');
+        expect(await known).to.deep.equal({ done: true });
+    });
+
+    it('should reject the writes of a shared memory that can\'t be written and keep the code of the error', async function () {
+        const lockTimeout = Object.assign(new Error('lock timeout'), { code: 'ERR_LOCK_TIMEOUT' });
+        td.when(this.writeProcessValues.writeTargetsAsync(memory1, td.matchers.anything())).thenReject(lockTimeout);
+        const queue = this.subject.createWriteBehindQueue();
+
+        const failed = queue.write('selector1', 1);
+        const written = queue.write('selector3', 2);
+        await queue.flush();
+
+        const error = await failed.catch(e => e);
+        expect(error.code).to.equal('ERR_LOCK_TIMEOUT');
+        expect(await written).to.deep.equal({ done: true });
+
+        // the selector is resolved again on the next write
+        const retry = queue.write('selector1', 3);
+        await queue.flush();
+        await retry.catch(() => { });
+        expect(td.explain(this.writeProcessValues.resolveWriteTarget).calls.filter(call => call.args[0] === 'selector1')).to.have.lengthOf(2);
+    });
+
+    it('should resolve the selectors again after a process description was fetched again', async function () {
+        const queue = this.subject.createWriteBehindQueue();
+        const first = queue.write('selector1', 1);
+        await queue.flush();
+        await first;
+
+        td.when(this.providerHandler.getProcessDataDescriptionGeneration()).thenReturn(2);
+        const second = queue.write('selector1', 2);
+        await queue.flush();
+        await second;
+
+        expect(td.explain(this.writeProcessValues.resolveWriteTarget).callCount).to.equal(2);
+    });
+});